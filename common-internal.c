@@ -25,3 +25,23 @@ void InitialiseCommon(StateCommon* const state, const ClownNemesis_InputCallback
 
 	state->throw_on_eof = cc_true;
 }
+
+unsigned long ClownNemesis_CRC32(unsigned long crc, const void* const bytes, const size_t size)
+{
+	const unsigned char* const bytes_unsigned = (const unsigned char*)bytes;
+	size_t i;
+
+	crc ^= 0xFFFFFFFF;
+
+	for (i = 0; i < size; ++i)
+	{
+		unsigned int bit;
+
+		crc ^= bytes_unsigned[i];
+
+		for (bit = 0; bit < 8; ++bit)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+
+	return crc ^ 0xFFFFFFFF;
+}
@@ -7,6 +7,17 @@
 
 #include "common.h"
 
+/* A rough model of how many cycles Sega's 68000 Nemesis decoder spends on each part of the data, */
+/* worked out from the instruction timings of its main loop. */
+#define DECODE_CYCLES_PER_BYTE 34         /* Reading a byte of compressed data into the bit buffer. */
+#define DECODE_CYCLES_PER_CODE 150        /* Looking up a code in the code table. */
+#define DECODE_CYCLES_PER_INLINE 160      /* Reading an inlined nybble run. */
+#define DECODE_CYCLES_PER_NYBBLE 44       /* Writing one nybble of a run. */
+#define DECODE_CYCLES_PER_ROW 50          /* Writing a row of 8 nybbles. */
+#define DECODE_CYCLES_PER_XOR_ROW 12      /* XORing a row with the previous one. */
+#define DECODE_CYCLES_PER_TABLE_ENTRY 100 /* Reading a code table entry. */
+#define DECODE_CYCLES_PER_TABLE_SLOT 18   /* Filling one of the 256 slots of the decoder's lookup table. */
+
 typedef struct StateCommon
 {
 	ClownNemesis_InputCallback read_byte;
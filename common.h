@@ -1,6 +1,8 @@
 #ifndef HEADER_GUARD_28ABC8E1_BE09_4B1B_8685_B7794936BF20
 #define HEADER_GUARD_28ABC8E1_BE09_4B1B_8685_B7794936BF20
 
+#include <stddef.h>
+
 /* Return codes for the below functions. */
 #define CLOWNNEMESIS_ERROR -1
 #define CLOWNNEMESIS_EOF -2
@@ -8,4 +10,8 @@
 typedef int (*ClownNemesis_InputCallback)(void *user_data);
 typedef int (*ClownNemesis_OutputCallback)(void *user_data, unsigned char byte);
 
+/* Returns the CRC-32 of data with the CRC-32 'crc' followed by more data, so that the CRC-32 of data can be computed in pieces. */
+/* Pass 0 as 'crc' for the first piece. This is the same CRC-32 as is used by Zip and PNG. */
+unsigned long ClownNemesis_CRC32(unsigned long crc, const void *bytes, size_t size);
+
 #endif /* HEADER_GUARD_28ABC8E1_BE09_4B1B_8685_B7794936BF20 */
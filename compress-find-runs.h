@@ -0,0 +1,68 @@
+/* This file is a template, which 'compress.c' includes once for each combination of run callback and XOR mode. */
+/* Having a separate copy of the run-finding loop for each combination avoids checking */
+/* whether XOR mode is enabled for every byte, and calling the callback through a pointer for every run. */
+/* Before including this file, these macros must be defined: */
+/* FIND_RUNS_NAME             - The name of the function to generate. */
+/* FIND_RUNS_CALLBACK         - The function which each run is passed to. */
+/* FIND_RUNS_XOR_MODE_ENABLED - 1 if the input should be read in XOR mode, or 0 if not. */
+
+static void FIND_RUNS_NAME(State* const state)
+{
+#if FIND_RUNS_XOR_MODE_ENABLED
+	unsigned char previous_row[4];
+#endif
+	unsigned int run_nybble, run_length;
+
+#if FIND_RUNS_XOR_MODE_ENABLED
+	memcpy(previous_row, state->initial_previous_row, sizeof(previous_row));
+#endif
+
+	run_nybble = run_length = 0;
+
+	for (state->bytes_read = 0; ; ++state->bytes_read)
+	{
+		const int value = ReadByte(&state->common);
+		unsigned int byte, i;
+
+		if (value == CLOWNNEMESIS_EOF)
+			break;
+
+		if (state->bytes_read == UINT_MAX)
+		{
+		#ifdef CLOWNNEMESIS_DEBUG
+			fputs("Input data is too large.\n", stderr);
+		#endif
+			longjmp(state->common.jump_buffer, 1);
+		}
+
+	#if FIND_RUNS_XOR_MODE_ENABLED
+		byte = value ^ previous_row[state->bytes_read % CC_COUNT_OF(previous_row)];
+		previous_row[state->bytes_read % CC_COUNT_OF(previous_row)] = value;
+	#else
+		byte = value;
+	#endif
+
+		for (i = 0; i < 2; ++i)
+		{
+			const unsigned int nybble = (byte >> 4) & 0xF;
+
+			byte <<= 4;
+
+			if (run_length != 0 && (run_length == MAXIMUM_RUN_LENGTH || nybble != run_nybble))
+			{
+				FIND_RUNS_CALLBACK(state, run_nybble, run_length);
+				run_length = 0;
+			}
+
+			run_nybble = nybble;
+			++run_length;
+		}
+	}
+
+	if (run_length != 0)
+		FIND_RUNS_CALLBACK(state, run_nybble, run_length);
+}
+
+#undef FIND_RUNS_NAME
+#undef FIND_RUNS_CALLBACK
+#undef FIND_RUNS_XOR_MODE_ENABLED
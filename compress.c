@@ -3,6 +3,7 @@
 #include <assert.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef CLOWNNEMESIS_DEBUG
 #include <stdio.h>
@@ -11,6 +12,7 @@
 #include "clowncommon/clowncommon.h"
 
 #include "common-internal.h"
+#include "decompress.h"
 
 #define MAXIMUM_RUN_NYBBLE 0x10
 #define MAXIMUM_RUN_LENGTH 8
@@ -18,30 +20,22 @@
 #define TOTAL_SYMBOLS (MAXIMUM_RUN_NYBBLE * MAXIMUM_RUN_LENGTH)
 #define MAXIMUM_BITS 8
 
-typedef unsigned char NybbleRunsIndex[TOTAL_SYMBOLS];
+#define BYTES_PER_TILE 0x20
+/* When sampling, only one in this many tiles is counted. */
+#define SAMPLED_TILE_INTERVAL 4
 
-typedef struct InternalBufferIndices
-{
-	unsigned int read_index, write_index;
-} InternalBufferIndices;
+/* The code space is measured in units of the space used by a code of the maximum length. */
+/* Codes that begin with 111111 are reserved for inlined nybble runs. */
+#define CODE_SPACE_USED(total_code_bits) (1u << (MAXIMUM_BITS - (total_code_bits)))
+#define AVAILABLE_CODE_SPACE (CODE_SPACE_USED(0) - CODE_SPACE_USED(6))
 
-typedef struct Node
-{
-	cc_bool is_leaf;
-	unsigned int occurrences;
+typedef unsigned char NybbleRunsIndex[TOTAL_SYMBOLS];
 
-	union
-	{
-		struct
-		{
-			unsigned short left_child, right_child;
-		} internal;
-		struct
-		{
-			struct NybbleRun *nybble_run;
-		} leaf;
-	} shared;
-} Node;
+typedef struct RunFinder
+{
+	unsigned char nybble;
+	unsigned char length;
+} RunFinder;
 
 typedef struct NybbleRun
 {
@@ -50,11 +44,29 @@ typedef struct NybbleRun
 	unsigned char total_code_bits;
 } NybbleRun;
 
+typedef struct RecompressionSource
+{
+	/* The runs of the data being recompressed, in the mode that it was compressed in, as the run-finding loop would find them. */
+	/* Each run is a byte, with its length minus one in the upper nybble, and its nybble in the lower nybble. */
+	unsigned char *runs;
+	size_t total_runs, capacity;
+	unsigned long total_nybbles;
+	cc_bool xor_mode_enabled;
+
+	/* How far 'ReadRecompressionSource' has got through the runs, turning them back into bytes. */
+	size_t run_index;
+	unsigned int run_nybbles_remaining;
+	unsigned long row, previous_row;
+	unsigned int row_bytes_remaining;
+} RecompressionSource;
+
 typedef struct State
 {
 	StateCommon common;
 
 	NybbleRun nybble_runs[MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH];
+	/* The occurrences of each nybble run in regular mode and XOR mode, for when both are counted at once. */
+	unsigned int histograms[2][MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH];
 	union
 	{
 		struct
@@ -65,12 +77,16 @@ typedef struct State
 		} fano;
 		struct
 		{
-			/* Contains the leaf nodes (size: TOTAL_SYMBOLS), and two queues for the internal nodes (size: TOTAL_SYMBOLS * MAXIMUM_BITS). */
-			Node node_pool[TOTAL_SYMBOLS + TOTAL_SYMBOLS * MAXIMUM_BITS * 2];
-			unsigned int leaf_read_index;
-			InternalBufferIndices internal[2];
-			unsigned char internal_buffer_flip_flop;
-		} huffman;
+			/* For each nybble, the cheapest cost of its runs when they use exactly a given amount of the code space. */
+			unsigned int nybble_costs[MAXIMUM_RUN_NYBBLE][AVAILABLE_CODE_SPACE + 1];
+			/* For each nybble run and amount of code space, the code length that was chosen for it (0 if it is inlined). */
+			unsigned char chosen_code_lengths[MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH][AVAILABLE_CODE_SPACE + 1];
+			/* For each nybble and amount of code space, how much of that code space was given to the nybble's runs. */
+			unsigned char chosen_nybble_spaces[MAXIMUM_RUN_NYBBLE][AVAILABLE_CODE_SPACE + 1];
+			unsigned int total_costs[AVAILABLE_CODE_SPACE + 1];
+			unsigned int new_costs[AVAILABLE_CODE_SPACE + 1];
+			unsigned char frontier[AVAILABLE_CODE_SPACE + 1];
+		} optimal;
 	} generator;
 
 	unsigned int total_runs;
@@ -79,59 +95,107 @@ typedef struct State
 
 	unsigned char previous_nybble;
 
-	unsigned char input_byte_buffer[4];
-	unsigned char input_byte_buffer_index;
-	unsigned char input_nybble_buffer;
-	unsigned char nybble_reader_flip_flop;
-
-	unsigned char output_byte_buffer;
+	/* Holds the bits that have not yet been written, in its lowest 'output_bits_done' bits. */
+	unsigned long output_bit_buffer;
 	unsigned char output_bits_done;
 
+	/* How many more bytes can be written before the data is over the budget of 'ClownNemesis_CompressOptions'. */
+	unsigned long output_bytes_remaining;
+	cc_bool over_budget;
+
+	void (*parsed_run_callback)(struct State *state, unsigned int run_nybble, unsigned int run_length);
+	unsigned long stretch_length;
+	unsigned char stretch_nybble;
+
+	struct
+	{
+		NybbleRun best_nybble_runs[MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH];
+		NybbleRun size_nybble_runs[MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH];
+		unsigned long best_total_cost;
+		cc_bool best_xor_mode_enabled;
+		unsigned int parsed_occurrences[MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH];
+	} ultra;
+
+	/* When recompressing, the runs of the data, which are used instead of reading the input when it is in the same mode. */
+	const RecompressionSource *recompression_source;
+	/* The runs of the data in both modes, when they have already been counted, such as by separate threads. */
+	const ClownNemesis_TrainingHistogram *known_histogram;
+
 	cc_bool xor_mode_enabled;
+	/* The row before the input data, which XOR mode starts from. This is only not zero when a session emits some of its tiles. */
+	unsigned char initial_previous_row[4];
+	/* How much a cycle of decoding costs, relative to a bit of data. See 'ClownNemesis_CompressOptions'. */
+	unsigned int decode_cycle_weight;
+	/* How many times the code table is paid for, as a shared code table is stored in every file that uses it. */
+	unsigned int table_cost_weight;
 } State;
 
+struct ClownNemesis_Compressor
+{
+	State state;
+};
+
 /* TODO: Just replace this with using direct pointers. */
 static NybbleRun* NybbleRunFromIndex(State* const state, const unsigned int index)
 {
 	return &state->nybble_runs[index % CC_COUNT_OF(state->nybble_runs)][index / CC_COUNT_OF(state->nybble_runs)];
 }
 
-static cc_bool ComparisonOccurrence(const NybbleRun* const nybble_run_1, const NybbleRun* const nybble_run_2)
+static void CountsToBucketStarts(unsigned int* const buckets, const unsigned int total_buckets)
 {
-	return nybble_run_1->occurrences > nybble_run_2->occurrences;
+	unsigned int total;
+	unsigned int i;
+
+	/* Turn the bucket sizes into the indices of the buckets' first entries. */
+	total = 0;
+
+	for (i = 0; i < total_buckets; ++i)
+	{
+		const unsigned int bucket_size = buckets[i];
+
+		buckets[i] = total;
+		total += bucket_size;
+	}
 }
 
-static void ComputeSortedRuns(State* const state, NybbleRunsIndex runs_reordered, cc_bool (*comparison)(const NybbleRun *nybble_run_1, const NybbleRun *nybble_run_2))
+static void ComputeSortedRuns(State* const state, NybbleRunsIndex runs_reordered)
 {
+	NybbleRunsIndex scratch;
+	unsigned int maximum_occurrences;
+	unsigned int shift;
 	unsigned int i;
-	cc_bool not_done;
 
 	for (i = 0; i < TOTAL_SYMBOLS; ++i)
 		runs_reordered[i] = i;
 
+	maximum_occurrences = 0;
+
+	for (i = 0; i < TOTAL_SYMBOLS; ++i)
+		maximum_occurrences = CC_MAX(maximum_occurrences, NybbleRunFromIndex(state, i)->occurrences);
+
 	/* Sort from most occurring to least occurring. */
 	/* This needs to be a stable sorting algorithm so that the Fano algorithm matches Sega's compressor. */
 	/* TODO: Did Sega's compressor actually use a stable sort? */
-	/* TODO: Anything better than bubblesort. */
-	do
+	/* This is an LSD radix sort, which is stable, and skips the passes for bytes which are always zero. */
+	for (shift = 0; shift < sizeof(maximum_occurrences) * CHAR_BIT && (maximum_occurrences >> shift) != 0; shift += 8)
 	{
-		not_done = cc_false;
+		unsigned int bucket_starts[0x100];
 
-		for (i = 1; i < TOTAL_SYMBOLS; ++i)
-		{
-			const NybbleRun* const previous_nybble_run = NybbleRunFromIndex(state, runs_reordered[i - 1]);
-			const NybbleRun* const nybble_run = NybbleRunFromIndex(state, runs_reordered[i]);
+		for (i = 0; i < CC_COUNT_OF(bucket_starts); ++i)
+			bucket_starts[i] = 0;
 
-			if (comparison(nybble_run, previous_nybble_run))
-			{
-				const unsigned int temp = runs_reordered[i - 1];
-				runs_reordered[i - 1] = runs_reordered[i];
-				runs_reordered[i] = temp;
-				not_done = cc_true;
-			}
-		}
+		/* The buckets are ordered from the highest byte value to the lowest, to make the sort descending. */
+		for (i = 0; i < TOTAL_SYMBOLS; ++i)
+			++bucket_starts[0xFF - ((NybbleRunFromIndex(state, runs_reordered[i])->occurrences >> shift) & 0xFF)];
+
+		CountsToBucketStarts(bucket_starts, CC_COUNT_OF(bucket_starts));
+
+		for (i = 0; i < TOTAL_SYMBOLS; ++i)
+			scratch[bucket_starts[0xFF - ((NybbleRunFromIndex(state, runs_reordered[i])->occurrences >> shift) & 0xFF)]++] = runs_reordered[i];
+
+		for (i = 0; i < TOTAL_SYMBOLS; ++i)
+			runs_reordered[i] = scratch[i];
 	}
-	while (not_done);
 }
 
 static void IterateNybbleRuns(State* const state, void (* const callback)(State *state, unsigned int run_nybble, unsigned int run_length_minus_one))
@@ -169,7 +233,7 @@ static void SumTotalBits(State* const state, const unsigned int run_nybble, cons
 		}
 
 		/* The code table entry uses either 16 bits or 24 bits depending on whether it's the first with its nybble. */
-		state->total_bits += is_the_first ? 24 : 16;
+		state->total_bits += (is_the_first ? 24 : 16) * state->table_cost_weight;
 		state->total_bits += nybble_run->total_code_bits * nybble_run->occurrences;
 	}
 	else
@@ -185,6 +249,29 @@ static void ComputeTotalEncodedBits(State* const state)
 	IterateNybbleRuns(state, SumTotalBits);
 }
 
+static unsigned long ComputeCompressedSize(const unsigned long total_bits, const cc_bool accurate)
+{
+	/* The header, the code table's terminator, and then the code table and codes. */
+	/* Sega's compressor always emits a final byte, even when the codes end on a byte boundary. */
+	return 2 + 1 + (accurate ? total_bits / 8 + 1 : CC_DIVIDE_CEILING(total_bits, 8));
+}
+
+static void RejectOverBudget(State* const state)
+{
+#ifdef CLOWNNEMESIS_DEBUG
+	fputs("Compressed data is over the budget.\n", stderr);
+#endif
+	state->over_budget = cc_true;
+	longjmp(state->common.jump_buffer, 1);
+}
+
+static void CheckBudget(State* const state, const unsigned long total_bytes)
+{
+	/* Used when the size of the data is known before it is emitted, to avoid the work of emitting it only to give up. */
+	if (total_bytes > state->output_bytes_remaining)
+		RejectOverBudget(state);
+}
+
 /***************/
 /* Fano Coding */
 /***************/
@@ -287,9 +374,43 @@ static void DoSplit(State* const state, const unsigned int starting_sorted_nybbl
 	}
 }
 
+static unsigned int FanoSortKey(const NybbleRun* const nybble_run)
+{
+	/* Runs without a code are sorted after all of the others. */
+	assert(nybble_run->total_code_bits <= MAXIMUM_BITS);
+	return nybble_run->total_code_bits == 0 ? MAXIMUM_BITS + 1 : nybble_run->total_code_bits;
+}
+
+static void SetPositionBit(unsigned long* const positions, const unsigned int position, const cc_bool set)
+{
+	if (set)
+		positions[position / 32] |= 1ul << (position % 32);
+	else
+		positions[position / 32] &= ~(1ul << (position % 32));
+}
+
+static unsigned int LowestPosition(const unsigned long* const positions)
+{
+	unsigned int i;
+
+	for (i = 0; i < TOTAL_SYMBOLS / 32; ++i)
+	{
+		if ((positions[i] & 0xFFFFFFFF) != 0)
+		{
+			unsigned int j;
+
+			for (j = 0; (positions[i] & 1ul << j) == 0; ++j);
+
+			return i * 32 + j;
+		}
+	}
+
+	return TOTAL_SYMBOLS;
+}
+
 static void ComputeCodesFano(State* const state)
 {
-	ComputeSortedRuns(state, state->generator.fano.nybble_runs_sorted, ComparisonOccurrence);
+	ComputeSortedRuns(state, state->generator.fano.nybble_runs_sorted);
 
 	state->generator.fano.code = 0;
 	state->generator.fano.total_code_bits = 0;
@@ -298,34 +419,43 @@ static void ComputeCodesFano(State* const state)
 	/* As an optimisation, the computed codes are sorted by their nybble runs' occurrences. This assigns the shorter codes to the more-common nybble runs. */
 	/* Sega's compressor did the same thing. */
 	{
+	/* The positions of the codes in the sorted list, bucketed by their lengths. */
+	unsigned long positions_by_key[MAXIMUM_BITS + 2][TOTAL_SYMBOLS / 32];
 	unsigned int i;
 
+	for (i = 0; i < CC_COUNT_OF(positions_by_key); ++i)
+	{
+		unsigned int j;
+
+		for (j = 0; j < CC_COUNT_OF(positions_by_key[i]); ++j)
+			positions_by_key[i][j] = 0;
+	}
+
+	for (i = 0; i < TOTAL_SYMBOLS; ++i)
+		SetPositionBit(positions_by_key[FanoSortKey(NybbleRunFromIndex(state, state->generator.fano.nybble_runs_sorted[i]))], i, cc_true);
+
 	/* Sort from most occurring to least occurring. */
-	/* In order to match Sega's compressor, we use a Selection Sort here. */
+	/* In order to match Sega's compressor, this must produce the same order as a Selection Sort (which is not stable). */
+	/* Rather than scanning the remainder of the list for every position, the first code of the smallest length is found using the buckets. */
 	for (i = 0; i < TOTAL_SYMBOLS - 1; ++i)
 	{
-		unsigned int smallest_code_size;
+		unsigned int smallest_key;
 		unsigned int smallest_code_index;
-		unsigned int j;
 
 		NybbleRun* const nybble_run = NybbleRunFromIndex(state, state->generator.fano.nybble_runs_sorted[i]);
-		const unsigned int total_code_bits = nybble_run->total_code_bits == 0 ? UINT_MAX : nybble_run->total_code_bits;
+		const unsigned int key = FanoSortKey(nybble_run);
 
-		smallest_code_size = total_code_bits;
-		smallest_code_index = i;
-
-		for (j = i + 1; j < TOTAL_SYMBOLS; ++j)
+		for (smallest_key = 1; ; ++smallest_key)
 		{
-			NybbleRun* const later_nybble_run = NybbleRunFromIndex(state, state->generator.fano.nybble_runs_sorted[j]);
-			const unsigned int later_total_code_bits = later_nybble_run->total_code_bits == 0 ? UINT_MAX : later_nybble_run->total_code_bits;
+			smallest_code_index = LowestPosition(positions_by_key[smallest_key]);
 
-			if (later_total_code_bits < smallest_code_size)
-			{
-				smallest_code_size = later_total_code_bits;
-				smallest_code_index = j;
-			}
+			if (smallest_code_index != TOTAL_SYMBOLS)
+				break;
 		}
 
+		/* This position is now finalised. */
+		SetPositionBit(positions_by_key[smallest_key], smallest_code_index, cc_false);
+
 		if (smallest_code_index != i)
 		{
 			NybbleRun* const later_nybble_run = NybbleRunFromIndex(state, state->generator.fano.nybble_runs_sorted[smallest_code_index]);
@@ -336,6 +466,10 @@ static void ComputeCodesFano(State* const state)
 			later_nybble_run->total_code_bits = nybble_run->total_code_bits;
 			nybble_run->code = code;
 			nybble_run->total_code_bits = total_code_bits;
+
+			/* The code that was here has moved to where the smallest code was. */
+			SetPositionBit(positions_by_key[key], i, cc_false);
+			SetPositionBit(positions_by_key[key], smallest_code_index, cc_true);
 		}
 	}
 	}
@@ -346,186 +480,198 @@ static void ComputeCodesFano(State* const state)
 /**********************/
 
 /******************/
-/* Huffman Coding */
+/* Optimal Coding */
 /******************/
 
-/* https://en.wikipedia.org/wiki/Huffman_coding */
-/* https://en.wikipedia.org/wiki/Package-merge_algorithm */
-/* https://create.stephan-brumme.com/length-limited-prefix-codes/ */
-/* https://experiencestack.co/length-limited-huffman-codes-21971f021d43 */
+/* This finds the code lengths which produce the smallest data, including the cost of the code table, the cost of the runs
+   which are inlined instead of given a code, and the code space which is reserved for the inlined runs. */
+/* Since the costs of a code table entry depend on whether it is the first with its nybble, the nybble runs are grouped by
+   their nybbles: for each nybble, a knapsack-style dynamic programming algorithm finds the cheapest way to code its runs
+   using every possible amount of code space, and then the nybbles are combined in the same way. */
+/* https://en.wikipedia.org/wiki/Kraft%E2%80%93McMillan_inequality */
 
-static void CreateLeafNode(State* const state, const unsigned int run_nybble, const unsigned int run_length_minus_one)
+static unsigned int ComputeFrontier(const unsigned int* const costs, unsigned char* const frontier)
 {
-	Node* const node = &state->generator.huffman.node_pool[run_nybble * MAXIMUM_RUN_LENGTH + run_length_minus_one];
-	NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length_minus_one];
+	unsigned int total_frontier;
+	unsigned int space;
 
-	node->is_leaf = cc_true;
-	node->occurrences = nybble_run->occurrences;
-	node->shared.leaf.nybble_run = nybble_run;
-}
+	/* Only the amounts of code space that are cheaper than every smaller amount are worth considering: if using more code
+	   space does not make something cheaper, then it is always better to use less and leave the rest to something else. */
+	total_frontier = 0;
 
-static int CompareNodes(const void* const a, const void* const b)
-{
-	const Node* const node_a = (const Node*)a;
-	const Node* const node_b = (const Node*)b;
+	for (space = 0; space <= AVAILABLE_CODE_SPACE; ++space)
+		if (costs[space] != UINT_MAX && (total_frontier == 0 || costs[space] < costs[frontier[total_frontier - 1]]))
+			frontier[total_frontier++] = space;
 
-	return node_a->occurrences - node_b->occurrences;
+	return total_frontier;
 }
 
-static unsigned int PopSmallestNode(State* const state)
+static void UpdateCost(unsigned int* const costs, unsigned char* const choices, const unsigned int space, const unsigned int cost, const unsigned int choice)
 {
-	InternalBufferIndices* const input_internal = &state->generator.huffman.internal[state->generator.huffman.internal_buffer_flip_flop];
-	const unsigned int leaf_nodes_available = TOTAL_SYMBOLS - state->generator.huffman.leaf_read_index;
-	const unsigned int internal_nodes_available = input_internal->write_index - input_internal->read_index;
-
-	if (leaf_nodes_available != 0 && internal_nodes_available != 0)
-	{
-		if (state->generator.huffman.node_pool[state->generator.huffman.leaf_read_index].occurrences <= state->generator.huffman.node_pool[input_internal->read_index].occurrences)
-			return state->generator.huffman.leaf_read_index++;
-		else
-			return input_internal->read_index++;
-	}
-	else if (leaf_nodes_available != 0)
-	{
-		return state->generator.huffman.leaf_read_index++;
-	}
-	else if (internal_nodes_available != 0)
-	{
-		return input_internal->read_index++;
-	}
-	else
+	if (cost < costs[space])
 	{
-		return -1;
+		costs[space] = cost;
+		choices[space] = choice;
 	}
 }
 
-static void ComputeTrees(State* const state)
+static void ComputeNybbleCosts(State* const state, const unsigned int run_nybble)
 {
-	unsigned int iterations_done;
+	const unsigned int table_cost_weight = state->table_cost_weight;
+	unsigned int* const costs = state->generator.optimal.nybble_costs[run_nybble];
+	unsigned int* const new_costs = state->generator.optimal.new_costs;
+	unsigned char* const frontier = state->generator.optimal.frontier;
+	unsigned int run_length_minus_one;
+	unsigned int space;
 
-	const unsigned int starting_leaf_node_index = state->generator.huffman.leaf_read_index;
+	/* Code space 0 means that no runs have codes yet. */
+	costs[0] = 0;
 
-	/* Welcome to Hell. */
-	/* This is the heart of the package-merge algorithm. */
-	state->generator.huffman.internal[0].read_index = state->generator.huffman.internal[0].write_index = TOTAL_SYMBOLS;
-	state->generator.huffman.internal[1].read_index = state->generator.huffman.internal[1].write_index = TOTAL_SYMBOLS + TOTAL_SYMBOLS * MAXIMUM_BITS;
+	for (space = 1; space <= AVAILABLE_CODE_SPACE; ++space)
+		costs[space] = UINT_MAX;
 
-	iterations_done = 0;
-
-	for (;;)
+	for (run_length_minus_one = 0; run_length_minus_one < MAXIMUM_RUN_LENGTH; ++run_length_minus_one)
 	{
-		InternalBufferIndices* const output_internal = &state->generator.huffman.internal[state->generator.huffman.internal_buffer_flip_flop ^ 1];
+		const unsigned int occurrences = state->nybble_runs[run_nybble][run_length_minus_one].occurrences;
+		unsigned char* const chosen_code_lengths = state->generator.optimal.chosen_code_lengths[run_nybble][run_length_minus_one];
+		unsigned int total_frontier;
+		unsigned int i;
+
+		/* Runs that never occur are never worth a code table entry. */
+		if (occurrences == 0)
+		{
+			for (space = 0; space <= AVAILABLE_CODE_SPACE; ++space)
+				chosen_code_lengths[space] = 0;
+
+			continue;
+		}
 
-		const unsigned int right_child = PopSmallestNode(state);
-		const unsigned int left_child = PopSmallestNode(state);
+		total_frontier = ComputeFrontier(costs, frontier);
 
-		if (left_child == (unsigned int)-1 || right_child == (unsigned int)-1)
+		for (space = 0; space <= AVAILABLE_CODE_SPACE; ++space)
+			new_costs[space] = UINT_MAX;
+
+		for (i = 0; i < total_frontier; ++i)
 		{
-			state->generator.huffman.leaf_read_index = starting_leaf_node_index;
+			unsigned int total_code_bits;
 
-			state->generator.huffman.internal_buffer_flip_flop ^= 1;
+			const unsigned int previous_space = frontier[i];
+			const unsigned int previous_cost = costs[previous_space];
 
-			if (++iterations_done == 7)
-				break;
+			/* An inlined nybble run costs 13 bits. */
+			UpdateCost(new_costs, chosen_code_lengths, previous_space, previous_cost + (6 + 3 + 4) * occurrences, 0);
 
-			continue;
+			/* Codes which are not shorter than an inlined run are never worth it, so stop there. */
+			/* A code table entry costs 16 bits (the extra 8 bits for the nybble are added later). */
+			for (total_code_bits = 1; total_code_bits <= MAXIMUM_BITS && 16 * table_cost_weight + total_code_bits * occurrences < (6 + 3 + 4) * occurrences; ++total_code_bits)
+				if (previous_space + CODE_SPACE_USED(total_code_bits) <= AVAILABLE_CODE_SPACE)
+					UpdateCost(new_costs, chosen_code_lengths, previous_space + CODE_SPACE_USED(total_code_bits), previous_cost + 16 * table_cost_weight + total_code_bits * occurrences, total_code_bits);
 		}
 
-		state->generator.huffman.node_pool[output_internal->write_index].is_leaf = cc_false;
-		state->generator.huffman.node_pool[output_internal->write_index].occurrences = state->generator.huffman.node_pool[left_child].occurrences + state->generator.huffman.node_pool[right_child].occurrences;
-		state->generator.huffman.node_pool[output_internal->write_index].shared.internal.left_child = left_child;
-		state->generator.huffman.node_pool[output_internal->write_index].shared.internal.right_child = right_child;
-		++output_internal->write_index;
+		for (space = 0; space <= AVAILABLE_CODE_SPACE; ++space)
+			costs[space] = new_costs[space];
 	}
+
+	/* The first code table entry with this nybble costs an extra 8 bits. */
+	for (space = 1; space <= AVAILABLE_CODE_SPACE; ++space)
+		if (costs[space] != UINT_MAX)
+			costs[space] += 8 * table_cost_weight;
 }
 
-static void ResetCodeLength(State* const state, const unsigned int run_nybble, const unsigned int run_length_minus_one)
+static void ComputeOptimalCodeLengths(State* const state)
 {
-	NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length_minus_one];
+	unsigned int run_nybble;
+	unsigned int space, best_space;
 
-	nybble_run->total_code_bits = 0;
-}
+	unsigned int* const total_costs = state->generator.optimal.total_costs;
+	unsigned int* const new_costs = state->generator.optimal.new_costs;
+	unsigned char* const frontier = state->generator.optimal.frontier;
 
-static void RecurseNode(State* const state, const Node* const node)
-{
-	if (node->is_leaf)
-	{
-		++node->shared.leaf.nybble_run->total_code_bits;
-	}
-	else
+	total_costs[0] = 0;
+
+	for (space = 1; space <= AVAILABLE_CODE_SPACE; ++space)
+		total_costs[space] = UINT_MAX;
+
+	/* Combine the nybbles, finding the cheapest way of dividing the code space between them. */
+	for (run_nybble = 0; run_nybble < MAXIMUM_RUN_NYBBLE; ++run_nybble)
 	{
-		RecurseNode(state, &state->generator.huffman.node_pool[node->shared.internal.left_child]);
-		RecurseNode(state, &state->generator.huffman.node_pool[node->shared.internal.right_child]);
-	}
-}
+		const unsigned int* const nybble_costs = state->generator.optimal.nybble_costs[run_nybble];
+		unsigned char* const chosen_nybble_spaces = state->generator.optimal.chosen_nybble_spaces[run_nybble];
+		unsigned char nybble_frontier[AVAILABLE_CODE_SPACE + 1];
+		unsigned int total_frontier, total_nybble_frontier;
+		unsigned int i;
 
-static void ComputeCodeLengths(State* const state)
-{
-	unsigned int i;
+		ComputeNybbleCosts(state, run_nybble);
 
-	InternalBufferIndices* const internal_buffer = &state->generator.huffman.internal[state->generator.huffman.internal_buffer_flip_flop];
+		total_frontier = ComputeFrontier(total_costs, frontier);
+		total_nybble_frontier = ComputeFrontier(nybble_costs, nybble_frontier);
 
-	/* Reset the code lengths to 0, just in case. */
-	IterateNybbleRuns(state, ResetCodeLength);
+		for (space = 0; space <= AVAILABLE_CODE_SPACE; ++space)
+			new_costs[space] = UINT_MAX;
 
-	/* Recurse through the generated trees and increment the code length of each leaf encountered. */
-	for (i = internal_buffer->read_index; i < internal_buffer->write_index; ++i)
-		RecurseNode(state, &state->generator.huffman.node_pool[i]);
+		for (i = 0; i < total_frontier; ++i)
+		{
+			unsigned int j;
 
-	/* I wish I knew why this is necessary, but I don't. Without this, data with few unique nybble runs will be entirely inlined. */
-	/* TODO: Figure out what is going on here. */
-	for (i = state->generator.huffman.leaf_read_index; i < TOTAL_SYMBOLS; ++i)
-	{
-		NybbleRun* const nybble_run = state->generator.huffman.node_pool[i].shared.leaf.nybble_run;
+			for (j = 0; j < total_nybble_frontier && frontier[i] + nybble_frontier[j] <= AVAILABLE_CODE_SPACE; ++j)
+				UpdateCost(new_costs, chosen_nybble_spaces, frontier[i] + nybble_frontier[j], total_costs[frontier[i]] + nybble_costs[nybble_frontier[j]], nybble_frontier[j]);
+		}
 
-		/* Without this check, codes will always be one bit too long. I have absolutely no fucking idea why. */
-		if (nybble_run->total_code_bits == 0)
-			++nybble_run->total_code_bits;
+		for (space = 0; space <= AVAILABLE_CODE_SPACE; ++space)
+			total_costs[space] = new_costs[space];
 	}
-}
 
-static void ComputeBestCodeLengths(State* const state)
-{
-	unsigned int best_starting_leaf_read_index;
-	unsigned int best_total_bits;
+	/* The code space does not have to be used entirely. */
+	best_space = 0;
 
-	/* Brute-force the optimal number of coded nybble runs. */
-	/* We do this because, the more coded nybble runs there are, the more likely it is that common nybble runs will be
-	   given longer codes, leading to larger compressed data, so it might be beneficial to use fewer coded nybble runs. */
-	best_starting_leaf_read_index = state->generator.huffman.leaf_read_index;
-	best_total_bits = (unsigned int)-1;
+	for (space = 1; space <= AVAILABLE_CODE_SPACE; ++space)
+		if (total_costs[space] < total_costs[best_space])
+			best_space = space;
 
-	/* Gradually ignore nybble runs, starting with the rarest ones. */
-	for (; state->generator.huffman.leaf_read_index < TOTAL_SYMBOLS - 1; ++state->generator.huffman.leaf_read_index)
+	/* Retrace the choices that led to the cheapest cost. */
+	for (run_nybble = MAXIMUM_RUN_NYBBLE; run_nybble-- != 0; )
 	{
-		ComputeTrees(state);
-		ComputeCodeLengths(state);
+		unsigned int run_length_minus_one;
+		unsigned int nybble_space;
 
-		/* Find out how many bits this number of coded nybble runs uses. */
-		ComputeTotalEncodedBits(state);
+		nybble_space = state->generator.optimal.chosen_nybble_spaces[run_nybble][best_space];
+		best_space -= nybble_space;
 
-		/* Track the number of coded nybble runs with the lowest number of bits. */
-		if (state->total_bits < best_total_bits)
+		for (run_length_minus_one = MAXIMUM_RUN_LENGTH; run_length_minus_one-- != 0; )
 		{
-			best_total_bits = state->total_bits;
-			best_starting_leaf_read_index = state->generator.huffman.leaf_read_index;
+			NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length_minus_one];
+
+			nybble_run->total_code_bits = state->generator.optimal.chosen_code_lengths[run_nybble][run_length_minus_one][nybble_space];
+
+			if (nybble_run->total_code_bits != 0)
+				nybble_space -= CODE_SPACE_USED(nybble_run->total_code_bits);
 		}
 	}
-
-	/* Now that we know the ideal number of coded nybble runs, use it to continue compression. */
-	state->generator.huffman.leaf_read_index = best_starting_leaf_read_index;
-	ComputeTrees(state);
-	ComputeCodeLengths(state);
 }
 
-static cc_bool ComparisonCodeTotalBits(const NybbleRun* const nybble_run_1, const NybbleRun* const nybble_run_2)
+static void SortRunsByCodeLength(State* const state, NybbleRunsIndex runs_reordered)
 {
-	/* Sort by total code bits first, and sort by occurrence second. */
-	/* We sort by occurrence so that the nybble runs that get bumped to 8 bits are the least common, costing the least space. */
-	if (nybble_run_1->total_code_bits == nybble_run_2->total_code_bits)
-		return nybble_run_1->occurrences > nybble_run_2->occurrences;
-	else
-		return nybble_run_1->total_code_bits < nybble_run_2->total_code_bits;
+	NybbleRunsIndex scratch;
+	unsigned int bucket_starts[MAXIMUM_BITS + 1];
+	unsigned int i;
+
+	/* This is a counting sort, which is stable, so runs with the same code length remain sorted by occurrence. */
+	for (i = 0; i < CC_COUNT_OF(bucket_starts); ++i)
+		bucket_starts[i] = 0;
+
+	for (i = 0; i < TOTAL_SYMBOLS; ++i)
+	{
+		assert(NybbleRunFromIndex(state, runs_reordered[i])->total_code_bits < CC_COUNT_OF(bucket_starts));
+		++bucket_starts[NybbleRunFromIndex(state, runs_reordered[i])->total_code_bits];
+	}
+
+	CountsToBucketStarts(bucket_starts, CC_COUNT_OF(bucket_starts));
+
+	for (i = 0; i < TOTAL_SYMBOLS; ++i)
+		scratch[bucket_starts[NybbleRunFromIndex(state, runs_reordered[i])->total_code_bits]++] = runs_reordered[i];
+
+	for (i = 0; i < TOTAL_SYMBOLS; ++i)
+		runs_reordered[i] = scratch[i];
 }
 
 static void ComputeCodesFromLengths(State* const state)
@@ -533,379 +679,3218 @@ static void ComputeCodesFromLengths(State* const state)
 	NybbleRunsIndex runs_reordered;
 	unsigned int code, previous_code_length;
 	unsigned int i;
-	unsigned int total_code_bits_modifier;
 
-	/* Get a sorted list of the nybble runs, ordered by their total code bits. */
-	ComputeSortedRuns(state, runs_reordered, ComparisonCodeTotalBits);
+	/* Get a sorted list of the nybble runs, ordered by their total code bits first, and their occurrences second. */
+	ComputeSortedRuns(state, runs_reordered);
+	SortRunsByCodeLength(state, runs_reordered);
 
-	code = -1;
-	total_code_bits_modifier = 0;
+	code = 0;
+	previous_code_length = 0;
 
-	/* Ignore all of the nybble runs that don't have a code... */
 	for (i = 0; i < TOTAL_SYMBOLS; ++i)
-		if (NybbleRunFromIndex(state, runs_reordered[i])->total_code_bits != 0)
-			break;
-
-	/* ..and iterate over the ones that do. */
-	for (; i < TOTAL_SYMBOLS; ++i)
 	{
-		unsigned int nybble_run_index = runs_reordered[i];
-		NybbleRun* const nybble_run = NybbleRunFromIndex(state, nybble_run_index);
-
-		/* What we're doing here is computing the 'canonical Huffman codes' from the code lengths. */
-		++code;
-
-		nybble_run->total_code_bits += total_code_bits_modifier;
-
-		if (nybble_run->total_code_bits != previous_code_length)
-		{
-			assert(previous_code_length != 9);
-			code <<= nybble_run->total_code_bits - previous_code_length;
-			previous_code_length = nybble_run->total_code_bits;
-		}
+		NybbleRun* const nybble_run = NybbleRunFromIndex(state, runs_reordered[i]);
 
-		/* Prevent conflicting with the reserved inline prefix. */
-		if (total_code_bits_modifier == 0 /* Don't do this more than once. */
-		 && ((nybble_run->total_code_bits >= 6 && (code >> (nybble_run->total_code_bits - 6)) == 0x3E) /* Soon-to-be suffix of 111111. */
-		  || (nybble_run->total_code_bits < 6 && code == (1u << nybble_run->total_code_bits) - 1))) /* Prefix of 111111. */
-		{
-		#ifdef CLOWNNEMESIS_DEBUG
-			fputs("Performing conflict avoidance.\n", stderr);
-		#endif
-			code <<= 1;
-			++nybble_run->total_code_bits;
-			++previous_code_length;
-			total_code_bits_modifier = 1;
+		/* Ignore all of the nybble runs that don't have a code. */
+		if (nybble_run->total_code_bits == 0)
+			continue;
 
-			assert(previous_code_length != 9);
-		}
+		/* What we're doing here is computing the 'canonical Huffman codes' from the code lengths. */
+		code <<= nybble_run->total_code_bits - previous_code_length;
+		previous_code_length = nybble_run->total_code_bits;
 
-		nybble_run->code = code;
+		nybble_run->code = code++;
 
 	#ifdef CLOWNNEMESIS_DEBUG
 		{
 			unsigned int j;
 
-			fprintf(stderr, "Nybble %X of length %d has code ", nybble_run_index / 8, (nybble_run_index % 8) + 1);
+			fprintf(stderr, "Nybble %X of length %d has code ", runs_reordered[i] % 16, (runs_reordered[i] / 16) + 1);
 
 			for (j = 0; j < 8; ++j)
-				fputc((code & (1 << (8 - 1 - j))) != 0 ? '1' : '0', stderr);
+				fputc((nybble_run->code & (1 << (8 - 1 - j))) != 0 ? '1' : '0', stderr);
 
 			fprintf(stderr, " of %d bits\n", nybble_run->total_code_bits);
 		}
 	#endif
 	}
+
+	/* Canonical codes are packed together from the start of the code space, so, as long as the code lengths did not use
+	   the reserved code space, none of the codes can conflict with the reserved inline prefix. */
+	assert(previous_code_length == 0 || code << (MAXIMUM_BITS - previous_code_length) <= AVAILABLE_CODE_SPACE);
 }
 
-static void ComputeCodesHuffman(State* const state)
+static void ComputeCodesOptimal(State* const state)
 {
-	/* Create leaf nodes. */
-	IterateNybbleRuns(state, CreateLeafNode);
-
-	/* Now sort them by their occurrences. */
-	qsort(state->generator.huffman.node_pool, TOTAL_SYMBOLS, sizeof(Node), CompareNodes);
-
-	/* Find the first node with a decent probability. */
-	for (state->generator.huffman.leaf_read_index = 0; state->generator.huffman.leaf_read_index < TOTAL_SYMBOLS; ++state->generator.huffman.leaf_read_index)
-		if (state->generator.huffman.node_pool[state->generator.huffman.leaf_read_index].occurrences >= 3)
-			break;
-
 	/* Compute code lengths. */
-	ComputeBestCodeLengths(state);
+	ComputeOptimalCodeLengths(state);
 
 	/* With the lengths, we can compute the codes. */
 	ComputeCodesFromLengths(state);
 }
 
 /*************************/
-/* End of Huffman Coding */
+/* End of Optimal Coding */
 /*************************/
 
-static int ReadByteThatMightBeXORed(State* const state)
+/********************/
+/* Heuristic Coding */
+/********************/
+
+/* This quickly computes reasonable code lengths from the probabilities of the nybble runs, like Shannon coding does. */
+/* https://en.wikipedia.org/wiki/Shannon_coding */
+
+static void ComputeCodesHeuristic(State* const state)
 {
-	const int value = ReadByte(&state->common);
+	unsigned int total_occurrences, space;
+	unsigned int i;
 
-	if (value == CLOWNNEMESIS_EOF)
-	{
-		state->input_byte_buffer_index = 0;
-		state->input_byte_buffer[0] = state->input_byte_buffer[1] = state->input_byte_buffer[2] = state->input_byte_buffer[3] = 0;
-		return CLOWNNEMESIS_EOF;
-	}
-	else
-	{
-		const unsigned int index = state->input_byte_buffer_index;
-		const unsigned int previous_value = state->input_byte_buffer[index];
+	total_occurrences = 0;
 
-		state->input_byte_buffer_index = (state->input_byte_buffer_index + 1) % CC_COUNT_OF(state->input_byte_buffer);
-		state->input_byte_buffer[index] = value;
+	for (i = 0; i < TOTAL_SYMBOLS; ++i)
+		total_occurrences += NybbleRunFromIndex(state, i)->occurrences;
 
-		return value ^ (state->xor_mode_enabled ? previous_value : 0);
-	}
-}
+	space = 0;
 
-static int ReadNybble(State* const state)
-{
-	if (state->nybble_reader_flip_flop)
+	for (i = 0; i < TOTAL_SYMBOLS; ++i)
 	{
-		state->input_nybble_buffer <<= 4;
+		NybbleRun* const nybble_run = NybbleRunFromIndex(state, i);
+		unsigned int total_code_bits;
+
+		nybble_run->total_code_bits = 0;
+
+		if (nybble_run->occurrences == 0)
+			continue;
+
+		/* Give the nybble run a code with a length that roughly matches its probability. */
+		for (total_code_bits = 1; total_code_bits < MAXIMUM_BITS && (total_occurrences >> total_code_bits) > nybble_run->occurrences; ++total_code_bits);
+
+		/* Only bother with a code if it is cheaper than inlining the nybble run (the code table entry costs 16 bits). */
+		if (16 + total_code_bits * nybble_run->occurrences < (6 + 3 + 4) * nybble_run->occurrences)
+		{
+			nybble_run->total_code_bits = total_code_bits;
+			space += CODE_SPACE_USED(total_code_bits);
+		}
 	}
-	else
+
+	/* If the codes use too much code space, then lengthen the codes of the rarest nybble runs until they fit. */
+	while (space > AVAILABLE_CODE_SPACE)
 	{
-		const int value = ReadByteThatMightBeXORed(state);
+		NybbleRun *rarest_nybble_run;
 
-		if (value == CLOWNNEMESIS_EOF)
-			return CLOWNNEMESIS_EOF;
+		rarest_nybble_run = NULL;
 
-		if (state->bytes_read == UINT_MAX)
+		for (i = 0; i < TOTAL_SYMBOLS; ++i)
 		{
-		#ifdef CLOWNNEMESIS_DEBUG
-			fputs("Input data is too large.\n", stderr);
-		#endif
-			longjmp(state->common.jump_buffer, 1);
+			NybbleRun* const nybble_run = NybbleRunFromIndex(state, i);
+
+			if (nybble_run->total_code_bits != 0 && (rarest_nybble_run == NULL || nybble_run->occurrences < rarest_nybble_run->occurrences))
+				rarest_nybble_run = nybble_run;
 		}
 
-		++state->bytes_read;
-		state->input_nybble_buffer = (unsigned char)value;
+		space -= CODE_SPACE_USED(rarest_nybble_run->total_code_bits);
+
+		/* If the code cannot be made any longer, then inline the nybble run instead. */
+		if (rarest_nybble_run->total_code_bits == MAXIMUM_BITS)
+		{
+			rarest_nybble_run->total_code_bits = 0;
+		}
+		else
+		{
+			++rarest_nybble_run->total_code_bits;
+			space += CODE_SPACE_USED(rarest_nybble_run->total_code_bits);
+		}
 	}
 
-	state->nybble_reader_flip_flop = !state->nybble_reader_flip_flop;
+	/* Rounding the lengths up tends to leave code space unused, so spend it on shortening the codes of the most common nybble runs. */
+	for (;;)
+	{
+		NybbleRun *commonest_nybble_run;
 
-	return (state->input_nybble_buffer >> 4) & 0xF;
-}
+		commonest_nybble_run = NULL;
 
-static void FindRuns(State* const state, void (* const callback)(State *state, unsigned int run_nybble, unsigned int run_length))
-{
-	int new_nybble, previous_nybble, run_length;
+		for (i = 0; i < TOTAL_SYMBOLS; ++i)
+		{
+			NybbleRun* const nybble_run = NybbleRunFromIndex(state, i);
 
-	state->bytes_read = 0;
-	state->nybble_reader_flip_flop = cc_false;
-	state->input_byte_buffer[0] = state->input_byte_buffer[1] = state->input_byte_buffer[2] = state->input_byte_buffer[3] = 0;
-	state->input_byte_buffer_index = 0;
+			if (nybble_run->total_code_bits > 1 && space + CODE_SPACE_USED(nybble_run->total_code_bits) <= AVAILABLE_CODE_SPACE && (commonest_nybble_run == NULL || nybble_run->occurrences > commonest_nybble_run->occurrences))
+				commonest_nybble_run = nybble_run;
+		}
 
-	new_nybble = ReadNybble(state);
-	run_length = 0;
+		if (commonest_nybble_run == NULL)
+			break;
 
-	while (new_nybble != CLOWNNEMESIS_EOF)
-	{
-		++run_length;
+		/* Shortening a code by one bit doubles the code space that it uses. */
+		space += CODE_SPACE_USED(commonest_nybble_run->total_code_bits);
+		--commonest_nybble_run->total_code_bits;
+	}
+
+	/* With the lengths, we can compute the codes. */
+	ComputeCodesFromLengths(state);
+}
 
-		previous_nybble = new_nybble;
-		new_nybble = ReadNybble(state);
+/***************************/
+/* End of Heuristic Coding */
+/***************************/
 
-		if (run_length == 8 || new_nybble != previous_nybble)
+static void CountInputBytes(State* const state)
+{
+	for (state->bytes_read = 0; ReadByte(&state->common) != CLOWNNEMESIS_EOF; ++state->bytes_read)
+	{
+		if (state->bytes_read == UINT_MAX)
 		{
-			callback(state, previous_nybble, run_length);
-			run_length = 0;
+		#ifdef CLOWNNEMESIS_DEBUG
+			fputs("Input data is too large.\n", stderr);
+		#endif
+			longjmp(state->common.jump_buffer, 1);
 		}
 	}
 }
 
-static void LogOccurrence(State* const state, const unsigned int run_nybble, const unsigned int run_length)
+static void FeedRunFinder(RunFinder* const run_finder, unsigned int (* const histogram)[MAXIMUM_RUN_LENGTH], const unsigned int nybble)
 {
-	++state->nybble_runs[run_nybble][run_length - 1].occurrences;
-	++state->total_runs;
+	if (run_finder->length != 0 && (run_finder->length == MAXIMUM_RUN_LENGTH || nybble != run_finder->nybble))
+	{
+		++histogram[run_finder->nybble][run_finder->length - 1];
+		run_finder->length = 0;
+	}
+
+	run_finder->nybble = nybble;
+	++run_finder->length;
 }
 
-static void ResetNybbleRun(State* const state, const unsigned int run_nybble, const unsigned int run_length_minus_one)
+static void FlushRunFinder(RunFinder* const run_finder, unsigned int (* const histogram)[MAXIMUM_RUN_LENGTH])
 {
-	NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length_minus_one];
+	if (run_finder->length != 0)
+		++histogram[run_finder->nybble][run_finder->length - 1];
 
-	nybble_run->occurrences = nybble_run->code = nybble_run->total_code_bits = 0;
+	run_finder->length = 0;
 }
 
-static unsigned int ComputeCodesInternal(State* const state, const cc_bool xor_mode_enabled, const cc_bool accurate)
+static void ComputeHistogramsBothModes(State* const state, const cc_bool sampled)
 {
-	state->xor_mode_enabled = xor_mode_enabled;
+	/* This is like doing 'FindRunsLogOccurrence' in both regular mode and XOR mode, but only reads the input once. */
+	/* When recompressing, the runs of the mode that the data was compressed in are already known, so only the other */
+	/* mode is counted from the input. */
+	const RecompressionSource* const source = sampled ? NULL : state->recompression_source;
+	const unsigned int source_mode = source == NULL ? 2 : source->xor_mode_enabled;
+	RunFinder run_finders[2];
+	unsigned char previous_row[4];
+	unsigned int i;
 
-	/* Reset occurances to 0. */
-	IterateNybbleRuns(state, ResetNybbleRun);
+	for (i = 0; i < 2; ++i)
+	{
+		unsigned int j;
 
-	/* Count how many times each nybble run occurs in the source data. */
-	/* Also count how many nybbles (bytes) are in the input data. */
-	FindRuns(state, LogOccurrence);
+		for (j = 0; j < MAXIMUM_RUN_NYBBLE; ++j)
+		{
+			unsigned int k;
 
-	/* Do the coding-specific tasks. */
-	if (accurate)
-		ComputeCodesFano(state);
-	else
-		ComputeCodesHuffman(state);
+			for (k = 0; k < MAXIMUM_RUN_LENGTH; ++k)
+				state->histograms[i][j][k] = !sampled && state->known_histogram != NULL ? (unsigned int)state->known_histogram->occurrences[i][j][k] : 0;
+		}
 
-	ComputeTotalEncodedBits(state);
+		run_finders[i].length = 0;
+	}
 
-	/* This division is needed in order for Sonic 1's Basaran tiles to compress accurately. Sega's compressor only counted the bytes, not the bits. */
-	/* This division must round up in order for Sonic 3's Buggernaut tiles to compress accurately. */
-	return CC_DIVIDE_CEILING(state->total_bits, 8);
-}
+	if (!sampled && state->known_histogram != NULL)
+	{
+		/* Only the size of the data is left to find. */
+		CountInputBytes(state);
+		return;
+	}
 
-static void ComputeCodes(State* const state, const cc_bool accurate)
-{
-	/* Process the input data in both regular and XOR mode, seeing which produces the smaller data. */
-	const unsigned int total_bytes_regular_mode = ComputeCodesInternal(state, cc_false, accurate);
-	const unsigned int total_bytes_xor_mode = ComputeCodesInternal(state, cc_true, accurate);
+	if (source != NULL)
+	{
+		size_t j;
 
-#ifdef CLOWNNEMESIS_DEBUG
+		for (j = 0; j < source->total_runs; ++j)
+			++state->histograms[source_mode][source->runs[j] & 0xF][source->runs[j] >> 4];
+	}
+
+	for (i = 0; i < CC_COUNT_OF(previous_row); ++i)
+		previous_row[i] = 0;
+
+	for (state->bytes_read = 0; ; ++state->bytes_read)
+	{
+		const int value = ReadByte(&state->common);
+
+		if (value == CLOWNNEMESIS_EOF)
+			break;
+
+		if (state->bytes_read == UINT_MAX)
+		{
+		#ifdef CLOWNNEMESIS_DEBUG
+			fputs("Input data is too large.\n", stderr);
+		#endif
+			longjmp(state->common.jump_buffer, 1);
+		}
+
+		{
+		const unsigned int xored_value = value ^ previous_row[state->bytes_read % CC_COUNT_OF(previous_row)];
+
+		/* The previous row must always be kept track of, even for tiles that are not sampled. */
+		previous_row[state->bytes_read % CC_COUNT_OF(previous_row)] = value;
+
+		if (source != NULL)
+		{
+			const unsigned int counted_value = source_mode == 0 ? xored_value : (unsigned int)value;
+
+			FeedRunFinder(&run_finders[!source_mode], state->histograms[!source_mode], (counted_value >> 4) & 0xF);
+			FeedRunFinder(&run_finders[!source_mode], state->histograms[!source_mode], counted_value & 0xF);
+		}
+		else if (!sampled || (state->bytes_read / BYTES_PER_TILE) % SAMPLED_TILE_INTERVAL == 0)
+		{
+			FeedRunFinder(&run_finders[0], state->histograms[0], (value >> 4) & 0xF);
+			FeedRunFinder(&run_finders[0], state->histograms[0], value & 0xF);
+			FeedRunFinder(&run_finders[1], state->histograms[1], (xored_value >> 4) & 0xF);
+			FeedRunFinder(&run_finders[1], state->histograms[1], xored_value & 0xF);
+		}
+		else if (state->bytes_read % BYTES_PER_TILE == 0)
+		{
+			/* Don't let runs carry over into the tiles that are not sampled. */
+			FlushRunFinder(&run_finders[0], state->histograms[0]);
+			FlushRunFinder(&run_finders[1], state->histograms[1]);
+		}
+		}
+	}
+
+	FlushRunFinder(&run_finders[0], state->histograms[0]);
+	FlushRunFinder(&run_finders[1], state->histograms[1]);
+}
+
+static void UseHistogram(State* const state, const cc_bool xor_mode_enabled)
+{
+	unsigned int i;
+
+	state->xor_mode_enabled = xor_mode_enabled;
+
+	for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
+	{
+		unsigned int j;
+
+		for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+		{
+			NybbleRun* const nybble_run = &state->nybble_runs[i][j];
+
+			nybble_run->occurrences = state->histograms[xor_mode_enabled][i][j];
+			nybble_run->code = nybble_run->total_code_bits = 0;
+		}
+	}
+}
+
+static void LogOccurrence(State* const state, const unsigned int run_nybble, const unsigned int run_length)
+{
+	++state->nybble_runs[run_nybble][run_length - 1].occurrences;
+	++state->total_runs;
+}
+
+static void ResetNybbleRun(State* const state, const unsigned int run_nybble, const unsigned int run_length_minus_one)
+{
+	NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length_minus_one];
+
+	nybble_run->occurrences = nybble_run->code = nybble_run->total_code_bits = 0;
+}
+
+static unsigned int RunBits(State* const state, const unsigned int run_nybble, const unsigned int run_length)
+{
+	const NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length - 1];
+
+	/* An inlined nybble run costs 13 bits. */
+	return nybble_run->total_code_bits != 0 ? nybble_run->total_code_bits : 6 + 3 + 4;
+}
+
+static unsigned int RunCost(State* const state, const unsigned int run_nybble, const unsigned int run_length)
+{
+	/* The cost of a run is its size, plus the time that it takes to decode if that is being optimised for. */
+	/* The units are 1/2048ths of a bit, so that the per-bit cost of reading bytes does not need to be rounded. */
+	const NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length - 1];
+	const unsigned int bits = RunBits(state, run_nybble, run_length);
+	const unsigned int eighths_of_cycles = (nybble_run->total_code_bits != 0 ? DECODE_CYCLES_PER_CODE : DECODE_CYCLES_PER_INLINE) * 8 + bits * DECODE_CYCLES_PER_BYTE;
+
+	return bits * 256 * 8 + state->decode_cycle_weight * eighths_of_cycles;
+}
+
+static void ParseStretch(State* const state)
+{
+	/* A stretch is a sequence of identical nybbles, which has to be split into runs. Rather than greedily using the longest
+	   runs possible, this finds the cheapest split using the codes that were computed, which is a shortest-path problem. */
+	/* Replacing any 'k' runs with runs of the length with the best bits-per-nybble ratio (which is 'k' nybbles long) never
+	   costs more, so there is always an optimal split that has fewer than 'k' other runs. Because of this, runs of the best
+	   length can be emitted until the stretch is short enough for the rest of it to be solved with a small table. */
+	unsigned int best_costs[(MAXIMUM_RUN_LENGTH - 1) * MAXIMUM_RUN_LENGTH + 1];
+	unsigned char best_run_lengths[(MAXIMUM_RUN_LENGTH - 1) * MAXIMUM_RUN_LENGTH + 1];
+	unsigned int best_ratio_run_length;
+	unsigned int remaining;
+	unsigned int i;
+
+	const unsigned int run_nybble = state->stretch_nybble;
+
+	/* Empty input has no stretch at all, and so no nybble to look up the costs of. */
+	if (state->stretch_length == 0)
+		return;
+
+	best_ratio_run_length = MAXIMUM_RUN_LENGTH;
+
+	for (i = 1; i < MAXIMUM_RUN_LENGTH; ++i)
+		if (RunCost(state, run_nybble, i) * best_ratio_run_length < RunCost(state, run_nybble, best_ratio_run_length) * i)
+			best_ratio_run_length = i;
+
+	for (; state->stretch_length > CC_COUNT_OF(best_costs) - 1; state->stretch_length -= best_ratio_run_length)
+		state->parsed_run_callback(state, run_nybble, best_ratio_run_length);
+
+	remaining = (unsigned int)state->stretch_length;
+	state->stretch_length = 0;
+
+	best_costs[0] = 0;
+
+	for (i = 1; i <= remaining; ++i)
+	{
+		unsigned int run_length;
+
+		best_costs[i] = UINT_MAX;
+
+		for (run_length = 1; run_length <= CC_MIN(i, MAXIMUM_RUN_LENGTH); ++run_length)
+		{
+			const unsigned int cost = best_costs[i - run_length] + RunCost(state, run_nybble, run_length);
+
+			if (cost < best_costs[i])
+			{
+				best_costs[i] = cost;
+				best_run_lengths[i] = run_length;
+			}
+		}
+	}
+
+	/* The runs are all the same nybble, so the order in which they are emitted does not matter. */
+	for (i = remaining; i != 0; i -= best_run_lengths[i])
+		state->parsed_run_callback(state, run_nybble, best_run_lengths[i]);
+}
+
+static void AccumulateStretch(State* const state, const unsigned int run_nybble, const unsigned int run_length)
+{
+	if (state->stretch_length != 0 && run_nybble != state->stretch_nybble)
+		ParseStretch(state);
+
+	state->stretch_nybble = run_nybble;
+	state->stretch_length += run_length;
+}
+
+static cc_bool UseRecompressionSource(State* const state)
+{
+	return state->recompression_source != NULL && state->recompression_source->xor_mode_enabled == state->xor_mode_enabled;
+}
+
+static void IterateRecompressionSource(State* const state, void (* const callback)(State *state, unsigned int run_nybble, unsigned int run_length))
+{
+	/* The runs are already exactly what the run-finding loop would produce, so they can be passed along as they are. */
+	const RecompressionSource* const source = state->recompression_source;
+	size_t i;
+
+	state->bytes_read = source->total_nybbles / 2;
+
+	for (i = 0; i < source->total_runs; ++i)
+		callback(state, source->runs[i] & 0xF, (source->runs[i] >> 4) + 1);
+}
+
+#define FIND_RUNS_NAME FindRunsAccumulateStretchRegular
+#define FIND_RUNS_CALLBACK AccumulateStretch
+#define FIND_RUNS_XOR_MODE_ENABLED 0
+#include "compress-find-runs.h"
+
+#define FIND_RUNS_NAME FindRunsAccumulateStretchXOR
+#define FIND_RUNS_CALLBACK AccumulateStretch
+#define FIND_RUNS_XOR_MODE_ENABLED 1
+#include "compress-find-runs.h"
+
+static void FindRunsAccumulateStretch(State* const state)
+{
+	/* Finds every run in the input data and passes it to 'AccumulateStretch'. */
+	if (UseRecompressionSource(state))
+		IterateRecompressionSource(state, AccumulateStretch);
+	else if (state->xor_mode_enabled)
+		FindRunsAccumulateStretchXOR(state);
+	else
+		FindRunsAccumulateStretchRegular(state);
+}
+
+static void ParseRuns(State* const state, void (* const callback)(State *state, unsigned int run_nybble, unsigned int run_length))
+{
+	/* Like 'FindRunsEmitCode', but the runs are split in the cheapest way for the current codes instead of greedily. */
+	state->parsed_run_callback = callback;
+	state->stretch_length = 0;
+	FindRunsAccumulateStretch(state);
+	ParseStretch(state);
+}
+
+#define FIND_RUNS_NAME FindRunsLogOccurrenceRegular
+#define FIND_RUNS_CALLBACK LogOccurrence
+#define FIND_RUNS_XOR_MODE_ENABLED 0
+#include "compress-find-runs.h"
+
+#define FIND_RUNS_NAME FindRunsLogOccurrenceXOR
+#define FIND_RUNS_CALLBACK LogOccurrence
+#define FIND_RUNS_XOR_MODE_ENABLED 1
+#include "compress-find-runs.h"
+
+static void FindRunsLogOccurrence(State* const state)
+{
+	/* Finds every run in the input data and passes it to 'LogOccurrence'. */
+	if (UseRecompressionSource(state))
+		IterateRecompressionSource(state, LogOccurrence);
+	else if (state->xor_mode_enabled)
+		FindRunsLogOccurrenceXOR(state);
+	else
+		FindRunsLogOccurrenceRegular(state);
+}
+
+static unsigned int ComputeCodesInternal(State* const state, const cc_bool xor_mode_enabled, const cc_bool accurate)
+{
+	UseHistogram(state, xor_mode_enabled);
+
+	/* Do the coding-specific tasks. */
+	if (accurate)
+		ComputeCodesFano(state);
+	else
+		ComputeCodesOptimal(state);
+
+	ComputeTotalEncodedBits(state);
+
+	/* This division is needed in order for Sonic 1's Basaran tiles to compress accurately. Sega's compressor only counted the bytes, not the bits. */
+	/* This division must round up in order for Sonic 3's Buggernaut tiles to compress accurately. */
+	return CC_DIVIDE_CEILING(state->total_bits, 8);
+}
+
+static void ComputeCodesFromHistograms(State* const state, const cc_bool accurate)
+{
+	unsigned int total_bytes_regular_mode, total_bytes_xor_mode;
+
+	/* Process the input data in both regular and XOR mode, seeing which produces the smaller data. */
+	total_bytes_regular_mode = ComputeCodesInternal(state, cc_false, accurate);
+	total_bytes_xor_mode = ComputeCodesInternal(state, cc_true, accurate);
+
+#ifdef CLOWNNEMESIS_DEBUG
 	fprintf(stderr, "Regular: %d bytes.\nXOR:     %d bytes.\n", total_bytes_regular_mode, total_bytes_xor_mode);
 #endif
 
-	/* If regular mode was smaller or equivalent, then process the data in that mode again since it's currently in XOR mode still. */
-	/* TODO: Avoid this third pass by caching the first two. */
-	if (total_bytes_regular_mode <= total_bytes_xor_mode)
-		ComputeCodesInternal(state, cc_false, accurate);
+	/* Sega's compressor emits at least as many bytes as were measured, so there is no need to go any further if both modes are over the budget. */
+	/* This cannot be done otherwise, as the data will be split into runs more efficiently than was measured. */
+	if (accurate)
+		CheckBudget(state, 2 + 1 + CC_MIN(total_bytes_regular_mode, total_bytes_xor_mode));
+
+	/* If regular mode was smaller or equivalent, then make its codes again since it's currently in XOR mode still. */
+	/* This does not need to read the input data again, as both histograms are kept. */
+	if (total_bytes_regular_mode <= total_bytes_xor_mode)
+		ComputeCodesInternal(state, cc_false, accurate);
+}
+
+static void ComputeCodes(State* const state, const cc_bool accurate)
+{
+	/* Both modes are counted by a single read of the input data. */
+	ComputeHistogramsBothModes(state, cc_false);
+	ComputeCodesFromHistograms(state, accurate);
+}
+
+static void ComputeCodesFast(State* const state, const cc_bool sampled)
+{
+	unsigned int total_bits_regular_mode, total_bits_xor_mode;
+
+	ComputeHistogramsBothModes(state, sampled);
+
+	/* Decide between regular mode and XOR mode using quickly-made codes. */
+	UseHistogram(state, cc_false);
+	ComputeCodesHeuristic(state);
+	ComputeTotalEncodedBits(state);
+	total_bits_regular_mode = state->total_bits;
+
+	UseHistogram(state, cc_true);
+	ComputeCodesHeuristic(state);
+	ComputeTotalEncodedBits(state);
+	total_bits_xor_mode = state->total_bits;
+
+	if (total_bits_regular_mode <= total_bits_xor_mode)
+	{
+		UseHistogram(state, cc_false);
+		ComputeCodesHeuristic(state);
+	}
+}
+
+/**************/
+/* Ultra Mode */
+/**************/
+
+/* This is similar to how Zopfli optimises Deflate data: the codes decide how the data is split into runs, and how the data
+   is split into runs decides the codes, so the two are alternately refined until the data stops getting smaller. */
+
+#define ULTRA_MAXIMUM_ITERATIONS 16
+/* The perturbed seed makes codes as if every nybble run occurred this many times as often as it does. */
+#define ULTRA_PERTURBED_SCALE 4
+
+enum
+{
+	ULTRA_SEED_OPTIMAL,
+	ULTRA_SEED_FANO,
+	ULTRA_SEED_PERTURBED,
+	ULTRA_TOTAL_SEEDS
+};
+
+static void LogParsedRun(State* const state, const unsigned int run_nybble, const unsigned int run_length)
+{
+	++state->ultra.parsed_occurrences[run_nybble][run_length - 1];
+}
+
+static void ResetParsedRun(State* const state, const unsigned int run_nybble, const unsigned int run_length_minus_one)
+{
+	state->ultra.parsed_occurrences[run_nybble][run_length_minus_one] = 0;
+}
+
+static void UseParsedRun(State* const state, const unsigned int run_nybble, const unsigned int run_length_minus_one)
+{
+	state->nybble_runs[run_nybble][run_length_minus_one].occurrences = state->ultra.parsed_occurrences[run_nybble][run_length_minus_one];
+}
+
+static void PerturbOccurrences(State* const state)
+{
+	unsigned int i;
+
+	/* Scaling up the occurrences is the same as making the code table cheaper, so rarer runs get codes than would */
+	/* otherwise. This gives the parser some more options, which the refinement can then either keep or discard. */
+	/* Merely giving runs a single occurrence would not do this, as a code is never worth a code table entry for one run. */
+	for (i = 0; i < TOTAL_SYMBOLS; ++i)
+		NybbleRunFromIndex(state, i)->occurrences *= ULTRA_PERTURBED_SCALE;
+}
+
+static unsigned int ComputeParsedTotalBits(State* const state)
+{
+	/* Split the data using the current codes, and count the runs that this produces. */
+	IterateNybbleRuns(state, ResetParsedRun);
+	ParseRuns(state, LogParsedRun);
+
+	/* Now the size of the data is simply the size of the code table and the codes of those runs. */
+	IterateNybbleRuns(state, UseParsedRun);
+	ComputeTotalEncodedBits(state);
+
+	return state->total_bits;
+}
+
+static unsigned long ComputeParsedTotalCost(State* const state)
+{
+	/* Like 'ComputeParsedTotalBits', but includes the time that the runs take to decode, if that is being optimised for. */
+	/* The units are 1/16ths of a bit, which, with the limited weight, cannot overflow even for the largest data. */
+	unsigned long total_cost;
+	unsigned int i;
+
+	total_cost = (unsigned long)ComputeParsedTotalBits(state) * 16;
+
+	if (state->decode_cycle_weight != 0)
+	{
+		for (i = 0; i < TOTAL_SYMBOLS; ++i)
+		{
+			const unsigned int run_nybble = i % MAXIMUM_RUN_NYBBLE;
+			const unsigned int run_length = i / MAXIMUM_RUN_NYBBLE + 1;
+			const unsigned int cycle_cost = RunCost(state, run_nybble, run_length) - RunBits(state, run_nybble, run_length) * 256 * 8;
+
+			total_cost += (unsigned long)NybbleRunFromIndex(state, i)->occurrences * (cycle_cost / 128);
+		}
+
+		/* The decoder also takes time to turn each code into entries of its lookup table, and to XOR every row in XOR mode. */
+		/* Leaving these out would make codes which save a little time decoding runs seem better than they really are. */
+		{
+		unsigned long other_cycles;
+
+		other_cycles = state->xor_mode_enabled ? (unsigned long)state->bytes_read / 4 * DECODE_CYCLES_PER_XOR_ROW : 0;
+
+		for (i = 0; i < TOTAL_SYMBOLS; ++i)
+		{
+			const unsigned int total_code_bits = NybbleRunFromIndex(state, i)->total_code_bits;
+
+			if (total_code_bits != 0)
+				other_cycles += DECODE_CYCLES_PER_TABLE_ENTRY + DECODE_CYCLES_PER_TABLE_SLOT * CODE_SPACE_USED(total_code_bits);
+		}
+
+		total_cost += state->decode_cycle_weight * other_cycles / 16;
+		}
+	}
+
+	return total_cost;
+}
+
+static unsigned long ComputeParsedDecodeCycles(State* const state)
+{
+	/* The number of cycles that 'ClownNemesis_EstimateDecodeCycles' would count for the data, which must have just */
+	/* been split into runs with the current codes. */
+	unsigned long total_code_bits, decode_cycles;
+	unsigned int i;
+
+	total_code_bits = 0;
+	decode_cycles = (unsigned long)state->bytes_read * 2 * DECODE_CYCLES_PER_NYBBLE
+	              + (unsigned long)state->bytes_read / 4 * (DECODE_CYCLES_PER_ROW + (state->xor_mode_enabled ? DECODE_CYCLES_PER_XOR_ROW : 0));
+
+	for (i = 0; i < TOTAL_SYMBOLS; ++i)
+	{
+		const NybbleRun* const nybble_run = NybbleRunFromIndex(state, i);
+		const unsigned int run_nybble = i % MAXIMUM_RUN_NYBBLE;
+		const unsigned int run_length = i / MAXIMUM_RUN_NYBBLE + 1;
+
+		total_code_bits += (unsigned long)nybble_run->occurrences * RunBits(state, run_nybble, run_length);
+		decode_cycles += (unsigned long)nybble_run->occurrences * (nybble_run->total_code_bits != 0 ? DECODE_CYCLES_PER_CODE : DECODE_CYCLES_PER_INLINE);
+
+		if (nybble_run->total_code_bits != 0)
+			decode_cycles += DECODE_CYCLES_PER_TABLE_ENTRY + DECODE_CYCLES_PER_TABLE_SLOT * CODE_SPACE_USED(nybble_run->total_code_bits);
+	}
+
+	/* The decoder reads another byte of codes whenever it runs out of bits. */
+	return decode_cycles + CC_DIVIDE_CEILING(total_code_bits, 8) * DECODE_CYCLES_PER_BYTE;
+}
+
+static void ComputeSeedCodes(State* const state, const cc_bool xor_mode_enabled, const unsigned int seed)
+{
+	UseHistogram(state, xor_mode_enabled);
+
+	switch (seed)
+	{
+		case ULTRA_SEED_OPTIMAL:
+			ComputeCodesOptimal(state);
+			break;
+
+		case ULTRA_SEED_FANO:
+			ComputeCodesFano(state);
+			break;
+
+		case ULTRA_SEED_PERTURBED:
+			PerturbOccurrences(state);
+			ComputeCodesOptimal(state);
+			break;
+	}
+}
+
+static void RefineCodes(State* const state)
+{
+	unsigned long previous_total_cost;
+	unsigned int iteration;
+
+	previous_total_cost = ULONG_MAX;
+
+	for (iteration = 0; iteration < ULTRA_MAXIMUM_ITERATIONS; ++iteration)
+	{
+		const unsigned long total_cost = ComputeParsedTotalCost(state);
+
+	#ifdef CLOWNNEMESIS_DEBUG
+		fprintf(stderr, "Ultra: XOR %d, iteration %d: %lu sixteenths of bits.\n", state->xor_mode_enabled, iteration, total_cost);
+	#endif
+
+		if (total_cost < state->ultra.best_total_cost)
+		{
+			state->ultra.best_total_cost = total_cost;
+			state->ultra.best_xor_mode_enabled = state->xor_mode_enabled;
+			memcpy(state->ultra.best_nybble_runs, state->nybble_runs, sizeof(state->nybble_runs));
+		}
+
+		/* Stop once the codes are no longer improving. */
+		if (total_cost >= previous_total_cost)
+			break;
+
+		previous_total_cost = total_cost;
+
+		/* Compute new codes from the runs that the current codes produced. */
+		ComputeCodesOptimal(state);
+	}
+}
+
+static void RefineComputedCodes(State* const state)
+{
+	/* The optimal codes are only optimal for the runs of the greedy split, but the data is split in the cheapest way for */
+	/* the codes instead, which produces different runs. So, like a single seed of ultra mode, the codes are refined for */
+	/* the runs that they actually produce, staying in the mode that was chosen for them. */
+	state->ultra.best_total_cost = ULONG_MAX;
+	RefineCodes(state);
+
+	state->xor_mode_enabled = state->ultra.best_xor_mode_enabled;
+	memcpy(state->nybble_runs, state->ultra.best_nybble_runs, sizeof(state->nybble_runs));
+	ComputeTotalEncodedBits(state);
+}
+
+static void RefineSeed(State* const state, const unsigned int seeds_per_mode, const unsigned int seed, ClownNemesis_RefinedSeed* const refined_seed)
+{
+	/* Seeds are numbered by mode and then by kind, which is the order in which ties between them are broken. */
+	/* Each seed only depends on the histograms, so any number of them can be refined at once, each with its own state. */
+	const cc_bool xor_mode_enabled = seed / seeds_per_mode != 0;
+	const unsigned int kind = seed % seeds_per_mode;
+	const unsigned int decode_cycle_weight = state->decode_cycle_weight;
+	unsigned int i;
+
+	ComputeSeedCodes(state, xor_mode_enabled, kind);
+	state->ultra.best_total_cost = ULONG_MAX;
+
+	if (decode_cycle_weight != 0)
+	{
+		/* Parsing for decoding speed avoids the short runs that the refinement relies on to discover smaller codes, so
+		   the seed tends to get stuck on codes that are both large and slow. To avoid this, the seed is refined for size
+		   alone first, and the result is used as an extra seed when refining for decoding speed. */
+		unsigned long size_total_cost;
+
+		state->decode_cycle_weight = 0;
+		RefineCodes(state);
+		state->decode_cycle_weight = decode_cycle_weight;
+
+		memcpy(state->nybble_runs, state->ultra.best_nybble_runs, sizeof(state->nybble_runs));
+		state->ultra.best_total_cost = ULONG_MAX;
+		RefineCodes(state);
+
+		size_total_cost = state->ultra.best_total_cost;
+		memcpy(state->ultra.size_nybble_runs, state->ultra.best_nybble_runs, sizeof(state->nybble_runs));
+
+		ComputeSeedCodes(state, xor_mode_enabled, kind);
+		state->ultra.best_total_cost = ULONG_MAX;
+		RefineCodes(state);
+
+		if (size_total_cost <= state->ultra.best_total_cost)
+		{
+			state->ultra.best_total_cost = size_total_cost;
+			memcpy(state->ultra.best_nybble_runs, state->ultra.size_nybble_runs, sizeof(state->nybble_runs));
+		}
+	}
+	else
+	{
+		RefineCodes(state);
+	}
+
+	refined_seed->seed = seed;
+	refined_seed->total_cost = state->ultra.best_total_cost;
+	refined_seed->xor_mode_enabled = xor_mode_enabled;
+
+	for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
+	{
+		unsigned int j;
+
+		for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+		{
+			refined_seed->codes[i][j] = state->ultra.best_nybble_runs[i][j].code;
+			refined_seed->code_lengths[i][j] = state->ultra.best_nybble_runs[i][j].total_code_bits;
+		}
+	}
+}
+
+static void ReduceRefinedSeeds(ClownNemesis_RefinedSeed* const best, const ClownNemesis_RefinedSeed* const other)
+{
+	/* The smallest seed wins, and the earliest one in case of a tie, so the order in which seeds are reduced does not matter. */
+	if (other->total_cost < best->total_cost || (other->total_cost == best->total_cost && other->seed < best->seed))
+		*best = *other;
+}
+
+static void UseCodes(State* const state, const int xor_mode_enabled, const unsigned char (* const codes)[MAXIMUM_RUN_LENGTH], const unsigned char (* const code_lengths)[MAXIMUM_RUN_LENGTH])
+{
+	unsigned int i;
+
+	state->xor_mode_enabled = xor_mode_enabled != 0;
+
+	for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
+	{
+		unsigned int j;
+
+		for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+		{
+			state->nybble_runs[i][j].code = codes[i][j];
+			state->nybble_runs[i][j].total_code_bits = code_lengths[i][j];
+		}
+	}
+}
+
+static void UseRefinedSeed(State* const state, const ClownNemesis_RefinedSeed* const refined_seed)
+{
+	UseCodes(state, refined_seed->xor_mode_enabled, refined_seed->codes, refined_seed->code_lengths);
+}
+
+static void ComputeCodesUltra(State* const state, const unsigned int seeds_per_mode)
+{
+	ClownNemesis_RefinedSeed best_seed, refined_seed;
+	unsigned int seed;
+
+	/* Every seed starts from one of these, so they only need to be counted once. */
+	ComputeHistogramsBothModes(state, cc_false);
+
+	/* Every seed is refined separately, and the best result wins. */
+	RefineSeed(state, seeds_per_mode, 0, &best_seed);
+
+	for (seed = 1; seed < seeds_per_mode * 2; ++seed)
+	{
+		RefineSeed(state, seeds_per_mode, seed, &refined_seed);
+		ReduceRefinedSeeds(&best_seed, &refined_seed);
+	}
+
+	UseRefinedSeed(state, &best_seed);
+
+	/* When only size matters, the refinement has already measured the data exactly. */
+	if (state->decode_cycle_weight == 0)
+		CheckBudget(state, ComputeCompressedSize(best_seed.total_cost / 16, cc_false));
+}
+
+#undef ULTRA_MAXIMUM_ITERATIONS
+#undef ULTRA_PERTURBED_SCALE
+
+/*********************/
+/* End of Ultra Mode */
+/*********************/
+
+static void CheckInputSize(State* const state)
+{
+	const unsigned int total_tiles = state->bytes_read / BYTES_PER_TILE;
+
+	if (state->bytes_read % BYTES_PER_TILE != 0)
+	{
+	#ifdef CLOWNNEMESIS_DEBUG
+		fputs("Input data size is not a multiple of 0x20 bytes.\n", stderr);
+	#endif
+		longjmp(state->common.jump_buffer, 1);
+	}
+	else if (total_tiles > 0x7FFF)
+	{
+	#ifdef CLOWNNEMESIS_DEBUG
+		fputs("Input data is larger than the header allows.\n", stderr);
+	#endif
+		longjmp(state->common.jump_buffer, 1);
+	}
+}
+
+static void WriteOutputByte(State* const state, const unsigned int byte)
+{
+	/* Stop as soon as the data is over the budget, as the rest of it would only be thrown away. */
+	if (state->output_bytes_remaining == 0)
+		RejectOverBudget(state);
+
+	--state->output_bytes_remaining;
+	WriteByte(&state->common, byte);
+}
+
+static void EmitHeader(State* const state)
+{
+	const unsigned int total_tiles = state->bytes_read / BYTES_PER_TILE;
+
+	CheckInputSize(state);
+
+	WriteOutputByte(state, total_tiles >> 8 | state->xor_mode_enabled << 7);
+	WriteOutputByte(state, total_tiles & 0xFF);
+}
+
+static void EmitCodeTableEntry(State* const state, const unsigned int run_nybble, const unsigned int run_length_minus_one)
+{
+	NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length_minus_one];
+
+	if (nybble_run->total_code_bits != 0)
+	{
+	#ifdef CLOWNNEMESIS_DEBUG
+		fprintf(stderr, "Run of nybble %X of length %d occurred %d times (code is ", run_nybble, run_length_minus_one + 1, nybble_run->occurrences);
+
+		{
+			unsigned int i;
+			for (i = 0; i < 8; ++i)
+				fputc((nybble_run->code & 1 << (8 - 1 - i)) != 0 ? '1' : '0', stderr);
+		}
+
+		fprintf(stderr, ", length is %d).\n", nybble_run->total_code_bits);
+	#endif
+
+		if (run_nybble != state->previous_nybble)
+		{
+			state->previous_nybble = run_nybble;
+			WriteOutputByte(state, 0x80 | run_nybble);
+		}
+
+		WriteOutputByte(state, run_length_minus_one << 4 | nybble_run->total_code_bits);
+		WriteOutputByte(state, nybble_run->code);
+	}
+}
+
+static void EmitCodeTable(State* const state)
+{
+	/* Finally, emit the code table. */
+	state->previous_nybble = 0xFF; /* Deliberately invalid. */
+	IterateNybbleRuns(state, EmitCodeTableEntry);
+
+	/* Mark the end of the code table. */
+	WriteOutputByte(state, 0xFF);
+
+#ifdef CLOWNNEMESIS_DEBUG
+	fprintf(stderr, "Total runs: %d\n", state->total_runs);
+#endif
+}
+
+static void WriteBits(State* const state, const unsigned int bits, const unsigned int total_bits)
+{
+	/* The bits are added all at once, and then written a whole byte at a time, instead of a bit at a time. */
+	/* Bits above the pending ones are left as garbage, as only the lowest 8 bits of a shift are ever written. */
+	/* 'unsigned long' is at least 32 bits, which fits the 7 pending bits plus the 13 bits of the longest write. */
+	state->output_bit_buffer <<= total_bits;
+	state->output_bit_buffer |= bits;
+	state->output_bits_done += total_bits;
+
+	while (state->output_bits_done >= 8)
+	{
+		state->output_bits_done -= 8;
+		WriteOutputByte(state, (state->output_bit_buffer >> state->output_bits_done) & 0xFF);
+	}
+}
+
+static void EmitCode(State* const state, const unsigned int run_nybble, const unsigned int run_length)
+{
+	const NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length - 1];
+
+	if (nybble_run->total_code_bits != 0)
+	{
+	#ifdef CLOWNNEMESIS_DEBUG
+		unsigned int i;
+
+		fputs("Emitting code ", stderr);
+
+		for (i = 0; i < 8; ++i)
+			fputc((nybble_run->code & (1 << (8 - 1 - i))) != 0 ? '1' : '0', stderr);
+
+		fprintf(stderr, " of length %d for nybble %X of length %d.\n", nybble_run->total_code_bits, run_nybble, run_length);
+	#endif
+
+		WriteBits(state, nybble_run->code, nybble_run->total_code_bits);
+	}
+	else
+	{
+	#ifdef CLOWNNEMESIS_DEBUG
+		fprintf(stderr, "Emitting reject for nybble %X of length %d.\n", run_nybble, run_length);
+	#endif
+
+		/* This run doesn't have a code, so inline it. */
+		/* This is the 6-bit inline marker, followed by the 3-bit run length and the 4-bit nybble. */
+		WriteBits(state, 0x3F << (3 + 4) | (run_length - 1) << 4 | run_nybble, 6 + 3 + 4);
+	}
+}
+
+#define FIND_RUNS_NAME FindRunsEmitCodeRegular
+#define FIND_RUNS_CALLBACK EmitCode
+#define FIND_RUNS_XOR_MODE_ENABLED 0
+#include "compress-find-runs.h"
+
+#define FIND_RUNS_NAME FindRunsEmitCodeXOR
+#define FIND_RUNS_CALLBACK EmitCode
+#define FIND_RUNS_XOR_MODE_ENABLED 1
+#include "compress-find-runs.h"
+
+static void FindRunsEmitCode(State* const state)
+{
+	/* Finds every run in the input data and passes it to 'EmitCode'. */
+	if (UseRecompressionSource(state))
+		IterateRecompressionSource(state, EmitCode);
+	else if (state->xor_mode_enabled)
+		FindRunsEmitCodeXOR(state);
+	else
+		FindRunsEmitCodeRegular(state);
+}
+
+static void EmitCodes(State* const state, const cc_bool accurate, const cc_bool optimal_parse)
+{
+	/* Sega's compressor always used the longest runs possible, which is faster but produces larger data. */
+	if (optimal_parse)
+		ParseRuns(state, EmitCode);
+	else
+		FindRunsEmitCode(state);
+
+	/* Output any codes that haven't yet been flushed. */
+	/* Foolishly, Sega's compressor would redundantly emit an empty byte here if there are no unflushed bits. */
+	if (state->output_bits_done != 0 || accurate)
+		WriteOutputByte(state, (state->output_bit_buffer << (8 - state->output_bits_done)) & 0xFF);
+}
+
+static void ResetState(State* const state)
+{
+	/* Only the parts of the state which are not set by the compression passes themselves need resetting. */
+	/* In particular, this avoids clearing the large tables of the code generators. */
+	IterateNybbleRuns(state, ResetNybbleRun);
+
+	state->total_runs = 0;
+	state->bytes_read = 0;
+	state->total_bits = 0;
+	state->output_bit_buffer = 0;
+	state->output_bits_done = 0;
+	state->output_bytes_remaining = ULONG_MAX;
+	state->over_budget = cc_false;
+	state->stretch_length = 0;
+	state->stretch_nybble = 0;
+	state->xor_mode_enabled = cc_false;
+	state->decode_cycle_weight = 0;
+	state->table_cost_weight = 1;
+	state->recompression_source = NULL;
+	state->known_histogram = NULL;
+	memset(state->initial_previous_row, 0, sizeof(state->initial_previous_row));
+}
+
+/* Decoding speed is favoured in levels, each of which favours it this many times as much as the one before. */
+#define DECODE_CYCLE_WEIGHT_STEP 4
+
+static unsigned int DecodeCycleWeight(const ClownNemesis_CompressOptions* const options)
+{
+	/* Keep the weight small enough that the costs of the runs cannot overflow. */
+	const unsigned int decode_speed = options->accurate ? 0 : CC_CLAMP(0, 64, options->decode_speed);
+	unsigned int decode_cycle_weight;
+
+	if (decode_speed == 0)
+		return 0;
+
+	/* Round down to a level. */
+	for (decode_cycle_weight = 1; decode_cycle_weight * DECODE_CYCLE_WEIGHT_STEP <= decode_speed; decode_cycle_weight *= DECODE_CYCLE_WEIGHT_STEP);
+
+	return decode_cycle_weight;
+}
+
+static unsigned int SeedsPerMode(const ClownNemesis_CompressOptions* const options)
+{
+	/* Only the ultra mode uses seeds. */
+	if (options->accurate || options->effort < CLOWNNEMESIS_EFFORT_HIGH)
+		return 0;
+	else if (options->effort == CLOWNNEMESIS_EFFORT_HIGH)
+		return ULTRA_SEED_OPTIMAL + 1;
+	else
+		return ULTRA_TOTAL_SEEDS;
+}
+
+static cc_bool UsesOptimalParse(const ClownNemesis_CompressOptions* const options)
+{
+	return !options->accurate && options->effort > CLOWNNEMESIS_EFFORT_FASTEST;
+}
+
+static void ComputeCodesForWeight(State* const state, const ClownNemesis_CompressOptions* const options, const unsigned int decode_cycle_weight)
+{
+	state->decode_cycle_weight = decode_cycle_weight;
+
+	if (options->accurate)
+		ComputeCodes(state, cc_true);
+	else if (options->effort <= CLOWNNEMESIS_EFFORT_FASTEST)
+		ComputeCodesFast(state, cc_true);
+	else if (options->effort == CLOWNNEMESIS_EFFORT_FAST)
+		ComputeCodesFast(state, cc_false);
+	else if (options->effort == CLOWNNEMESIS_EFFORT_NORMAL)
+	{
+		ComputeCodes(state, cc_false);
+		RefineComputedCodes(state);
+
+		/* As in ultra mode, when only size matters, the refinement has already measured the data exactly. */
+		if (decode_cycle_weight == 0)
+			CheckBudget(state, ComputeCompressedSize(state->ultra.best_total_cost / 16, cc_false));
+	}
+	else
+		ComputeCodesUltra(state, SeedsPerMode(options));
+}
+
+static void ComputeCodesForOptions(State* const state, const ClownNemesis_CompressOptions* const options)
+{
+	/* Favouring decoding speed more must never make the data slower to decode, but the codes are only made */
+	/* heuristically, so that is not certain for any one weight. Instead, the codes are made for every level up to the */
+	/* one that was asked for, and each level only replaces the codes of the levels below it if it decodes faster. */
+	NybbleRun best_nybble_runs[MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH];
+	unsigned long best_decode_cycles, output_bytes_remaining;
+	unsigned int decode_cycle_weight, best_decode_cycle_weight;
+	cc_bool best_xor_mode_enabled;
+
+	const unsigned int maximum_decode_cycle_weight = DecodeCycleWeight(options);
+
+	if (maximum_decode_cycle_weight == 0 || !UsesOptimalParse(options))
+	{
+		ComputeCodesForWeight(state, options, maximum_decode_cycle_weight);
+		return;
+	}
+
+	/* The levels that are not used may well be over the budget, so the budget is only checked once the data is emitted. */
+	output_bytes_remaining = state->output_bytes_remaining;
+	state->output_bytes_remaining = ULONG_MAX;
+
+	best_decode_cycles = ULONG_MAX;
+	best_decode_cycle_weight = 0;
+	best_xor_mode_enabled = cc_false;
+
+	for (decode_cycle_weight = 0; decode_cycle_weight <= maximum_decode_cycle_weight; decode_cycle_weight = decode_cycle_weight == 0 ? 1 : decode_cycle_weight * DECODE_CYCLE_WEIGHT_STEP)
+	{
+		unsigned long decode_cycles;
+
+		ComputeCodesForWeight(state, options, decode_cycle_weight);
+		ComputeParsedTotalBits(state);
+		decode_cycles = ComputeParsedDecodeCycles(state);
+
+		if (decode_cycles < best_decode_cycles)
+		{
+			best_decode_cycles = decode_cycles;
+			best_decode_cycle_weight = decode_cycle_weight;
+			best_xor_mode_enabled = state->xor_mode_enabled;
+			memcpy(best_nybble_runs, state->nybble_runs, sizeof(best_nybble_runs));
+		}
+	}
+
+	state->output_bytes_remaining = output_bytes_remaining;
+	state->decode_cycle_weight = best_decode_cycle_weight;
+	state->xor_mode_enabled = best_xor_mode_enabled;
+	memcpy(state->nybble_runs, best_nybble_runs, sizeof(best_nybble_runs));
+}
+
+#undef DECODE_CYCLE_WEIGHT_STEP
+
+static int Compress(State* const state, const ClownNemesis_CompressOptions* const options, const RecompressionSource* const recompression_source, const ClownNemesis_TrainingHistogram* const known_histogram, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	int success;
+
+	const cc_bool accurate = options->accurate != 0;
+
+	success = 0;
+
+	ResetState(state);
+	InitialiseCommon(&state->common, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+	state->common.throw_on_eof = cc_false;
+
+	state->recompression_source = recompression_source;
+	state->known_histogram = known_histogram;
+
+	if (options->max_output_bytes != 0)
+		state->output_bytes_remaining = options->max_output_bytes;
+
+	if (!setjmp(state->common.jump_buffer))
+	{
+		ComputeCodesForOptions(state, options);
+
+		EmitHeader(state);
+		EmitCodeTable(state);
+		EmitCodes(state, accurate, UsesOptimalParse(options));
+
+		success = 1;
+	}
+	else if (state->over_budget)
+	{
+		success = CLOWNNEMESIS_OVER_BUDGET;
+	}
+
+	return success;
+}
+
+static int RefineSeedOfInput(State* const state, const ClownNemesis_CompressOptions* const options, const unsigned int seed, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, ClownNemesis_RefinedSeed* const refined_seed)
+{
+	int success;
+
+	success = 0;
+
+	ResetState(state);
+	InitialiseCommon(&state->common, read_byte, read_byte_user_data, NULL, NULL);
+	state->common.throw_on_eof = cc_false;
+
+	if (!setjmp(state->common.jump_buffer))
+	{
+		state->decode_cycle_weight = DecodeCycleWeight(options);
+
+		ComputeHistogramsBothModes(state, cc_false);
+		RefineSeed(state, SeedsPerMode(options), seed, refined_seed);
+
+		success = 1;
+	}
+
+	return success;
+}
+
+static int CompressWithRefinedSeed(State* const state, const ClownNemesis_CompressOptions* const options, const ClownNemesis_RefinedSeed* const refined_seed, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	int success;
+
+	success = 0;
+
+	ResetState(state);
+	InitialiseCommon(&state->common, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+	state->common.throw_on_eof = cc_false;
+
+	if (options->max_output_bytes != 0)
+		state->output_bytes_remaining = options->max_output_bytes;
+
+	if (!setjmp(state->common.jump_buffer))
+	{
+		/* The codes are already known, so the input only needs to be read to find its size for the header. */
+		state->decode_cycle_weight = DecodeCycleWeight(options);
+		UseRefinedSeed(state, refined_seed);
+		CountInputBytes(state);
+
+		EmitHeader(state);
+		EmitCodeTable(state);
+		EmitCodes(state, cc_false, cc_true);
+
+		success = 1;
+	}
+	else if (state->over_budget)
+	{
+		success = CLOWNNEMESIS_OVER_BUDGET;
+	}
+
+	return success;
+}
+
+/*******************/
+/* Size Estimation */
+/*******************/
+
+static void ClearOccurrences(State* const state, const unsigned int run_nybble, const unsigned int run_length_minus_one)
+{
+	state->nybble_runs[run_nybble][run_length_minus_one].occurrences = 0;
+}
+
+static unsigned long EstimateCompressedSize(State* const state, const ClownNemesis_CompressOptions* const options, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data)
+{
+	unsigned long size;
+
+	size = 0;
+
+	ResetState(state);
+	InitialiseCommon(&state->common, read_byte, read_byte_user_data, NULL, NULL);
+	state->common.throw_on_eof = cc_false;
+
+	if (!setjmp(state->common.jump_buffer))
+	{
+		ComputeCodesForOptions(state, options);
+		CheckInputSize(state);
+
+		/* Rather than emitting the data, count the runs that would be emitted, and total up their codes. */
+		if (UsesOptimalParse(options))
+		{
+			ComputeParsedTotalBits(state);
+		}
+		else
+		{
+			IterateNybbleRuns(state, ClearOccurrences);
+			FindRunsLogOccurrence(state);
+			ComputeTotalEncodedBits(state);
+		}
+
+		size = ComputeCompressedSize(state->total_bits, options->accurate != 0);
+	}
+
+	return size;
+}
+
+static unsigned long EstimateCompressedSizeSampled(State* const state, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data)
+{
+	unsigned long size;
+
+	size = 0;
+
+	ResetState(state);
+	InitialiseCommon(&state->common, read_byte, read_byte_user_data, NULL, NULL);
+	state->common.throw_on_eof = cc_false;
+
+	if (!setjmp(state->common.jump_buffer))
+	{
+		unsigned long best_size;
+		unsigned int total_tiles, sampled_tiles;
+		unsigned int i;
+
+		best_size = 0;
+
+		ComputeHistogramsBothModes(state, cc_true);
+		CheckInputSize(state);
+
+		total_tiles = state->bytes_read / BYTES_PER_TILE;
+		sampled_tiles = CC_DIVIDE_CEILING(total_tiles, SAMPLED_TILE_INTERVAL);
+
+		/* Make optimal codes for the sampled tiles in both modes, and assume that the rest of the tiles are like them. */
+		/* The code table is the same size regardless of how many tiles there are, so only the codes are scaled up. */
+		for (i = 0; i < 2; ++i)
+		{
+			unsigned long code_bits, mode_size;
+			unsigned int j;
+
+			UseHistogram(state, (cc_bool)i);
+			ComputeCodesOptimal(state);
+			ComputeTotalEncodedBits(state);
+
+			code_bits = 0;
+
+			for (j = 0; j < TOTAL_SYMBOLS; ++j)
+			{
+				const NybbleRun* const nybble_run = NybbleRunFromIndex(state, j);
+
+				code_bits += (unsigned long)RunBits(state, j % MAXIMUM_RUN_NYBBLE, j / MAXIMUM_RUN_NYBBLE + 1) * nybble_run->occurrences;
+			}
+
+			mode_size = state->total_bits - code_bits;
+
+			if (sampled_tiles != 0)
+				mode_size += code_bits / sampled_tiles * total_tiles + code_bits % sampled_tiles * total_tiles / sampled_tiles;
+
+			mode_size = ComputeCompressedSize(mode_size, cc_false);
+
+			if (i == 0 || mode_size < best_size)
+				best_size = mode_size;
+		}
+
+		size = best_size;
+	}
+
+	return size;
+}
+
+/**************************/
+/* End of Size Estimation */
+/**************************/
+
+/*************/
+/* Splitting */
+/*************/
+
+/* Splitting data into multiple archives costs an extra header and code table for each of them, but lets each part of the data */
+/* have codes that suit it. To find the best places to split the data, the cost of every possible archive is computed from the */
+/* differences of histograms of the data before each candidate cut point, and then the cheapest sequence of archives is found. */
+
+#define MAXIMUM_TILES_PER_ARCHIVE 0x7FFF
+
+typedef struct TileReader
+{
+	const unsigned char *tiles;
+	size_t size, position;
+} TileReader;
+
+typedef struct Splitter
+{
+	State state;
+	/* The occurrences of each nybble run before each candidate cut point, in both regular mode and XOR mode. */
+	unsigned int prefix_histograms[CLOWNNEMESIS_MAXIMUM_SEGMENTS + 1][2][MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH];
+	/* The cheapest cost of the data before each candidate cut point, and the cut point before it which achieves that cost. */
+	unsigned long best_costs[CLOWNNEMESIS_MAXIMUM_SEGMENTS + 1];
+	unsigned int best_previous_cut_points[CLOWNNEMESIS_MAXIMUM_SEGMENTS + 1];
+} Splitter;
+
+static void ComputePrefixHistograms(Splitter* const splitter, const unsigned long tiles_per_cut_point)
+{
+	State* const state = &splitter->state;
+	RunFinder run_finders[2];
+	unsigned char previous_row[4];
+	unsigned int cut_point;
+	unsigned int i;
+
+	for (i = 0; i < 2; ++i)
+	{
+		unsigned int j;
+
+		for (j = 0; j < MAXIMUM_RUN_NYBBLE; ++j)
+		{
+			unsigned int k;
+
+			for (k = 0; k < MAXIMUM_RUN_LENGTH; ++k)
+				state->histograms[i][j][k] = 0;
+		}
+
+		run_finders[i].length = 0;
+	}
+
+	cut_point = 0;
+
+	for (state->bytes_read = 0; ; ++state->bytes_read)
+	{
+		const int value = ReadByte(&state->common);
+
+		if (value == CLOWNNEMESIS_EOF || state->bytes_read % (tiles_per_cut_point * BYTES_PER_TILE) == 0)
+		{
+			/* Archives are decompressed separately, so runs and the XOR of the previous row stop at the cut points. */
+			FlushRunFinder(&run_finders[0], state->histograms[0]);
+			FlushRunFinder(&run_finders[1], state->histograms[1]);
+
+			for (i = 0; i < CC_COUNT_OF(previous_row); ++i)
+				previous_row[i] = 0;
+
+			memcpy(splitter->prefix_histograms[cut_point++], state->histograms, sizeof(state->histograms));
+		}
+
+		if (value == CLOWNNEMESIS_EOF)
+			break;
+
+		{
+		const unsigned int xored_value = value ^ previous_row[state->bytes_read % CC_COUNT_OF(previous_row)];
+
+		previous_row[state->bytes_read % CC_COUNT_OF(previous_row)] = value;
+
+		FeedRunFinder(&run_finders[0], state->histograms[0], (value >> 4) & 0xF);
+		FeedRunFinder(&run_finders[0], state->histograms[0], value & 0xF);
+		FeedRunFinder(&run_finders[1], state->histograms[1], (xored_value >> 4) & 0xF);
+		FeedRunFinder(&run_finders[1], state->histograms[1], xored_value & 0xF);
+		}
+	}
+}
+
+static int ReadTiles(void* const user_data)
+{
+	TileReader* const reader = (TileReader*)user_data;
+
+	if (reader->position == reader->size)
+	{
+		reader->position = 0;
+		return CLOWNNEMESIS_EOF;
+	}
+
+	return reader->tiles[reader->position++];
+}
+
+static unsigned long ComputeSegmentCost(Splitter* const splitter, const unsigned int first_cut_point, const unsigned int last_cut_point)
+{
+	State* const state = &splitter->state;
+	unsigned long best_cost;
+	unsigned int i;
+
+	best_cost = ULONG_MAX;
+
+	for (i = 0; i < 2; ++i)
+	{
+		unsigned long cost;
+		unsigned int j;
+
+		for (j = 0; j < MAXIMUM_RUN_NYBBLE; ++j)
+		{
+			unsigned int k;
+
+			for (k = 0; k < MAXIMUM_RUN_LENGTH; ++k)
+			{
+				NybbleRun* const nybble_run = &state->nybble_runs[j][k];
+
+				nybble_run->occurrences = splitter->prefix_histograms[last_cut_point][i][j][k] - splitter->prefix_histograms[first_cut_point][i][j][k];
+				nybble_run->code = nybble_run->total_code_bits = 0;
+			}
+		}
+
+		/* Quickly-made codes are good enough for comparing archives, and are far faster than making optimal codes for every one. */
+		ComputeCodesHeuristic(state);
+		ComputeTotalEncodedBits(state);
+
+		cost = ComputeCompressedSize(state->total_bits, cc_false);
+
+		if (cost < best_cost)
+			best_cost = cost;
+	}
+
+	return best_cost;
+}
+
+static size_t Split(Splitter* const splitter, ClownNemesis_Segment* const segments, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data)
+{
+	State* const state = &splitter->state;
+	size_t total_segments;
+
+	total_segments = 0;
+
+	ResetState(state);
+	InitialiseCommon(&state->common, read_byte, read_byte_user_data, NULL, NULL);
+	state->common.throw_on_eof = cc_false;
+
+	if (!setjmp(state->common.jump_buffer))
+	{
+		unsigned long total_tiles, tiles_per_cut_point;
+		unsigned int total_cut_points, cut_point;
+
+		CountInputBytes(state);
+
+		if (state->bytes_read % BYTES_PER_TILE != 0)
+			longjmp(state->common.jump_buffer, 1);
+
+		/* Only consider a limited number of cut points, spaced evenly across the data, to keep the number of possible archives manageable. */
+		total_tiles = state->bytes_read / BYTES_PER_TILE;
+		tiles_per_cut_point = CC_MAX(1, CC_DIVIDE_CEILING(total_tiles, CLOWNNEMESIS_MAXIMUM_SEGMENTS));
+
+		if (tiles_per_cut_point > MAXIMUM_TILES_PER_ARCHIVE)
+			longjmp(state->common.jump_buffer, 1);
+
+		ComputePrefixHistograms(splitter, tiles_per_cut_point);
+
+		total_cut_points = (unsigned int)CC_DIVIDE_CEILING(total_tiles, tiles_per_cut_point);
+
+		/* Find the cheapest way to reach each cut point. */
+		splitter->best_costs[0] = 0;
+
+		for (cut_point = 1; cut_point <= total_cut_points; ++cut_point)
+		{
+			const unsigned long tile = CC_MIN(total_tiles, cut_point * tiles_per_cut_point);
+			unsigned int previous_cut_point;
+
+			splitter->best_costs[cut_point] = ULONG_MAX;
+
+			for (previous_cut_point = cut_point; previous_cut_point-- != 0; )
+			{
+				unsigned long cost;
+
+				/* Archives cannot be longer than the header allows. */
+				if (tile - previous_cut_point * tiles_per_cut_point > MAXIMUM_TILES_PER_ARCHIVE)
+					break;
+
+				cost = splitter->best_costs[previous_cut_point] + ComputeSegmentCost(splitter, previous_cut_point, cut_point);
+
+				if (cost < splitter->best_costs[cut_point])
+				{
+					splitter->best_costs[cut_point] = cost;
+					splitter->best_previous_cut_points[cut_point] = previous_cut_point;
+				}
+			}
+		}
+
+		/* Count the archives by backtracking, and then backtrack again to output them in order. */
+		for (cut_point = total_cut_points; cut_point != 0; cut_point = splitter->best_previous_cut_points[cut_point])
+			++total_segments;
+
+		{
+		size_t segment_index = total_segments;
+
+		for (cut_point = total_cut_points; cut_point != 0; cut_point = splitter->best_previous_cut_points[cut_point])
+		{
+			ClownNemesis_Segment* const segment = &segments[--segment_index];
+
+			segment->first_tile = splitter->best_previous_cut_points[cut_point] * tiles_per_cut_point;
+			segment->total_tiles = CC_MIN(total_tiles, cut_point * tiles_per_cut_point) - segment->first_tile;
+		}
+		}
+
+		/* Empty data is still a single (empty) archive. */
+		if (total_segments == 0)
+		{
+			segments[0].first_tile = segments[0].total_tiles = 0;
+			total_segments = 1;
+		}
+	}
+
+	return total_segments;
+}
+
+static size_t KeepSplitIfSmaller(Splitter* const splitter, ClownNemesis_Segment* const segments, const size_t total_segments, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data)
+{
+	/* The costs of the archives are only estimates, so, if all of the data fits in a single archive, then make sure that */
+	/* the archives are really smaller than it, by measuring them exactly as they would be compressed by default. */
+	const unsigned long total_tiles = segments[total_segments - 1].first_tile + segments[total_segments - 1].total_tiles;
+	const size_t total_bytes = total_tiles * BYTES_PER_TILE;
+
+	ClownNemesis_CompressOptions options;
+	unsigned long whole_size, split_size;
+	TileReader reader;
+	unsigned char *tiles;
+	size_t i;
+
+	if (total_segments == 1 || total_tiles > MAXIMUM_TILES_PER_ARCHIVE)
+		return total_segments;
+
+	tiles = (unsigned char*)malloc(total_bytes);
+
+	if (tiles == NULL)
+		return 0;
+
+	/* The input was already read to its end, so it has been rewound, and reading it to its end again rewinds it again. */
+	for (i = 0; i <= total_bytes; ++i)
+	{
+		const int value = read_byte((void*)read_byte_user_data);
+
+		if (value == CLOWNNEMESIS_ERROR || (value == CLOWNNEMESIS_EOF) != (i == total_bytes))
+		{
+			free(tiles);
+			return 0;
+		}
+
+		if (i != total_bytes)
+			tiles[i] = (unsigned char)value;
+	}
+
+	ClownNemesis_DefaultCompressOptions(&options);
+
+	reader.tiles = tiles;
+	reader.size = total_bytes;
+	reader.position = 0;
+
+	whole_size = EstimateCompressedSize(&splitter->state, &options, ReadTiles, &reader);
+	split_size = 0;
+
+	for (i = 0; i < total_segments && whole_size != 0; ++i)
+	{
+		unsigned long size;
+
+		reader.tiles = &tiles[segments[i].first_tile * BYTES_PER_TILE];
+		reader.size = segments[i].total_tiles * BYTES_PER_TILE;
+		reader.position = 0;
+
+		size = EstimateCompressedSize(&splitter->state, &options, ReadTiles, &reader);
+
+		if (size == 0)
+			whole_size = 0;
+
+		split_size += size;
+	}
+
+	free(tiles);
+
+	if (whole_size == 0)
+		return 0;
+
+	if (whole_size > split_size)
+		return total_segments;
+
+	segments[0].first_tile = 0;
+	segments[0].total_tiles = total_tiles;
+
+	return 1;
+}
+
+#undef MAXIMUM_TILES_PER_ARCHIVE
+
+/********************/
+/* End of Splitting */
+/********************/
+
+/*****************/
+/* Recompression */
+/*****************/
+
+static int LogSourceRun(void* const user_data, const unsigned int nybble, const unsigned int run_length)
+{
+	RecompressionSource* const source = (RecompressionSource*)user_data;
+	unsigned int remaining;
+
+	source->total_nybbles += run_length;
+
+	/* Join the run onto the previous one if it is the same nybble, so that the runs are the same as those that */
+	/* the run-finding loop would find, regardless of how the data was split into runs when it was compressed. */
+	remaining = run_length;
+
+	if (source->total_runs != 0 && (source->runs[source->total_runs - 1] & 0xF) == nybble)
+	{
+		const unsigned int previous_length = (source->runs[source->total_runs - 1] >> 4) + 1;
+		const unsigned int joined_length = CC_MIN(MAXIMUM_RUN_LENGTH, previous_length + remaining);
+
+		source->runs[source->total_runs - 1] = (unsigned char)((joined_length - 1) << 4 | nybble);
+		remaining -= joined_length - previous_length;
+	}
+
+	if (remaining != 0)
+	{
+		if (source->total_runs == source->capacity)
+		{
+			unsigned char *new_runs;
+
+			const size_t new_capacity = source->capacity == 0 ? 0x100 : source->capacity * 2;
+
+			if (source->capacity > (size_t)-1 / 2)
+				return CLOWNNEMESIS_ERROR;
+
+			new_runs = (unsigned char*)realloc(source->runs, new_capacity);
+
+			if (new_runs == NULL)
+				return CLOWNNEMESIS_ERROR;
+
+			source->runs = new_runs;
+			source->capacity = new_capacity;
+		}
+
+		source->runs[source->total_runs++] = (unsigned char)((remaining - 1) << 4 | nybble);
+	}
+
+	return 0;
+}
+
+static int ReadRecompressionSource(void* const user_data)
+{
+	/* Turns the runs back into bytes, one row at a time, for when the data is being compressed in the other mode. */
+	RecompressionSource* const source = (RecompressionSource*)user_data;
+
+	if (source->row_bytes_remaining == 0)
+	{
+		unsigned int i;
+
+		if (source->run_index == source->total_runs)
+		{
+			/* Go back to the start, ready for the next pass. */
+			source->run_index = 0;
+			source->run_nybbles_remaining = 0;
+			source->previous_row = 0;
+			return CLOWNNEMESIS_EOF;
+		}
+
+		for (i = 0; i < 8; ++i)
+		{
+			if (source->run_nybbles_remaining == 0)
+				source->run_nybbles_remaining = (source->runs[source->run_index] >> 4) + 1;
+
+			source->row = source->row << 4 | (source->runs[source->run_index] & 0xF);
+
+			if (--source->run_nybbles_remaining == 0)
+				++source->run_index;
+		}
+
+		/* Undo the XOR that the data was compressed with. */
+		if (source->xor_mode_enabled)
+			source->row ^= source->previous_row;
+
+		source->row &= 0xFFFFFFFF;
+		source->previous_row = source->row;
+		source->row_bytes_remaining = 4;
+	}
+
+	--source->row_bytes_remaining;
+
+	return (source->row >> source->row_bytes_remaining * 8) & 0xFF;
+}
+
+static int Recompress(State* const state, const ClownNemesis_CompressOptions* const options, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	int success, xor_mode_enabled;
+	RecompressionSource source;
+
+	success = 0;
+
+	source.runs = NULL;
+	source.total_runs = source.capacity = 0;
+	source.total_nybbles = 0;
+
+	if (ClownNemesis_DecompressRuns(read_byte, read_byte_user_data, &xor_mode_enabled, LogSourceRun, &source))
+	{
+		source.xor_mode_enabled = xor_mode_enabled != 0;
+		source.run_index = 0;
+		source.run_nybbles_remaining = 0;
+		source.row = source.previous_row = 0;
+		source.row_bytes_remaining = 0;
+
+		success = Compress(state, options, &source, NULL, ReadRecompressionSource, &source, write_byte, write_byte_user_data);
+	}
+
+	free(source.runs);
+
+	return success;
+}
+
+/************************/
+/* End of Recompression */
+/************************/
+
+static cc_bool UseCodeTable(State* const state, const ClownNemesis_CodeTable* const table)
+{
+	unsigned int space;
+	unsigned int i;
+
+	space = 0;
+
+	state->xor_mode_enabled = table->xor_mode_enabled != 0;
+
+	for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
+	{
+		unsigned int j;
+
+		for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+		{
+			const unsigned int total_code_bits = table->code_lengths[i][j];
+
+			if (total_code_bits > MAXIMUM_BITS)
+				return cc_false;
+
+			if (total_code_bits != 0)
+				space += CODE_SPACE_USED(total_code_bits);
+
+			state->nybble_runs[i][j].total_code_bits = total_code_bits;
+		}
+	}
+
+	/* The codes must not overlap each other or the inline marker. */
+	if (space > AVAILABLE_CODE_SPACE)
+		return cc_false;
+
+	ComputeCodesFromLengths(state);
+
+	return cc_true;
+}
+
+static int CompressWithTable(State* const state, const ClownNemesis_CodeTable* const table, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	int success;
+
+	success = 0;
+
+	ResetState(state);
+	InitialiseCommon(&state->common, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+	state->common.throw_on_eof = cc_false;
+
+	if (!UseCodeTable(state, table))
+	{
+	#ifdef CLOWNNEMESIS_DEBUG
+		fputs("Code table is invalid.\n", stderr);
+	#endif
+	}
+	else if (!setjmp(state->common.jump_buffer))
+	{
+		/* The codes are already known, so the input only needs to be read to find its size for the header. */
+		CountInputBytes(state);
+
+		EmitHeader(state);
+		EmitCodeTable(state);
+		EmitCodes(state, cc_false, cc_true);
+
+		success = 1;
+	}
+
+	return success;
+}
+
+static void UseTrainingHistogram(State* const state, const ClownNemesis_TrainingHistogram* const histogram, const cc_bool xor_mode_enabled)
+{
+	unsigned long total_occurrences;
+	unsigned int shift;
+	unsigned int i;
+
+	total_occurrences = 0;
+
+	for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
+	{
+		unsigned int j;
+
+		for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+			total_occurrences += histogram->occurrences[xor_mode_enabled][i][j];
+	}
+
+	/* A large corpus can have enough runs to overflow the costs, so scale the occurrences down to keep them in range. */
+	/* Rarely-seen runs are rounded up, so that they are not forgotten entirely. */
+	/* Every file stores its own copy of the code table, so the table is paid for once per file, scaled the same way. */
+	for (shift = 0; total_occurrences >> shift > 0xFFFFFF || histogram->total_files >> shift > 0xFFFF; ++shift);
+
+	state->xor_mode_enabled = xor_mode_enabled;
+	state->table_cost_weight = (unsigned int)CC_MAX(1, CC_DIVIDE_CEILING(histogram->total_files, 1ul << shift));
+
+	for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
+	{
+		unsigned int j;
+
+		for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+		{
+			NybbleRun* const nybble_run = &state->nybble_runs[i][j];
+			const unsigned long occurrences = histogram->occurrences[xor_mode_enabled][i][j];
+
+			nybble_run->occurrences = (unsigned int)CC_DIVIDE_CEILING(occurrences, 1ul << shift);
+			nybble_run->code = nybble_run->total_code_bits = 0;
+		}
+	}
+}
+
+static void CountStretch(unsigned long (* const occurrences)[MAXIMUM_RUN_LENGTH], const unsigned int nybble, const unsigned long length)
+{
+	/* A stretch of identical nybbles is split into the longest runs possible, like the run-finding loop does. */
+	occurrences[nybble][MAXIMUM_RUN_LENGTH - 1] += length / MAXIMUM_RUN_LENGTH;
+
+	if (length % MAXIMUM_RUN_LENGTH != 0)
+		++occurrences[nybble][length % MAXIMUM_RUN_LENGTH - 1];
+}
+
+static void CountPartialNybble(ClownNemesis_PartialHistogram* const partial, const unsigned int mode, const unsigned int nybble)
+{
+	/* While counting, the last stretch is the one that is currently being added to. */
+	if (partial->last_length[mode] != 0 && nybble != partial->last_nybble[mode])
+	{
+		if (partial->first_length[mode] == 0)
+		{
+			partial->first_nybble[mode] = partial->last_nybble[mode];
+			partial->first_length[mode] = partial->last_length[mode];
+		}
+		else
+		{
+			CountStretch(partial->histogram.occurrences[mode], partial->last_nybble[mode], partial->last_length[mode]);
+		}
+
+		partial->last_length[mode] = 0;
+	}
+
+	partial->last_nybble[mode] = (unsigned char)nybble;
+	++partial->last_length[mode];
+}
+
+static void CountPartialHistogram(ClownNemesis_PartialHistogram* const partial, const unsigned char* const previous_row, StateCommon* const common)
+{
+	unsigned char row[4];
+	unsigned int i;
+
+	for (i = 0; i < CC_COUNT_OF(row); ++i)
+		row[i] = previous_row != NULL ? previous_row[i] : 0;
+
+	for (;;)
+	{
+		const int value = ReadByte(common);
+		unsigned int xored_value;
+
+		if (value == CLOWNNEMESIS_EOF)
+			break;
+
+		xored_value = value ^ row[partial->total_bytes % CC_COUNT_OF(row)];
+		row[partial->total_bytes % CC_COUNT_OF(row)] = value;
+		++partial->total_bytes;
+
+		CountPartialNybble(partial, 0, (value >> 4) & 0xF);
+		CountPartialNybble(partial, 0, value & 0xF);
+		CountPartialNybble(partial, 1, (xored_value >> 4) & 0xF);
+		CountPartialNybble(partial, 1, xored_value & 0xF);
+	}
+
+	if (partial->total_bytes % CC_COUNT_OF(row) != 0)
+		longjmp(common->jump_buffer, 1);
+
+	/* If there was only one stretch, then it is both the first and the last one, and is kept as the first one. */
+	for (i = 0; i < 2; ++i)
+	{
+		if (partial->first_length[i] == 0)
+		{
+			partial->first_nybble[i] = partial->last_nybble[i];
+			partial->first_length[i] = partial->last_length[i];
+			partial->last_length[i] = 0;
+		}
+	}
+}
+
+/****************/
+/* Bitmap Input */
+/****************/
+
+static void StartBitmapRow(ClownNemesis_BitmapReader* const reader)
+{
+	const ClownNemesis_Bitmap* const bitmap = &reader->bitmap;
+	const size_t tiles_across = bitmap->width / 8;
+	const size_t tiles_down = bitmap->height / 8;
+	size_t tile_x, tile_y;
+
+	if (bitmap->tile_order == CLOWNNEMESIS_TILE_ORDER_COLUMNS)
+	{
+		tile_x = reader->tile / tiles_down;
+		tile_y = reader->tile % tiles_down;
+	}
+	else
+	{
+		tile_x = reader->tile % tiles_across;
+		tile_y = reader->tile / tiles_across;
+	}
+
+	/* A row of a tile is always 4 bytes once it has been packed, regardless of how many bytes it came from. */
+	reader->row = bitmap->pixels + (tile_y * 8 + reader->row_index) * bitmap->stride + tile_x * bitmap->bits_per_pixel;
+	reader->row_bytes_remaining = 4;
+}
+
+/***********************/
+/* End of Bitmap Input */
+/***********************/
+
+/************/
+/* Sessions */
+/************/
+
+/* The code table of a session is made again once the data is more than 1/SESSION_TABLE_TOLERANCE larger with it than it would be with a new one. */
+#define SESSION_TABLE_TOLERANCE 64
+
+/* What the emitter was doing when it reached the start of a tile, so that it can carry on from there later. */
+typedef struct SessionCheckpoint
+{
+	/* Where the tile's codes start in the output, in bits. */
+	unsigned long bit_position;
+	/* The stretch of nybbles that was still being accumulated, which may continue into the tile. */
+	unsigned long stretch_length;
+	unsigned char stretch_nybble;
+} SessionCheckpoint;
+
+typedef struct SessionBuffer
+{
+	unsigned char *bytes;
+	size_t size, capacity;
+} SessionBuffer;
+
+struct ClownNemesis_Session
+{
+	State state;
+
+	unsigned char *tiles;
+	unsigned long total_tiles;
+	/* One for the start of each tile, and one for the end of the last tile. */
+	SessionCheckpoint *checkpoints;
+	/* Where the codes end in the output, in bits, not counting the padding of the last byte. */
+	unsigned long end_bit_position;
+	/* How many more bits the code table can be made worse by edits before it might need to be made again. */
+	unsigned long table_slack_bits;
+
+	SessionBuffer output;
+	/* Newly-emitted data goes here first, before replacing the part of 'output' that it is a new version of. */
+	SessionBuffer patch;
+
+	/* The tiles which are currently being read by the compressor. */
+	const unsigned char *input;
+	size_t input_bytes_remaining;
+};
+
+static cc_bool ReserveSessionBuffer(SessionBuffer* const buffer, const size_t size)
+{
+	if (size > buffer->capacity)
+	{
+		unsigned char *new_bytes;
+
+		const size_t new_capacity = buffer->capacity > (size_t)-1 / 2 ? size : CC_MAX(size, buffer->capacity * 2);
+
+		new_bytes = (unsigned char*)realloc(buffer->bytes, new_capacity);
+
+		if (new_bytes == NULL)
+			return cc_false;
+
+		buffer->bytes = new_bytes;
+		buffer->capacity = new_capacity;
+	}
+
+	return cc_true;
+}
+
+static int ReadSessionTiles(void* const user_data)
+{
+	/* Like any other input, this rewinds at the end, but always to all of the tiles, as only passes over all of them are repeated. */
+	ClownNemesis_Session* const session = (ClownNemesis_Session*)user_data;
+
+	if (session->input_bytes_remaining == 0)
+	{
+		session->input = session->tiles;
+		session->input_bytes_remaining = session->total_tiles * BYTES_PER_TILE;
+		return CLOWNNEMESIS_EOF;
+	}
+
+	--session->input_bytes_remaining;
+
+	return *session->input++;
+}
+
+static int WriteSessionPatch(void* const user_data, const unsigned char byte)
+{
+	ClownNemesis_Session* const session = (ClownNemesis_Session*)user_data;
+
+	if (!ReserveSessionBuffer(&session->patch, session->patch.size + 1))
+		return CLOWNNEMESIS_ERROR;
+
+	session->patch.bytes[session->patch.size++] = byte;
+
+	return 0;
+}
+
+static unsigned int SessionNybble(const ClownNemesis_Session* const session, const unsigned long tile_index, const unsigned char* const tile, const unsigned int mode, const unsigned long nybble_index)
+{
+	/* Reads a nybble of the tiles, except that the tile at 'tile_index' is read from 'tile' instead. */
+	const unsigned long byte_index = nybble_index / 2;
+	unsigned int byte;
+
+	byte = byte_index / BYTES_PER_TILE == tile_index ? tile[byte_index % BYTES_PER_TILE] : session->tiles[byte_index];
+
+	if (mode != 0 && byte_index >= 4)
+		byte ^= (byte_index - 4) / BYTES_PER_TILE == tile_index ? tile[(byte_index - 4) % BYTES_PER_TILE] : session->tiles[byte_index - 4];
+
+	return nybble_index % 2 == 0 ? byte >> 4 : byte & 0xF;
+}
+
+static cc_bool SessionNybblesMatch(const ClownNemesis_Session* const session, const unsigned long tile_index, const unsigned char* const tile, const unsigned int mode, const unsigned long nybble_index)
+{
+	return SessionNybble(session, tile_index, tile, mode, nybble_index) == SessionNybble(session, tile_index, tile, mode, nybble_index + 1);
+}
+
+static void CountSessionStretches(const ClownNemesis_Session* const session, unsigned long (* const occurrences)[MAXIMUM_RUN_LENGTH], const unsigned long tile_index, const unsigned char* const tile, const unsigned int mode, const unsigned long first_nybble, const unsigned long end_nybble)
+{
+	unsigned long stretch_length, i;
+	unsigned int stretch_nybble;
+
+	stretch_nybble = 0;
+	stretch_length = 0;
+
+	for (i = first_nybble; i < end_nybble; ++i)
+	{
+		const unsigned int nybble = SessionNybble(session, tile_index, tile, mode, i);
+
+		if (stretch_length != 0 && nybble != stretch_nybble)
+		{
+			CountStretch(occurrences, stretch_nybble, stretch_length);
+			stretch_length = 0;
+		}
+
+		stretch_nybble = nybble;
+		++stretch_length;
+	}
+
+	if (stretch_length != 0)
+		CountStretch(occurrences, stretch_nybble, stretch_length);
+}
+
+static unsigned long UpdateSessionHistograms(ClownNemesis_Session* const session, const unsigned long tile_index, const unsigned char* const tile)
+{
+	/* Rather than counting all of the tiles again, only the stretches of nybbles that the edit touches are counted, */
+	/* once as they were and once as they will be, and the difference between the two is applied to the histograms. */
+	/* Returns how many occurrences of nybble runs were added or removed. */
+	const unsigned char* const old_tile = &session->tiles[tile_index * BYTES_PER_TILE];
+	const unsigned long total_nybbles = session->total_tiles * BYTES_PER_TILE * 2;
+	unsigned long total_changes;
+	unsigned int mode;
+
+	total_changes = 0;
+
+	for (mode = 0; mode < 2; ++mode)
+	{
+		unsigned long old_occurrences[MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH];
+		unsigned long new_occurrences[MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH];
+		unsigned long first_nybble, end_nybble;
+		unsigned int i;
+
+		/* In XOR mode, the first row of the next tile changes too, as it is XORed with the last row of this one. */
+		first_nybble = tile_index * BYTES_PER_TILE * 2;
+		end_nybble = CC_MIN(total_nybbles, first_nybble + BYTES_PER_TILE * 2 + (mode != 0 ? 4 * 2 : 0));
+
+		/* Widen the range to the ends of the stretches that it is part of, either before or after the edit, */
+		/* so that the stretches outside of the range are the same either way. */
+		while (first_nybble != 0 && (SessionNybblesMatch(session, tile_index, old_tile, mode, first_nybble - 1) || SessionNybblesMatch(session, tile_index, tile, mode, first_nybble - 1)))
+			--first_nybble;
+
+		while (end_nybble != total_nybbles && (SessionNybblesMatch(session, tile_index, old_tile, mode, end_nybble - 1) || SessionNybblesMatch(session, tile_index, tile, mode, end_nybble - 1)))
+			++end_nybble;
+
+		memset(old_occurrences, 0, sizeof(old_occurrences));
+		memset(new_occurrences, 0, sizeof(new_occurrences));
+
+		CountSessionStretches(session, old_occurrences, tile_index, old_tile, mode, first_nybble, end_nybble);
+		CountSessionStretches(session, new_occurrences, tile_index, tile, mode, first_nybble, end_nybble);
+
+		for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
+		{
+			unsigned int j;
+
+			for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+			{
+				session->state.histograms[mode][i][j] = (unsigned int)(session->state.histograms[mode][i][j] + new_occurrences[i][j] - old_occurrences[i][j]);
+				total_changes += CC_MAX(new_occurrences[i][j], old_occurrences[i][j]) - CC_MIN(new_occurrences[i][j], old_occurrences[i][j]);
+			}
+		}
+	}
+
+	return total_changes;
+}
+
+static void ComputeSessionCodes(ClownNemesis_Session* const session)
+{
+	/* The code table is made exactly as the normal effort level would make it, so that the data is the same. */
+	State* const state = &session->state;
+
+	ComputeCodesFromHistograms(state, cc_false);
+
+	session->input = session->tiles;
+	session->input_bytes_remaining = session->total_tiles * BYTES_PER_TILE;
+	memset(state->initial_previous_row, 0, sizeof(state->initial_previous_row));
+	RefineComputedCodes(state);
+}
+
+static cc_bool SessionCodeTableIsStale(ClownNemesis_Session* const session)
+{
+	/* Compares the size of the code table and codes that were emitted to the size that they would be with a new code table. */
+	/* The new code table is the one that compressing the tiles afresh would make, so the data is never much larger than */
+	/* that. If the code table is stale, then the new one is left in place, ready for the tiles to be emitted with it. */
+	State* const state = &session->state;
+	NybbleRun nybble_runs[MAXIMUM_RUN_NYBBLE][MAXIMUM_RUN_LENGTH];
+	unsigned long current_total_bits, new_total_bits, allowed_total_bits;
+
+	const cc_bool xor_mode_enabled = state->xor_mode_enabled;
+
+	/* Everything but the header and the code table's terminator. */
+	current_total_bits = session->end_bit_position - (2 + 1) * 8;
+
+	memcpy(nybble_runs, state->nybble_runs, sizeof(nybble_runs));
+
+	ComputeSessionCodes(session);
+	new_total_bits = state->total_bits;
+
+	allowed_total_bits = new_total_bits + new_total_bits / SESSION_TABLE_TOLERANCE;
+
+	if (current_total_bits > allowed_total_bits)
+		return cc_true;
+
+	memcpy(state->nybble_runs, nybble_runs, sizeof(nybble_runs));
+	state->xor_mode_enabled = xor_mode_enabled;
+
+	session->table_slack_bits = allowed_total_bits - current_total_bits;
+	return cc_false;
+}
+
+static void AppendOldSessionBits(ClownNemesis_Session* const session, const unsigned long first_bit, const unsigned long total_bits)
+{
+	/* Copies bits of the old data after the bits that are pending. The old data usually starts at a different bit */
+	/* of a byte to the new data, so each byte is shifted into place, which is much faster than emitting it again. */
+	State* const state = &session->state;
+	unsigned long bit_buffer, byte_index, remaining;
+	unsigned int bits_done, skipped_bits;
+
+	if (!ReserveSessionBuffer(&session->patch, session->patch.size + CC_DIVIDE_CEILING(state->output_bits_done + total_bits, 8)))
+		longjmp(state->common.jump_buffer, 1);
+
+	bit_buffer = state->output_bit_buffer;
+	bits_done = state->output_bits_done;
+	byte_index = first_bit / 8;
+	skipped_bits = first_bit % 8;
+
+	for (remaining = total_bits; remaining != 0; )
+	{
+		const unsigned int available_bits = 8 - skipped_bits;
+		const unsigned int taken_bits = (unsigned int)CC_MIN(available_bits, remaining);
+
+		bit_buffer <<= taken_bits;
+		bit_buffer |= (session->output.bytes[byte_index++] >> (available_bits - taken_bits)) & ((1u << taken_bits) - 1);
+		bits_done += taken_bits;
+		remaining -= taken_bits;
+		skipped_bits = 0;
+
+		if (bits_done >= 8)
+		{
+			bits_done -= 8;
+			session->patch.bytes[session->patch.size++] = (bit_buffer >> bits_done) & 0xFF;
+		}
+	}
+
+	if (bits_done != 0)
+		session->patch.bytes[session->patch.size++] = (bit_buffer << (8 - bits_done)) & 0xFF;
+}
+
+static void EmitSessionTiles(ClownNemesis_Session* const session, const unsigned long first_tile, const unsigned long last_changed_tile)
+{
+	/* Emits the tiles from 'first_tile' onwards, one at a time, saving a checkpoint at the start of each of them. */
+	/* If the emitter reaches a tile after 'last_changed_tile' in the same stretch that it was in before, then the */
+	/* rest of the codes would be the same as they were before, so the old ones are used for the rest instead. */
+	State* const state = &session->state;
+	const SessionCheckpoint* const start = &session->checkpoints[first_tile];
+	const size_t base_size = start->bit_position / 8;
+	unsigned long tile;
+
+	session->patch.size = 0;
+	state->output_bits_done = start->bit_position % 8;
+	state->output_bit_buffer = state->output_bits_done != 0 ? session->output.bytes[base_size] >> (8 - state->output_bits_done) : 0;
+	state->stretch_length = start->stretch_length;
+	state->stretch_nybble = start->stretch_nybble;
+	state->parsed_run_callback = EmitCode;
+
+	for (tile = first_tile; tile < session->total_tiles; ++tile)
+	{
+		SessionCheckpoint* const checkpoint = &session->checkpoints[tile + 1];
+		const SessionCheckpoint previous_checkpoint = *checkpoint;
+
+		/* The runs of each tile are accumulated into the same stretches, so splitting the tiles up does not change the runs. */
+		if (tile == 0)
+			memset(state->initial_previous_row, 0, sizeof(state->initial_previous_row));
+		else
+			memcpy(state->initial_previous_row, &session->tiles[tile * BYTES_PER_TILE - sizeof(state->initial_previous_row)], sizeof(state->initial_previous_row));
+
+		session->input = &session->tiles[tile * BYTES_PER_TILE];
+		session->input_bytes_remaining = BYTES_PER_TILE;
+		FindRunsAccumulateStretch(state);
+
+		checkpoint->bit_position = (base_size + session->patch.size) * 8 + state->output_bits_done;
+		checkpoint->stretch_length = state->stretch_length;
+		checkpoint->stretch_nybble = state->stretch_length != 0 ? state->stretch_nybble : 0;
+
+		if (tile >= last_changed_tile && checkpoint->stretch_length == previous_checkpoint.stretch_length && checkpoint->stretch_nybble == previous_checkpoint.stretch_nybble)
+		{
+			const unsigned long total_old_bits = session->end_bit_position - previous_checkpoint.bit_position;
+			unsigned long i;
+
+			/* The rest of the tiles have moved by however many bits the edit added or removed. */
+			for (i = tile + 2; i <= session->total_tiles; ++i)
+				session->checkpoints[i].bit_position = session->checkpoints[i].bit_position - previous_checkpoint.bit_position + checkpoint->bit_position;
+
+			session->end_bit_position = checkpoint->bit_position + total_old_bits;
+			AppendOldSessionBits(session, previous_checkpoint.bit_position, total_old_bits);
+			break;
+		}
+	}
+
+	if (tile == session->total_tiles)
+	{
+		ParseStretch(state);
+
+		session->end_bit_position = (base_size + session->patch.size) * 8 + state->output_bits_done;
+
+		if (state->output_bits_done != 0)
+			WriteOutputByte(state, (state->output_bit_buffer << (8 - state->output_bits_done)) & 0xFF);
+	}
+
+	/* Replace everything from the first tile onwards with the new data. */
+	if (!ReserveSessionBuffer(&session->output, base_size + session->patch.size))
+		longjmp(state->common.jump_buffer, 1);
+
+	if (session->patch.size != 0)
+		memcpy(&session->output.bytes[base_size], session->patch.bytes, session->patch.size);
+
+	session->output.size = base_size + session->patch.size;
+}
+
+static void EmitSession(ClownNemesis_Session* const session)
+{
+	/* Emits all of the tiles with the current code table. */
+	State* const state = &session->state;
+
+	session->table_slack_bits = state->total_bits / SESSION_TABLE_TOLERANCE;
+
+	session->patch.size = 0;
+	state->bytes_read = session->total_tiles * BYTES_PER_TILE;
+	EmitHeader(state);
+	EmitCodeTable(state);
+
+	if (!ReserveSessionBuffer(&session->output, session->patch.size))
+		longjmp(state->common.jump_buffer, 1);
+
+	memcpy(session->output.bytes, session->patch.bytes, session->patch.size);
+	session->output.size = session->patch.size;
+
+	session->checkpoints[0].bit_position = session->output.size * 8;
+	session->checkpoints[0].stretch_length = 0;
+	session->checkpoints[0].stretch_nybble = 0;
+
+	EmitSessionTiles(session, 0, session->total_tiles);
+}
+
+static void InitialiseSessionCommon(ClownNemesis_Session* const session)
+{
+	InitialiseCommon(&session->state.common, ReadSessionTiles, session, WriteSessionPatch, session);
+	session->state.common.throw_on_eof = cc_false;
+}
+
+static cc_bool StartSession(ClownNemesis_Session* const session)
+{
+	/* Counts all of the tiles, and then compresses them. */
+	State* const state = &session->state;
+	cc_bool success;
+
+	success = cc_false;
+
+	ResetState(state);
+	InitialiseSessionCommon(session);
+
+	if (!setjmp(state->common.jump_buffer))
+	{
+		session->input = session->tiles;
+		session->input_bytes_remaining = session->total_tiles * BYTES_PER_TILE;
+		ComputeHistogramsBothModes(state, cc_false);
+
+		ComputeSessionCodes(session);
+		EmitSession(session);
+
+		success = cc_true;
+	}
+
+	return success;
+}
+
+#undef SESSION_TABLE_TOLERANCE
+
+/*******************/
+/* End of Sessions */
+/*******************/
+
+/**********/
+/* Chunks */
+/**********/
+
+/* A stretch belongs to the chunk that it starts in. Each chunk skips the nybbles that continue a stretch from the */
+/* chunk before it, and follows its own last stretch past its end until the stretch ends. This way, the runs of every */
+/* stretch are split and emitted exactly as they would be if the tiles were not split into chunks at all. */
+
+typedef struct ChunkBuffer
+{
+	unsigned char *bytes;
+	size_t size, capacity;
+} ChunkBuffer;
+
+static int WriteChunkBuffer(void* const user_data, const unsigned char byte)
+{
+	ChunkBuffer* const buffer = (ChunkBuffer*)user_data;
+
+	if (buffer->size == buffer->capacity)
+	{
+		unsigned char *new_bytes;
+
+		const size_t new_capacity = buffer->capacity == 0 ? 0x100 : buffer->capacity * 2;
+
+		if (buffer->capacity > (size_t)-1 / 2)
+			return CLOWNNEMESIS_ERROR;
+
+		new_bytes = (unsigned char*)realloc(buffer->bytes, new_capacity);
+
+		if (new_bytes == NULL)
+			return CLOWNNEMESIS_ERROR;
+
+		buffer->bytes = new_bytes;
+		buffer->capacity = new_capacity;
+	}
+
+	buffer->bytes[buffer->size++] = byte;
+
+	return byte;
+}
+
+static unsigned int ChunkNybble(const unsigned char* const tiles, const cc_bool xor_mode_enabled, const unsigned long nybble_index)
+{
+	const unsigned long byte_index = nybble_index / 2;
+	unsigned int byte;
+
+	byte = tiles[byte_index];
+
+	if (xor_mode_enabled && byte_index >= 4)
+		byte ^= tiles[byte_index - 4];
+
+	return nybble_index % 2 == 0 ? byte >> 4 : byte & 0xF;
+}
+
+static void EmitChunkStretch(State* const state, const cc_bool optimal_parse)
+{
+	if (optimal_parse)
+	{
+		ParseStretch(state);
+	}
+	else
+	{
+		/* Like 'FindRunsEmitCode', this uses the longest runs possible, from the start of the stretch. */
+		for (; state->stretch_length > MAXIMUM_RUN_LENGTH; state->stretch_length -= MAXIMUM_RUN_LENGTH)
+			EmitCode(state, state->stretch_nybble, MAXIMUM_RUN_LENGTH);
+
+		EmitCode(state, state->stretch_nybble, (unsigned int)state->stretch_length);
+		state->stretch_length = 0;
+	}
+}
+
+static int ComputeChunkCodes(State* const state, const ClownNemesis_CompressOptions* const options, const ClownNemesis_TrainingHistogram* const known_histogram, const unsigned char* const tiles, const unsigned long total_tiles, ClownNemesis_ChunkCodes* const codes)
+{
+	TileReader reader;
+	int success;
+
+	success = 0;
+
+	if (total_tiles > 0x7FFF)
+		return success;
+
+	reader.tiles = tiles;
+	reader.size = total_tiles * BYTES_PER_TILE;
+	reader.position = 0;
+
+	ResetState(state);
+	InitialiseCommon(&state->common, ReadTiles, &reader, NULL, NULL);
+	state->common.throw_on_eof = cc_false;
+	state->known_histogram = known_histogram;
+
+	if (!setjmp(state->common.jump_buffer))
+	{
+		unsigned int i;
+
+		ComputeCodesForOptions(state, options);
+
+		codes->options = *options;
+		codes->total_tiles = total_tiles;
+		codes->xor_mode_enabled = state->xor_mode_enabled;
+		codes->decode_cycle_weight = state->decode_cycle_weight;
+
+		for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
+		{
+			unsigned int j;
+
+			for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+			{
+				codes->codes[i][j] = state->nybble_runs[i][j].code;
+				codes->code_lengths[i][j] = state->nybble_runs[i][j].total_code_bits;
+			}
+		}
+
+		success = 1;
+	}
+
+	return success;
+}
+
+static int EmitChunk(State* const state, const ClownNemesis_ChunkCodes* const codes, const unsigned char* const tiles, const unsigned long first_tile, const unsigned long end_tile, ClownNemesis_Chunk* const chunk)
+{
+	ChunkBuffer buffer;
+	int success;
+
+	success = 0;
+
+	if (first_tile > end_tile || end_tile > codes->total_tiles)
+		return success;
+
+	buffer.bytes = NULL;
+	buffer.size = buffer.capacity = 0;
+
+	ResetState(state);
+	InitialiseCommon(&state->common, NULL, NULL, WriteChunkBuffer, &buffer);
+
+	if (!setjmp(state->common.jump_buffer))
+	{
+		const unsigned long end_nybble = end_tile * BYTES_PER_TILE * 2;
+		const unsigned long total_nybbles = codes->total_tiles * BYTES_PER_TILE * 2;
+		unsigned long first_nybble;
+
+		state->decode_cycle_weight = codes->decode_cycle_weight;
+		state->parsed_run_callback = EmitCode;
+		UseCodes(state, codes->xor_mode_enabled, codes->codes, codes->code_lengths);
+
+		first_nybble = first_tile * BYTES_PER_TILE * 2;
+
+		if (first_nybble != 0)
+			while (first_nybble < end_nybble && ChunkNybble(tiles, state->xor_mode_enabled, first_nybble) == ChunkNybble(tiles, state->xor_mode_enabled, first_nybble - 1))
+				++first_nybble;
+
+		if (first_nybble < end_nybble)
+		{
+			const cc_bool optimal_parse = UsesOptimalParse(&codes->options);
+			unsigned long i;
+
+			for (i = first_nybble; i < total_nybbles; ++i)
+			{
+				const unsigned int nybble = ChunkNybble(tiles, state->xor_mode_enabled, i);
+
+				if (state->stretch_length != 0 && nybble != state->stretch_nybble)
+				{
+					EmitChunkStretch(state, optimal_parse);
+
+					/* The stretch that reaches past the end of the chunk was the last one that belongs to it. */
+					if (i >= end_nybble)
+						break;
+				}
+
+				state->stretch_nybble = nybble;
+				++state->stretch_length;
+			}
+
+			if (state->stretch_length != 0)
+				EmitChunkStretch(state, optimal_parse);
+		}
+
+		chunk->first_tile = first_tile;
+		chunk->end_tile = end_tile;
+		chunk->total_bits = (unsigned long)buffer.size * 8 + state->output_bits_done;
+
+		if (state->output_bits_done != 0)
+			WriteOutputByte(state, (state->output_bit_buffer << (8 - state->output_bits_done)) & 0xFF);
+
+		chunk->bytes = buffer.bytes;
+		buffer.bytes = NULL;
+
+		success = 1;
+	}
+
+	free(buffer.bytes);
+
+	return success;
+}
+
+static void PlaceChunk(unsigned char* const merged, const ClownNemesis_Chunk* const chunk, const unsigned long bit_offset)
+{
+	/* The chunk's bytes are shifted into place, and combined with the end of the chunk before them, whose padding bits are 0. */
+	/* As the chunk's own padding is 0 too, the chunks can be placed in any order. */
+	unsigned char* const destination = &merged[bit_offset / 8];
+	const unsigned int shift = bit_offset % 8;
+	const unsigned long total_bytes = CC_DIVIDE_CEILING(chunk->total_bits, 8);
+	unsigned long i;
+
+	for (i = 0; i < total_bytes; ++i)
+	{
+		destination[i] |= chunk->bytes[i] >> shift;
+		destination[i + 1] |= (chunk->bytes[i] << (8 - shift)) & 0xFF;
+	}
+}
+
+static int WriteChunks(State* const state, const ClownNemesis_ChunkCodes* const codes, const ClownNemesis_Chunk* const chunks, const size_t total_chunks, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	unsigned char *merged;
+	unsigned long total_bits, end_tile, total_bytes;
+	size_t i;
+	int success;
+
+	success = 0;
+
+	/* The chunks must cover all of the tiles, in order. */
+	total_bits = end_tile = 0;
+
+	for (i = 0; i < total_chunks; ++i)
+	{
+		if (chunks[i].first_tile != end_tile)
+			return success;
+
+		end_tile = chunks[i].end_tile;
+		total_bits += chunks[i].total_bits;
+	}
+
+	if (end_tile != codes->total_tiles)
+		return success;
+
+	/* Sega's compressor would redundantly emit an empty byte if there are no bits pending at the end. */
+	total_bytes = total_bits / 8 + (total_bits % 8 != 0 || codes->options.accurate ? 1 : 0);
+
+	/* There is an extra byte for the last chunk's shifted padding. */
+	merged = (unsigned char*)calloc(total_bytes + 1, 1);
+
+	if (merged == NULL)
+		return success;
+
+	ResetState(state);
+	InitialiseCommon(&state->common, NULL, NULL, write_byte, write_byte_user_data);
+
+	if (codes->options.max_output_bytes != 0)
+		state->output_bytes_remaining = codes->options.max_output_bytes;
+
+	if (!setjmp(state->common.jump_buffer))
+	{
+		unsigned long bit_offset, j;
+
+		UseCodes(state, codes->xor_mode_enabled, codes->codes, codes->code_lengths);
+		state->bytes_read = codes->total_tiles * BYTES_PER_TILE;
+
+		EmitHeader(state);
+		EmitCodeTable(state);
+
+		/* Each chunk starts where the chunks before it end, which is an exclusive prefix sum of their lengths. */
+		bit_offset = 0;
+
+		for (i = 0; i < total_chunks; ++i)
+		{
+			PlaceChunk(merged, &chunks[i], bit_offset);
+			bit_offset += chunks[i].total_bits;
+		}
+
+		for (j = 0; j < total_bytes; ++j)
+			WriteOutputByte(state, merged[j]);
+
+		success = 1;
+	}
+	else if (state->over_budget)
+	{
+		success = CLOWNNEMESIS_OVER_BUDGET;
+	}
+
+	free(merged);
+
+	return success;
+}
+
+/*****************/
+/* End of Chunks */
+/*****************/
+
+void ClownNemesis_DefaultCompressOptions(ClownNemesis_CompressOptions* const options)
+{
+	options->accurate = 0;
+	options->effort = CLOWNNEMESIS_EFFORT_NORMAL;
+	options->decode_speed = 0;
+	options->max_output_bytes = 0;
+}
+
+int ClownNemesis_CompressWithOptions(const ClownNemesis_CompressOptions* const options, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	State state;
+
+	return Compress(&state, options, NULL, NULL, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+}
+
+int ClownNemesis_Compress(const int accurate, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	ClownNemesis_CompressOptions options;
+
+	ClownNemesis_DefaultCompressOptions(&options);
+	options.accurate = accurate;
+
+	return ClownNemesis_CompressWithOptions(&options, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+}
+
+int ClownNemesis_CompressUltra(const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	ClownNemesis_CompressOptions options;
+
+	ClownNemesis_DefaultCompressOptions(&options);
+	options.effort = CLOWNNEMESIS_EFFORT_EXHAUSTIVE;
+
+	return ClownNemesis_CompressWithOptions(&options, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
 }
 
-static void EmitHeader(State* const state)
+size_t ClownNemesis_CompressorWorkspaceSize(void)
+{
+	return sizeof(ClownNemesis_Compressor);
+}
+
+ClownNemesis_Compressor* ClownNemesis_CompressorInitialise(void* const workspace)
+{
+	/* The workspace does not need clearing: every compression starts with 'ResetState', which sets up the parts of the */
+	/* state that it does not set itself, so a compressor never needs resetting between compressions either. */
+	return (ClownNemesis_Compressor*)workspace;
+}
+
+ClownNemesis_Compressor* ClownNemesis_CompressorCreate(void)
+{
+	void* const workspace = malloc(ClownNemesis_CompressorWorkspaceSize());
+
+	if (workspace == NULL)
+		return NULL;
+
+	return ClownNemesis_CompressorInitialise(workspace);
+}
+
+void ClownNemesis_CompressorDestroy(ClownNemesis_Compressor* const compressor)
+{
+	free(compressor);
+}
+
+int ClownNemesis_CompressorCompress(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	return Compress(&compressor->state, options, NULL, NULL, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+}
+
+int ClownNemesis_CompressorCompressWithHistogram(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const ClownNemesis_TrainingHistogram* const histogram, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	return Compress(&compressor->state, options, NULL, histogram, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+}
+
+int ClownNemesis_Recompress(const ClownNemesis_CompressOptions* const options, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	State state;
+
+	return Recompress(&state, options, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+}
+
+int ClownNemesis_CompressorRecompress(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	return Recompress(&compressor->state, options, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+}
+
+unsigned int ClownNemesis_TotalSeeds(const ClownNemesis_CompressOptions* const options)
+{
+	/* When favouring decoding speed, the codes of the seeds are only one level of many, so they cannot be used alone. */
+	if (DecodeCycleWeight(options) != 0)
+		return 0;
+
+	return SeedsPerMode(options) * 2;
+}
+
+int ClownNemesis_CompressorRefineSeed(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const unsigned int seed, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, ClownNemesis_RefinedSeed* const refined_seed)
+{
+	if (seed >= ClownNemesis_TotalSeeds(options))
+		return 0;
+
+	return RefineSeedOfInput(&compressor->state, options, seed, read_byte, read_byte_user_data, refined_seed);
+}
+
+void ClownNemesis_ReduceRefinedSeeds(ClownNemesis_RefinedSeed* const best, const ClownNemesis_RefinedSeed* const other)
+{
+	ReduceRefinedSeeds(best, other);
+}
+
+int ClownNemesis_CompressorCompressWithRefinedSeed(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const ClownNemesis_RefinedSeed* const refined_seed, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	return CompressWithRefinedSeed(&compressor->state, options, refined_seed, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+}
+
+int ClownNemesis_CompressorComputeChunkCodes(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const unsigned char* const tiles, const unsigned long total_tiles, ClownNemesis_ChunkCodes* const codes)
+{
+	return ComputeChunkCodes(&compressor->state, options, NULL, tiles, total_tiles, codes);
+}
+
+int ClownNemesis_CompressorComputeChunkCodesWithHistogram(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const ClownNemesis_TrainingHistogram* const histogram, const unsigned char* const tiles, const unsigned long total_tiles, ClownNemesis_ChunkCodes* const codes)
+{
+	return ComputeChunkCodes(&compressor->state, options, histogram, tiles, total_tiles, codes);
+}
+
+int ClownNemesis_CompressorEmitChunk(ClownNemesis_Compressor* const compressor, const ClownNemesis_ChunkCodes* const codes, const unsigned char* const tiles, const unsigned long first_tile, const unsigned long end_tile, ClownNemesis_Chunk* const chunk)
+{
+	return EmitChunk(&compressor->state, codes, tiles, first_tile, end_tile, chunk);
+}
+
+int ClownNemesis_CompressorWriteChunks(ClownNemesis_Compressor* const compressor, const ClownNemesis_ChunkCodes* const codes, const ClownNemesis_Chunk* const chunks, const size_t total_chunks, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	return WriteChunks(&compressor->state, codes, chunks, total_chunks, write_byte, write_byte_user_data);
+}
+
+void ClownNemesis_FreeChunk(ClownNemesis_Chunk* const chunk)
+{
+	free(chunk->bytes);
+	chunk->bytes = NULL;
+}
+
+unsigned long ClownNemesis_CompressBound(const unsigned long total_tiles)
+{
+	/* The header is 2 bytes. */
+	/* The code table has at most an entry for each of the 16 nybbles, 2 bytes for each of the 8 run lengths of each nybble, and a terminator byte. */
+	/* In the worst case, every nybble is inlined on its own, costing 6 + 3 + 4 bits, and there are 8 * 8 nybbles in a tile. */
+	/* Lastly, accurate compression can emit a redundant byte at the end. */
+	return 2 + (MAXIMUM_RUN_NYBBLE * (1 + MAXIMUM_RUN_LENGTH * 2) + 1) + total_tiles * CC_DIVIDE_CEILING((6 + 3 + 4) * 8 * 8, 8) + 1;
+}
+
+int ClownNemesis_CompressWithTable(const ClownNemesis_CodeTable* const table, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	State state;
+
+	return CompressWithTable(&state, table, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+}
+
+int ClownNemesis_CompressorCompressWithTable(ClownNemesis_Compressor* const compressor, const ClownNemesis_CodeTable* const table, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	return CompressWithTable(&compressor->state, table, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+}
+
+void ClownNemesis_TrainingHistogramInitialise(ClownNemesis_TrainingHistogram* const histogram)
+{
+	memset(histogram, 0, sizeof(*histogram));
+}
+
+int ClownNemesis_TrainingHistogramAdd(ClownNemesis_TrainingHistogram* const histogram, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data)
 {
-	const unsigned int bytes_per_tile = 0x20;
-	const unsigned int total_tiles = state->bytes_read / bytes_per_tile;
+	int success;
+	State state;
+
+	success = 0;
+
+	ResetState(&state);
+	InitialiseCommon(&state.common, read_byte, read_byte_user_data, NULL, NULL);
+	state.common.throw_on_eof = cc_false;
 
-	/* TODO: Maybe do this check in ComputeCodes? */
-	if (state->bytes_read % bytes_per_tile != 0)
+	if (!setjmp(state.common.jump_buffer))
 	{
-	#ifdef CLOWNNEMESIS_DEBUG
-		fputs("Input data size is not a multiple of 0x20 bytes.\n", stderr);
-	#endif
-		longjmp(state->common.jump_buffer, 1);
+		unsigned int i;
+
+		ComputeHistogramsBothModes(&state, cc_false);
+
+		for (i = 0; i < 2; ++i)
+		{
+			unsigned int j;
+
+			for (j = 0; j < MAXIMUM_RUN_NYBBLE; ++j)
+			{
+				unsigned int k;
+
+				for (k = 0; k < MAXIMUM_RUN_LENGTH; ++k)
+					histogram->occurrences[i][j][k] += state.histograms[i][j][k];
+			}
+		}
+
+		++histogram->total_files;
+
+		success = 1;
 	}
-	else if (total_tiles > 0x7FFF)
+
+	return success;
+}
+
+int ClownNemesis_PartialHistogramCount(ClownNemesis_PartialHistogram* const partial, const unsigned char* const previous_row, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data)
+{
+	int success;
+	StateCommon common;
+
+	success = 0;
+
+	memset(partial, 0, sizeof(*partial));
+
+	InitialiseCommon(&common, read_byte, read_byte_user_data, NULL, NULL);
+	common.throw_on_eof = cc_false;
+
+	if (!setjmp(common.jump_buffer))
 	{
-	#ifdef CLOWNNEMESIS_DEBUG
-		fputs("Input data is larger than the header allows.\n", stderr);
-	#endif
-		longjmp(state->common.jump_buffer, 1);
+		CountPartialHistogram(partial, previous_row, &common);
+		success = 1;
 	}
 
-	WriteByte(&state->common, total_tiles >> 8 | state->xor_mode_enabled << 7);
-	WriteByte(&state->common, total_tiles & 0xFF);
+	return success;
 }
 
-static void EmitCodeTableEntry(State* const state, const unsigned int run_nybble, const unsigned int run_length_minus_one)
+void ClownNemesis_PartialHistogramMerge(ClownNemesis_PartialHistogram* const first, const ClownNemesis_PartialHistogram* const second)
 {
-	NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length_minus_one];
+	unsigned int mode;
 
-	if (nybble_run->total_code_bits != 0)
+	for (mode = 0; mode < 2; ++mode)
 	{
-	#ifdef CLOWNNEMESIS_DEBUG
-		fprintf(stderr, "Run of nybble %X of length %d occurred %d times (code is ", run_nybble, run_length_minus_one + 1, nybble_run->occurrences);
+		/* Line up the uncounted stretches of both parts, joining the two in the middle if they are the same nybble. */
+		unsigned char nybbles[4];
+		unsigned long lengths[4];
+		unsigned int total_stretches, i;
+
+		total_stretches = 0;
 
+		if (first->first_length[mode] != 0)
 		{
-			unsigned int i;
-			for (i = 0; i < 8; ++i)
-				fputc((nybble_run->code & 1 << (8 - 1 - i)) != 0 ? '1' : '0', stderr);
+			nybbles[total_stretches] = first->first_nybble[mode];
+			lengths[total_stretches++] = first->first_length[mode];
 		}
 
-		fprintf(stderr, ", length is %d).\n", nybble_run->total_code_bits);
-	#endif
+		if (first->last_length[mode] != 0)
+		{
+			nybbles[total_stretches] = first->last_nybble[mode];
+			lengths[total_stretches++] = first->last_length[mode];
+		}
 
-		if (run_nybble != state->previous_nybble)
+		if (second->first_length[mode] != 0)
 		{
-			state->previous_nybble = run_nybble;
-			WriteByte(&state->common, 0x80 | run_nybble);
+			if (total_stretches != 0 && nybbles[total_stretches - 1] == second->first_nybble[mode])
+			{
+				lengths[total_stretches - 1] += second->first_length[mode];
+			}
+			else
+			{
+				nybbles[total_stretches] = second->first_nybble[mode];
+				lengths[total_stretches++] = second->first_length[mode];
+			}
+		}
+
+		if (second->last_length[mode] != 0)
+		{
+			nybbles[total_stretches] = second->last_nybble[mode];
+			lengths[total_stretches++] = second->last_length[mode];
+		}
+
+		for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
+		{
+			unsigned int j;
+
+			for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+				first->histogram.occurrences[mode][i][j] += second->histogram.occurrences[mode][i][j];
+		}
+
+		/* Only the stretches at either end of the merged parts can continue into the other parts, so the rest can be counted. */
+		for (i = 1; i + 1 < total_stretches; ++i)
+			CountStretch(first->histogram.occurrences[mode], nybbles[i], lengths[i]);
+
+		first->first_length[mode] = first->last_length[mode] = 0;
+
+		if (total_stretches != 0)
+		{
+			first->first_nybble[mode] = nybbles[0];
+			first->first_length[mode] = lengths[0];
 		}
 
-		WriteByte(&state->common, run_length_minus_one << 4 | nybble_run->total_code_bits);
-		WriteByte(&state->common, nybble_run->code);
+		if (total_stretches > 1)
+		{
+			first->last_nybble[mode] = nybbles[total_stretches - 1];
+			first->last_length[mode] = lengths[total_stretches - 1];
+		}
 	}
+
+	first->total_bytes += second->total_bytes;
 }
 
-static void EmitCodeTable(State* const state)
+void ClownNemesis_TrainingHistogramAddPartial(ClownNemesis_TrainingHistogram* const histogram, const ClownNemesis_PartialHistogram* const partial)
 {
-	/* Finally, emit the code table. */
-	state->previous_nybble = 0xFF; /* Deliberately invalid. */
-	IterateNybbleRuns(state, EmitCodeTableEntry);
+	unsigned int mode;
 
-	/* Mark the end of the code table. */
-	WriteByte(&state->common, 0xFF);
+	for (mode = 0; mode < 2; ++mode)
+	{
+		unsigned int i;
 
-#ifdef CLOWNNEMESIS_DEBUG
-	fprintf(stderr, "Total runs: %d\n", state->total_runs);
-#endif
+		for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
+		{
+			unsigned int j;
+
+			for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+				histogram->occurrences[mode][i][j] += partial->histogram.occurrences[mode][i][j];
+		}
+
+		if (partial->first_length[mode] != 0)
+			CountStretch(histogram->occurrences[mode], partial->first_nybble[mode], partial->first_length[mode]);
+
+		if (partial->last_length[mode] != 0)
+			CountStretch(histogram->occurrences[mode], partial->last_nybble[mode], partial->last_length[mode]);
+	}
+
+	++histogram->total_files;
 }
 
-static void WriteBit(State* const state, const unsigned int bit)
+void ClownNemesis_TrainCodeTable(ClownNemesis_CodeTable* const table, const ClownNemesis_TrainingHistogram* const histogram)
 {
-	state->output_byte_buffer <<= 1;
-	state->output_byte_buffer |= bit;
+	State state;
+	unsigned int total_bits[2];
+	unsigned int i;
+
+	ResetState(&state);
+
+	/* Make the optimal codes for both modes, and keep whichever mode makes the corpus smaller. */
+	for (i = 0; i < 2; ++i)
+	{
+		UseTrainingHistogram(&state, histogram, (cc_bool)i);
+		ComputeCodesOptimal(&state);
+		ComputeTotalEncodedBits(&state);
+		total_bits[i] = state.total_bits;
+	}
 
-	if (++state->output_bits_done == 8)
+	table->xor_mode_enabled = total_bits[1] < total_bits[0];
+
+	UseTrainingHistogram(&state, histogram, (cc_bool)table->xor_mode_enabled);
+	ComputeCodesOptimal(&state);
+
+	for (i = 0; i < MAXIMUM_RUN_NYBBLE; ++i)
 	{
-		state->output_bits_done = 0;
-		WriteByte(&state->common, state->output_byte_buffer & 0xFF);
+		unsigned int j;
+
+		for (j = 0; j < MAXIMUM_RUN_LENGTH; ++j)
+			table->code_lengths[i][j] = state.nybble_runs[i][j].total_code_bits;
 	}
 }
 
-static void WriteBits(State* const state, const unsigned int bits, const unsigned int total_bits)
+unsigned long ClownNemesis_EstimateCompressedSize(const ClownNemesis_CompressOptions* const options, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data)
 {
-	unsigned int i;
+	State state;
 
-	for (i = 0; i < total_bits; ++i)
-		WriteBit(state, (bits & (1 << (total_bits - 1 - i))) != 0);
+	return EstimateCompressedSize(&state, options, read_byte, read_byte_user_data);
 }
 
-static void EmitCode(State* const state, const unsigned int run_nybble, const unsigned int run_length)
+unsigned long ClownNemesis_EstimateCompressedSizeSampled(const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data)
 {
-	const NybbleRun* const nybble_run = &state->nybble_runs[run_nybble][run_length - 1];
+	State state;
 
-	if (nybble_run->total_code_bits != 0)
+	return EstimateCompressedSizeSampled(&state, read_byte, read_byte_user_data);
+}
+
+size_t ClownNemesis_Split(ClownNemesis_Segment* const segments, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data)
+{
+	size_t total_segments;
+	Splitter* const splitter = (Splitter*)malloc(sizeof(Splitter));
+
+	total_segments = 0;
+
+	if (splitter != NULL)
 	{
-	#ifdef CLOWNNEMESIS_DEBUG
-		unsigned int i;
+		total_segments = Split(splitter, segments, read_byte, read_byte_user_data);
 
-		fputs("Emitting code ", stderr);
+		if (total_segments != 0)
+			total_segments = KeepSplitIfSmaller(splitter, segments, total_segments, read_byte, read_byte_user_data);
 
-		for (i = 0; i < 8; ++i)
-			fputc((nybble_run->code & (1 << (8 - 1 - i))) != 0 ? '1' : '0', stderr);
+		free(splitter);
+	}
 
-		fprintf(stderr, " of length %d for nybble %X of length %d.\n", nybble_run->total_code_bits, run_nybble, run_length);
-	#endif
+	return total_segments;
+}
 
-		WriteBits(state, nybble_run->code, nybble_run->total_code_bits);
+int ClownNemesis_BitmapReaderInitialise(ClownNemesis_BitmapReader* const reader, const ClownNemesis_Bitmap* const bitmap)
+{
+	if (bitmap->width % 8 != 0 || bitmap->height % 8 != 0 || (bitmap->bits_per_pixel != 4 && bitmap->bits_per_pixel != 8) || bitmap->stride < bitmap->width * bitmap->bits_per_pixel / 8)
+		return 0;
+
+	reader->bitmap = *bitmap;
+	reader->tile = 0;
+	reader->total_tiles = (bitmap->width / 8) * (bitmap->height / 8);
+	reader->row_index = 0;
+
+	if (reader->total_tiles != 0)
+		StartBitmapRow(reader);
+
+	return 1;
+}
+
+int ClownNemesis_ReadBitmap(void* const user_data)
+{
+	ClownNemesis_BitmapReader* const reader = (ClownNemesis_BitmapReader*)user_data;
+	int value;
+
+	if (reader->tile == reader->total_tiles)
+	{
+		/* Return to the start, so that the bitmap can be read again by the next pass. */
+		reader->tile = 0;
+		reader->row_index = 0;
+
+		if (reader->total_tiles != 0)
+			StartBitmapRow(reader);
+
+		return CLOWNNEMESIS_EOF;
+	}
+
+	if (reader->bitmap.bits_per_pixel == 4)
+	{
+		value = *reader->row++;
 	}
 	else
 	{
-	#ifdef CLOWNNEMESIS_DEBUG
-		fprintf(stderr, "Emitting reject for nybble %X of length %d.\n", run_nybble, run_length);
-	#endif
+		/* Pack two pixels into one byte. */
+		value = (reader->row[0] & 0xF) << 4 | (reader->row[1] & 0xF);
+		reader->row += 2;
+	}
 
-		/* This run doesn't have a code, so inline it. */
-		WriteBits(state, 0x3F, 6);
-		WriteBits(state, run_length - 1, 3);
-		WriteBits(state, run_nybble, 4);
+	if (--reader->row_bytes_remaining == 0)
+	{
+		if (++reader->row_index == 8)
+		{
+			reader->row_index = 0;
+			++reader->tile;
+		}
+
+		if (reader->tile != reader->total_tiles)
+			StartBitmapRow(reader);
 	}
+
+	return value;
 }
 
-static void EmitCodes(State* const state, const cc_bool accurate)
+ClownNemesis_Session* ClownNemesis_SessionCreate(const unsigned char* const tiles, const unsigned long total_tiles)
 {
-	/* TODO: Use clownlzss to find the most efficient way of encoding the uncompressed data using the available codes. */
-	FindRuns(state, EmitCode);
+	ClownNemesis_Session *session;
 
-	/* Output any codes that haven't yet been flushed. */
-	/* Foolishly, Sega's compressor would redundantly emit an empty byte here if there are no unflushed bits. */
-	if (state->output_bits_done != 0 || accurate)
-		WriteByte(&state->common, (state->output_byte_buffer << (8 - state->output_bits_done)) & 0xFF);
+	if (total_tiles == 0 || total_tiles > 0x7FFF)
+		return NULL;
+
+	session = (ClownNemesis_Session*)malloc(sizeof(ClownNemesis_Session));
+
+	if (session == NULL)
+		return NULL;
+
+	session->tiles = (unsigned char*)malloc(total_tiles * BYTES_PER_TILE);
+	session->checkpoints = (SessionCheckpoint*)malloc((total_tiles + 1) * sizeof(SessionCheckpoint));
+	session->total_tiles = total_tiles;
+	session->output.bytes = session->patch.bytes = NULL;
+	session->output.size = session->output.capacity = 0;
+	session->patch.size = session->patch.capacity = 0;
+
+	if (session->tiles == NULL || session->checkpoints == NULL)
+	{
+		ClownNemesis_SessionDestroy(session);
+		return NULL;
+	}
+
+	memcpy(session->tiles, tiles, total_tiles * BYTES_PER_TILE);
+
+	if (!StartSession(session))
+	{
+		ClownNemesis_SessionDestroy(session);
+		return NULL;
+	}
+
+	return session;
 }
 
-int ClownNemesis_Compress(const int accurate_int, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+void ClownNemesis_SessionDestroy(ClownNemesis_Session* const session)
 {
-	int success;
-	State state = {0};
+	free(session->tiles);
+	free(session->checkpoints);
+	free(session->output.bytes);
+	free(session->patch.bytes);
+	free(session);
+}
 
-	const cc_bool accurate = accurate_int != 0;
+int ClownNemesis_SessionSetTile(ClownNemesis_Session* const session, const unsigned long tile_index, const unsigned char* const tile)
+{
+	State* const state = &session->state;
+	int success;
 
 	success = 0;
 
-	InitialiseCommon(&state.common, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
-	state.common.throw_on_eof = cc_false;
+	if (tile_index >= session->total_tiles)
+		return success;
 
-	if (!setjmp(state.common.jump_buffer))
+	InitialiseSessionCommon(session);
+
+	if (!setjmp(state->common.jump_buffer))
 	{
-		ComputeCodes(&state, accurate);
+		/* Each added or removed run can make the current codes at most 13 bits worse, and new codes at most 13 bits */
+		/* better, so the codes are only measured again once the edits could have used up all of the table's slack. */
+		const unsigned long worst_drift_bits = UpdateSessionHistograms(session, tile_index, tile) * (6 + 3 + 4) * 2;
+
+		memcpy(&session->tiles[tile_index * BYTES_PER_TILE], tile, BYTES_PER_TILE);
+
+		if (worst_drift_bits <= session->table_slack_bits)
+		{
+			session->table_slack_bits -= worst_drift_bits;
+			EmitSessionTiles(session, tile_index, tile_index + (state->xor_mode_enabled ? 1 : 0));
+		}
+		else
+		{
+			/* The current codes are measured by emitting the tiles with them, as that is how they are really split into runs. */
+			EmitSessionTiles(session, tile_index, tile_index + (state->xor_mode_enabled ? 1 : 0));
 
-		EmitHeader(&state);
-		EmitCodeTable(&state);
-		EmitCodes(&state, accurate);
+			if (SessionCodeTableIsStale(session))
+				EmitSession(session);
+		}
 
 		success = 1;
 	}
 
 	return success;
 }
+
+const unsigned char* ClownNemesis_SessionCompressedData(const ClownNemesis_Session* const session, size_t* const size)
+{
+	*size = session->output.size;
+	return session->output.bytes;
+}
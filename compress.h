@@ -1,15 +1,326 @@
 #ifndef HEADER_GUARD_3806BB18_BC2F_47C7_B9EF_8826358CB908
 #define HEADER_GUARD_3806BB18_BC2F_47C7_B9EF_8826358CB908
 
+#include <stddef.h>
+
 #include "common.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Compression effort levels, from the fastest to the one which produces the smallest data. */
+/* FASTEST: Counts the nybble runs of only some of the tiles, and makes codes using a quick estimate. */
+/* FAST:    Like FASTEST, but counts every tile, and splits the data into runs optimally. */
+/* NORMAL:  Makes optimal codes for both regular mode and XOR mode, and uses whichever is smaller. As the codes are only */
+/*          optimal for a greedy split of the data, they are then repeatedly refined for how the data is really split. */
+/* HIGH:    Like NORMAL, but refines the codes of both modes, instead of only the mode that was chosen beforehand. */
+/* EXHAUSTIVE: Like HIGH, but also tries refining several different starting codes. */
+#define CLOWNNEMESIS_EFFORT_FASTEST 0
+#define CLOWNNEMESIS_EFFORT_FAST 1
+#define CLOWNNEMESIS_EFFORT_NORMAL 2
+#define CLOWNNEMESIS_EFFORT_HIGH 3
+#define CLOWNNEMESIS_EFFORT_EXHAUSTIVE 4
+
+typedef struct ClownNemesis_CompressOptions
+{
+	/* If non-zero, the data will be compressed identically to Sega's compressor, and 'effort' will be ignored. */
+	int accurate;
+	/* One of the 'CLOWNNEMESIS_EFFORT_*' values above. */
+	int effort;
+	/* How much to favour data that Sega's decoder can decode quickly, over smaller data. */
+	/* This is how many 256ths of a bit of data a cycle of decoding is worth, up to 64. It is rounded down to 1, 4, */
+	/* 16, or 64, and raising it never makes the data slower to decode, as estimated by 'ClownNemesis_EstimateDecodeCycles'. */
+	/* 0 only cares about size. Only has an effect when not accurate and the effort is above 'CLOWNNEMESIS_EFFORT_FASTEST'. */
+	int decode_speed;
+	/* If non-zero, compression gives up as soon as it finds that the data would be larger than this many bytes, */
+	/* and returns 'CLOWNNEMESIS_OVER_BUDGET'. Any data that was already output should be discarded. */
+	unsigned long max_output_bytes;
+} ClownNemesis_CompressOptions;
+
+/* Returned by the compression functions instead of 1 when the data is larger than 'max_output_bytes'. */
+/* Note that this is not 0, so it must be checked for before checking for success. */
+#define CLOWNNEMESIS_OVER_BUDGET -1
+
+/* Sets the options to their defaults: not accurate, with normal effort, only caring about size, and with no budget. */
+void ClownNemesis_DefaultCompressOptions(ClownNemesis_CompressOptions *options);
+
+/* Returns 0 on error, or 'CLOWNNEMESIS_OVER_BUDGET' if the data is larger than 'max_output_bytes'. */
+int ClownNemesis_CompressWithOptions(const ClownNemesis_CompressOptions *options, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* Equivalent to 'ClownNemesis_CompressWithOptions' with the default options, except for 'accurate'. */
 /* Returns 0 on error. */
 int ClownNemesis_Compress(int accurate, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
 
+/* Equivalent to 'ClownNemesis_CompressWithOptions' with an effort of 'CLOWNNEMESIS_EFFORT_EXHAUSTIVE'. */
+/* Returns 0 on error. */
+int ClownNemesis_CompressUltra(ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* A compressor can be reused for any number of compressions, to avoid setting one up every time. */
+/* The functions which do not take a compressor, such as 'ClownNemesis_CompressWithOptions', use one on the stack */
+/* instead, which is about 58 KiB large on 64-bit platforms. Where the stack is smaller, use a compressor. */
+typedef struct ClownNemesis_Compressor ClownNemesis_Compressor;
+
+/* The number of bytes of memory that a compressor needs. */
+size_t ClownNemesis_CompressorWorkspaceSize(void);
+
+/* Sets up a compressor in memory provided by the caller, which must be at least 'ClownNemesis_CompressorWorkspaceSize' bytes large and aligned like memory from 'malloc'. */
+/* The compressor does not need to be destroyed: the caller simply stops using the memory. */
+/* The memory does not need to be cleared first, and the compressor never needs resetting, as each compression */
+/* sets up the state that it uses. */
+ClownNemesis_Compressor* ClownNemesis_CompressorInitialise(void *workspace);
+
+/* Allocates and sets up a compressor. Returns NULL on error. */
+ClownNemesis_Compressor* ClownNemesis_CompressorCreate(void);
+
+/* Frees a compressor that was made by 'ClownNemesis_CompressorCreate'. */
+void ClownNemesis_CompressorDestroy(ClownNemesis_Compressor *compressor);
+
+/* Like 'ClownNemesis_CompressWithOptions', but using the given compressor. */
+/* Returns 0 on error, or 'CLOWNNEMESIS_OVER_BUDGET' if the data is larger than 'max_output_bytes'. */
+int ClownNemesis_CompressorCompress(ClownNemesis_Compressor *compressor, const ClownNemesis_CompressOptions *options, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* Compresses data that is already Nemesis-compressed again with the given options, such as to make data from Sega's */
+/* compressor smaller. This is faster than decompressing and then compressing, as the data is only decoded into runs */
+/* of nybbles, which are used directly whenever the data is compressed in the same mode that it was before. */
+/* Returns 0 on error, or 'CLOWNNEMESIS_OVER_BUDGET' if the data is larger than 'max_output_bytes'. */
+int ClownNemesis_Recompress(const ClownNemesis_CompressOptions *options, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* Like 'ClownNemesis_Recompress', but using the given compressor. */
+/* Returns 0 on error, or 'CLOWNNEMESIS_OVER_BUDGET' if the data is larger than 'max_output_bytes'. */
+int ClownNemesis_CompressorRecompress(ClownNemesis_Compressor *compressor, const ClownNemesis_CompressOptions *options, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* The codes that one seed of the ultra mode (the 'CLOWNNEMESIS_EFFORT_HIGH' effort level and above) was refined into. */
+/* The seeds are refined independently of each other, so each of them can be refined on its own thread, with its own */
+/* compressor, and then the best of them can be used to compress the data. */
+/* The fields are private: use the functions below. */
+typedef struct ClownNemesis_RefinedSeed
+{
+	unsigned int seed;
+	unsigned long total_cost;
+	int xor_mode_enabled;
+	unsigned char codes[16][8], code_lengths[16][8];
+} ClownNemesis_RefinedSeed;
+
+/* Returns how many seeds the options refine, which are numbered from 0, or 0 if the options do not use seeds. */
+/* Options which favour decoding speed do not use seeds, as they compare the codes of several weights instead. */
+unsigned int ClownNemesis_TotalSeeds(const ClownNemesis_CompressOptions *options);
+
+/* Refines one of the seeds of the data with the given options. */
+/* Returns 0 on error, including if there is no such seed. */
+int ClownNemesis_CompressorRefineSeed(ClownNemesis_Compressor *compressor, const ClownNemesis_CompressOptions *options, unsigned int seed, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_RefinedSeed *refined_seed);
+
+/* Replaces 'best' with 'other' if 'other' is better: smaller, or as small but with a lower seed number. */
+/* As ties are broken by the seed number, reducing the seeds in any order, such as whichever finishes first, gives the same result. */
+void ClownNemesis_ReduceRefinedSeeds(ClownNemesis_RefinedSeed *best, const ClownNemesis_RefinedSeed *other);
+
+/* Compresses the data with the codes of a refined seed. With the best of all of the seeds of the options, */
+/* this produces exactly the same data as 'ClownNemesis_CompressorCompress' does with those options. */
+/* Returns 0 on error, or 'CLOWNNEMESIS_OVER_BUDGET' if the data is larger than 'max_output_bytes'. */
+int ClownNemesis_CompressorCompressWithRefinedSeed(ClownNemesis_Compressor *compressor, const ClownNemesis_CompressOptions *options, const ClownNemesis_RefinedSeed *refined_seed, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* The codes that tiles in memory are compressed with when they are emitted in chunks. */
+/* Very large data can be emitted in chunks of tiles, each of which can be emitted on its own thread, with its own */
+/* compressor, before they are all written together. The result is exactly the same as 'ClownNemesis_CompressorCompress'. */
+/* The fields are private: use the functions below. */
+typedef struct ClownNemesis_ChunkCodes
+{
+	ClownNemesis_CompressOptions options;
+	unsigned long total_tiles;
+	int xor_mode_enabled;
+	unsigned int decode_cycle_weight;
+	unsigned char codes[16][8], code_lengths[16][8];
+} ClownNemesis_ChunkCodes;
+
+/* The codes of a range of tiles, packed into bytes, with the last byte padded with 0 bits. */
+/* The fields are private: use the functions below. */
+typedef struct ClownNemesis_Chunk
+{
+	unsigned char *bytes;
+	unsigned long total_bits;
+	unsigned long first_tile, end_tile;
+} ClownNemesis_Chunk;
+
+/* Makes the codes that the tiles will be compressed with, using the given options. */
+/* Returns 0 on error. */
+int ClownNemesis_CompressorComputeChunkCodes(ClownNemesis_Compressor *compressor, const ClownNemesis_CompressOptions *options, const unsigned char *tiles, unsigned long total_tiles, ClownNemesis_ChunkCodes *codes);
+
+/* Emits the codes of the tiles from 'first_tile' up to, but not including, 'end_tile'. */
+/* 'tiles' must be all of the tiles that the codes were made for, as the runs of a chunk can continue into the next one. */
+/* The chunk must be freed with 'ClownNemesis_FreeChunk'. Returns 0 on error. */
+int ClownNemesis_CompressorEmitChunk(ClownNemesis_Compressor *compressor, const ClownNemesis_ChunkCodes *codes, const unsigned char *tiles, unsigned long first_tile, unsigned long end_tile, ClownNemesis_Chunk *chunk);
+
+/* Writes the compressed data, joining the chunks together. The chunks must cover all of the tiles, in order. */
+/* Returns 0 on error, or 'CLOWNNEMESIS_OVER_BUDGET' if the data is larger than 'max_output_bytes'. */
+int ClownNemesis_CompressorWriteChunks(ClownNemesis_Compressor *compressor, const ClownNemesis_ChunkCodes *codes, const ClownNemesis_Chunk *chunks, size_t total_chunks, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* Frees the memory of a chunk. */
+void ClownNemesis_FreeChunk(ClownNemesis_Chunk *chunk);
+
+/* The largest that the compressed data of the given number of tiles can be, for preallocating an output buffer. */
+unsigned long ClownNemesis_CompressBound(unsigned long total_tiles);
+
+/* A code table which can be shared by many files, so that one does not need to be made for each of them. */
+typedef struct ClownNemesis_CodeTable
+{
+	/* Non-zero if the data should be compressed in XOR mode. */
+	int xor_mode_enabled;
+	/* The length in bits of the code of each nybble run, indexed by nybble and then by run length minus one. */
+	/* A length of 0 means that the nybble run has no code, and is inlined instead. */
+	/* The codes themselves are derived from the lengths. */
+	unsigned char code_lengths[16][8];
+} ClownNemesis_CodeTable;
+
+/* Compresses the data using the given code table, instead of making one for the data. */
+/* This is much faster, but produces larger data the less the data resembles what the table was made for. */
+/* Returns 0 on error, including if the code lengths do not fit in the code space. */
+int ClownNemesis_CompressWithTable(const ClownNemesis_CodeTable *table, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* Like 'ClownNemesis_CompressWithTable', but using the given compressor. */
+/* Returns 0 on error. */
+int ClownNemesis_CompressorCompressWithTable(ClownNemesis_Compressor *compressor, const ClownNemesis_CodeTable *table, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* The combined nybble runs of a corpus of files, in both regular mode and XOR mode, for making a shared code table. */
+typedef struct ClownNemesis_TrainingHistogram
+{
+	unsigned long occurrences[2][16][8];
+	/* Each file stores its own copy of the code table, so the table is weighed against the runs of all of them. */
+	unsigned long total_files;
+} ClownNemesis_TrainingHistogram;
+
+/* Empties the histogram. */
+void ClownNemesis_TrainingHistogramInitialise(ClownNemesis_TrainingHistogram *histogram);
+
+/* Adds the nybble runs of the given uncompressed data to the histogram. */
+/* Returns 0 on error. */
+int ClownNemesis_TrainingHistogramAdd(ClownNemesis_TrainingHistogram *histogram, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data);
+
+/* The nybble runs of one part of some uncompressed data. Large data can be split into parts which are counted */
+/* separately, such as on different threads, and then merged into exactly the same counts as the whole data. */
+/* The fields are private: use the functions below. */
+typedef struct ClownNemesis_PartialHistogram
+{
+	ClownNemesis_TrainingHistogram histogram;
+	unsigned long total_bytes;
+	/* The first and last stretches of identical nybbles in each mode, which are not counted until it is known whether */
+	/* they continue into the neighbouring parts. 'last_length' is 0 when the whole part is a single stretch. */
+	unsigned char first_nybble[2], last_nybble[2];
+	unsigned long first_length[2], last_length[2];
+} ClownNemesis_PartialHistogram;
+
+/* Counts the nybble runs of one part of some uncompressed data, which must be a whole number of rows (4 bytes). */
+/* 'previous_row' is the 4 bytes before the part, which XOR mode needs, or NULL if this is the first part. */
+/* Returns 0 on error. */
+int ClownNemesis_PartialHistogramCount(ClownNemesis_PartialHistogram *partial, const unsigned char *previous_row, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data);
+
+/* Joins 'second' onto the end of 'first', which must be the part that comes immediately before it. */
+void ClownNemesis_PartialHistogramMerge(ClownNemesis_PartialHistogram *first, const ClownNemesis_PartialHistogram *second);
+
+/* Adds the nybble runs of the merged parts, which should now be all of one file's data, to the histogram. */
+/* The histogram can then be used with 'ClownNemesis_TrainCodeTable' and 'ClownNemesis_CompressWithTable' to compress the data. */
+void ClownNemesis_TrainingHistogramAddPartial(ClownNemesis_TrainingHistogram *histogram, const ClownNemesis_PartialHistogram *partial);
+
+/* Like 'ClownNemesis_CompressorCompress', but with the nybble runs of the data already counted into the histogram, */
+/* such as by merging the parts of it that were counted on separate threads, so that they are not counted again. */
+/* The histogram must be of exactly this data, and nothing else. The compressed data is the same either way. */
+/* Returns 0 on error, or 'CLOWNNEMESIS_OVER_BUDGET' if the data is larger than 'max_output_bytes'. */
+int ClownNemesis_CompressorCompressWithHistogram(ClownNemesis_Compressor *compressor, const ClownNemesis_CompressOptions *options, const ClownNemesis_TrainingHistogram *histogram, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* Like 'ClownNemesis_CompressorComputeChunkCodes', but with the nybble runs of the tiles already counted into the */
+/* histogram, like 'ClownNemesis_CompressorCompressWithHistogram'. The codes are the same either way. */
+/* Returns 0 on error. */
+int ClownNemesis_CompressorComputeChunkCodesWithHistogram(ClownNemesis_Compressor *compressor, const ClownNemesis_CompressOptions *options, const ClownNemesis_TrainingHistogram *histogram, const unsigned char *tiles, unsigned long total_tiles, ClownNemesis_ChunkCodes *codes);
+
+/* Makes the code table which compresses the whole corpus in the histogram the best. */
+void ClownNemesis_TrainCodeTable(ClownNemesis_CodeTable *table, const ClownNemesis_TrainingHistogram *histogram);
+
+/* Returns the exact size of the data that 'ClownNemesis_CompressWithOptions' would produce with the given options, */
+/* without producing it. This is faster than compressing, as the data is only measured instead of being emitted. */
+/* Returns 0 on error. */
+unsigned long ClownNemesis_EstimateCompressedSize(const ClownNemesis_CompressOptions *options, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data);
+
+/* Returns an approximation of the size of the data that 'ClownNemesis_Compress' would produce when not accurate. */
+/* This only counts a sample of the tiles, so it is much faster, which is useful for very large inputs. */
+/* Returns 0 on error. */
+unsigned long ClownNemesis_EstimateCompressedSizeSampled(ClownNemesis_InputCallback read_byte, const void *read_byte_user_data);
+
+/* The most archives that 'ClownNemesis_Split' can split data into. */
+#define CLOWNNEMESIS_MAXIMUM_SEGMENTS 64
+
+/* A range of tiles which should be compressed as its own archive. */
+typedef struct ClownNemesis_Segment
+{
+	unsigned long first_tile;
+	unsigned long total_tiles;
+} ClownNemesis_Segment;
+
+/* Finds the best places to split the data into separate archives, each with its own code table. */
+/* This allows data with more than 0x7FFF tiles to be compressed, and can make data with very different parts smaller. */
+/* Each archive can be compressed and decompressed independently of the others. */
+/* 'segments' must have room for 'CLOWNNEMESIS_MAXIMUM_SEGMENTS' segments, which are written in order. */
+/* Returns the number of segments, or 0 on error. */
+size_t ClownNemesis_Split(ClownNemesis_Segment *segments, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data);
+
+/* The orders in which the tiles of a bitmap can be read. */
+/* ROWS:    Left to right, and then top to bottom, like text. */
+/* COLUMNS: Top to bottom, and then left to right, like the tiles of a Mega Drive sprite. */
+#define CLOWNNEMESIS_TILE_ORDER_ROWS 0
+#define CLOWNNEMESIS_TILE_ORDER_COLUMNS 1
+
+/* A linear bitmap, such as a sprite sheet, which can be compressed without first converting it to tiles. */
+typedef struct ClownNemesis_Bitmap
+{
+	const unsigned char *pixels;
+	/* The size of the bitmap in pixels. Both must be multiples of 8, as the bitmap is divided into 8x8 tiles. */
+	size_t width, height;
+	/* The number of bytes from the start of one row of pixels to the start of the next. */
+	size_t stride;
+	/* Either 4, for two pixels per byte with the left one in the upper nybble, or 8, for one pixel per byte. */
+	/* With 8, only the lower nybble of each pixel is kept, as tiles only have 16 colours. */
+	unsigned int bits_per_pixel;
+	/* One of the 'CLOWNNEMESIS_TILE_ORDER_*' values above. */
+	int tile_order;
+} ClownNemesis_Bitmap;
+
+/* Reads a bitmap as if it were tiles, one byte at a time, without making a converted copy of it. */
+/* The fields are private: use the functions below. */
+typedef struct ClownNemesis_BitmapReader
+{
+	ClownNemesis_Bitmap bitmap;
+	size_t tile, total_tiles;
+	const unsigned char *row;
+	unsigned int row_index, row_bytes_remaining;
+} ClownNemesis_BitmapReader;
+
+/* Sets up a reader for the given bitmap, which must remain valid for as long as the reader is used. */
+/* Returns 0 if the bitmap cannot be divided into tiles. */
+int ClownNemesis_BitmapReaderInitialise(ClownNemesis_BitmapReader *reader, const ClownNemesis_Bitmap *bitmap);
+
+/* An input callback, for passing to any of the compression functions along with a reader as its user data. */
+/* Like the other input callbacks, it returns to the start of the bitmap after reaching its end. */
+int ClownNemesis_ReadBitmap(void *reader);
+
+/* A session keeps some tiles compressed while they are edited one at a time, such as by a tile editor. */
+/* Only the data from an edited tile onwards is emitted again, and only until it lines up with what was emitted before, */
+/* so an edit costs about as much as the tiles it changed. The code table is kept until it is notably worse than a new */
+/* one would be, at which point everything is compressed again. */
+typedef struct ClownNemesis_Session ClownNemesis_Session;
+
+/* Creates a session with a copy of the given tiles, of which there must be between 1 and 0x7FFF, and compresses */
+/* them like 'ClownNemesis_Compress' does when not accurate. */
+/* Returns NULL on error. */
+ClownNemesis_Session* ClownNemesis_SessionCreate(const unsigned char *tiles, unsigned long total_tiles);
+
+/* Frees the session. */
+void ClownNemesis_SessionDestroy(ClownNemesis_Session *session);
+
+/* Replaces one tile (0x20 bytes), and updates the compressed data to match. */
+/* Returns 0 on error, after which the session can only be destroyed. */
+int ClownNemesis_SessionSetTile(ClownNemesis_Session *session, unsigned long tile_index, const unsigned char *tile);
+
+/* Returns the compressed data of the tiles, which is valid until the session is next changed. */
+const unsigned char* ClownNemesis_SessionCompressedData(const ClownNemesis_Session *session, size_t *size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,228 @@
+#include "container.h"
+
+#include <setjmp.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common-internal.h"
+
+#define HEADER_SIZE 12
+#define ENTRY_SIZE 16
+#define CONTAINER_VERSION 1
+
+typedef struct ArchiveReader
+{
+	const unsigned char *bytes;
+	unsigned long size, position;
+} ArchiveReader;
+
+static unsigned long ReadBigEndian(const unsigned char* const bytes, const unsigned int total_bytes)
+{
+	unsigned long value;
+	unsigned int i;
+
+	value = 0;
+
+	for (i = 0; i < total_bytes; ++i)
+		value = value << 8 | bytes[i];
+
+	return value;
+}
+
+static void WriteBigEndian(StateCommon* const state, const unsigned long value, const unsigned int total_bytes)
+{
+	unsigned int i;
+
+	for (i = total_bytes; i-- != 0; )
+		WriteByte(state, (value >> (i * 8)) & 0xFF);
+}
+
+static int ReadArchiveByte(void* const user_data)
+{
+	ArchiveReader* const reader = (ArchiveReader*)user_data;
+
+	if (reader->position == reader->size)
+	{
+		reader->position = 0;
+		return CLOWNNEMESIS_EOF;
+	}
+
+	return reader->bytes[reader->position++];
+}
+
+static int CountByte(void* const user_data, const unsigned char byte)
+{
+	++*(unsigned long*)user_data;
+
+	return byte;
+}
+
+int ClownNemesis_ContainerOpen(ClownNemesis_Container* const container, const void* const bytes, const size_t size)
+{
+	const unsigned char* const header = (const unsigned char*)bytes;
+	unsigned long total_archives;
+
+	if (size < HEADER_SIZE || memcmp(header, "NEMC", 4) != 0 || ReadBigEndian(&header[4], 2) != CONTAINER_VERSION)
+		return 0;
+
+	total_archives = ReadBigEndian(&header[8], 4);
+
+	/* The whole index must be within the container, so that any entry can be read without checking. */
+	if (total_archives > (size - HEADER_SIZE) / ENTRY_SIZE)
+		return 0;
+
+	container->bytes = header;
+	container->size = size;
+	container->total_archives = total_archives;
+
+	return 1;
+}
+
+int ClownNemesis_ContainerGetArchive(const ClownNemesis_Container* const container, const unsigned long index, ClownNemesis_ContainerArchive* const archive)
+{
+	const unsigned char *entry;
+	unsigned long offset, size;
+
+	if (index >= container->total_archives)
+		return 0;
+
+	entry = &container->bytes[HEADER_SIZE + (size_t)index * ENTRY_SIZE];
+	offset = ReadBigEndian(&entry[0], 4);
+	size = ReadBigEndian(&entry[4], 4);
+
+	if (offset > container->size || size > container->size - offset)
+		return 0;
+
+	archive->bytes = &container->bytes[offset];
+	archive->size = size;
+	archive->total_tiles = (unsigned int)ReadBigEndian(&entry[8], 2);
+	archive->crc = ReadBigEndian(&entry[12], 4);
+
+	return 1;
+}
+
+int ClownNemesis_ContainerVerifyArchive(const ClownNemesis_ContainerArchive* const archive)
+{
+	return ClownNemesis_CRC32(0, archive->bytes, archive->size) == archive->crc;
+}
+
+int ClownNemesis_ContainerDecompress(const ClownNemesis_ContainerArchive* const archive, ClownNemesis_Decompressor* const decompressor, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	ArchiveReader reader;
+
+	reader.bytes = archive->bytes;
+	reader.size = archive->size;
+	reader.position = 0;
+
+	if (decompressor != NULL)
+		return ClownNemesis_DecompressorDecompress(decompressor, ReadArchiveByte, &reader, write_byte, write_byte_user_data);
+	else
+		return ClownNemesis_Decompress(ReadArchiveByte, &reader, write_byte, write_byte_user_data);
+}
+
+int ClownNemesis_ContainerWrite(const ClownNemesis_ContainerArchive* const archives, const unsigned long total_archives, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	/* The index alone must fit in the 4-byte offsets. */
+	const cc_bool too_many = total_archives > (0xFFFFFFFF - HEADER_SIZE) / ENTRY_SIZE || total_archives > (size_t)-1 / sizeof(ClownNemesis_ContainerArchive);
+	ClownNemesis_ContainerArchive* const entries = too_many ? NULL : (ClownNemesis_ContainerArchive*)malloc(total_archives == 0 ? 1 : (size_t)total_archives * sizeof(ClownNemesis_ContainerArchive));
+	unsigned long* const offsets = too_many ? NULL : (unsigned long*)malloc(total_archives == 0 ? 1 : (size_t)total_archives * sizeof(unsigned long));
+
+	int success;
+	StateCommon state;
+
+	success = 0;
+
+	InitialiseCommon(&state, NULL, NULL, write_byte, write_byte_user_data);
+
+	if (entries != NULL && offsets != NULL && !setjmp(state.jump_buffer))
+	{
+		unsigned long position, i;
+
+		/* Lay out the archives, checking each of them, and sharing the data of identical archives. */
+		position = HEADER_SIZE + total_archives * ENTRY_SIZE;
+
+		for (i = 0; i < total_archives; ++i)
+		{
+			ClownNemesis_ContainerArchive* const entry = &entries[i];
+			unsigned long total_bytes, j;
+
+			entry->bytes = archives[i].bytes;
+			entry->size = archives[i].size;
+
+			if (entry->size < 2)
+				longjmp(state.jump_buffer, 1);
+
+			/* The archive must decompress to as many tiles as its header says, so that the index can be trusted. */
+			entry->total_tiles = (unsigned int)(ReadBigEndian(entry->bytes, 2) & 0x7FFF);
+			total_bytes = 0;
+
+			if (!ClownNemesis_ContainerDecompress(entry, NULL, CountByte, &total_bytes) || total_bytes != entry->total_tiles * 0x20UL)
+				longjmp(state.jump_buffer, 1);
+
+			entry->crc = ClownNemesis_CRC32(0, entry->bytes, entry->size);
+
+			for (j = 0; j < i; ++j)
+				if (entries[j].crc == entry->crc && entries[j].size == entry->size && memcmp(entries[j].bytes, entry->bytes, entry->size) == 0)
+					break;
+
+			if (j != i)
+			{
+				offsets[i] = offsets[j];
+			}
+			else
+			{
+				position += position & 1;
+
+				if (entry->size > 0xFFFFFFFF - position)
+					longjmp(state.jump_buffer, 1);
+
+				offsets[i] = position;
+				position += entry->size;
+			}
+		}
+
+		WriteByte(&state, 'N');
+		WriteByte(&state, 'E');
+		WriteByte(&state, 'M');
+		WriteByte(&state, 'C');
+		WriteBigEndian(&state, CONTAINER_VERSION, 2);
+		WriteBigEndian(&state, 0, 2);
+		WriteBigEndian(&state, total_archives, 4);
+
+		for (i = 0; i < total_archives; ++i)
+		{
+			WriteBigEndian(&state, offsets[i], 4);
+			WriteBigEndian(&state, entries[i].size, 4);
+			WriteBigEndian(&state, entries[i].total_tiles, 2);
+			WriteBigEndian(&state, 0, 2);
+			WriteBigEndian(&state, entries[i].crc, 4);
+		}
+
+		/* Archives which share the data of an earlier archive have an offset before the current position. */
+		position = HEADER_SIZE + total_archives * ENTRY_SIZE;
+
+		for (i = 0; i < total_archives; ++i)
+		{
+			unsigned long j;
+
+			if (offsets[i] < position)
+				continue;
+
+			for (; position != offsets[i]; ++position)
+				WriteByte(&state, 0);
+
+			for (j = 0; j < entries[i].size; ++j)
+				WriteByte(&state, entries[i].bytes[j]);
+
+			position += entries[i].size;
+		}
+
+		success = 1;
+	}
+
+	free(entries);
+	free(offsets);
+
+	return success;
+}
@@ -0,0 +1,68 @@
+#ifndef HEADER_GUARD_20BE323E_814A_423A_B592_9D02B33C0273
+#define HEADER_GUARD_20BE323E_814A_423A_B592_9D02B33C0273
+
+#include <stddef.h>
+
+#include "common.h"
+#include "decompress.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A container holds many Nemesis archives, with an index at the start so that any of them can be found without reading the others. */
+/* Every number is big-endian. The container starts with: */
+/* - The bytes 'NEMC'. */
+/* - A 2-byte version, which is 1. */
+/* - 2 bytes which are 0. */
+/* - A 4-byte count of the archives. */
+/* That is followed by an entry for each archive: */
+/* - A 4-byte offset of the archive from the start of the container. */
+/* - A 4-byte size of the archive. */
+/* - A 2-byte count of the tiles that the archive decompresses to. */
+/* - 2 bytes which are 0. */
+/* - A 4-byte CRC-32 of the archive. */
+/* The archives come after the index, each at an even offset so that Sega's decoder can read them in place. */
+/* Identical archives may share their data. */
+
+typedef struct ClownNemesis_Container
+{
+	const unsigned char *bytes;
+	size_t size;
+	unsigned long total_archives;
+} ClownNemesis_Container;
+
+typedef struct ClownNemesis_ContainerArchive
+{
+	/* Points into the container's memory, so it is only valid for as long as that is. */
+	const unsigned char *bytes;
+	unsigned long size;
+	unsigned int total_tiles;
+	unsigned long crc;
+} ClownNemesis_ContainerArchive;
+
+/* Reads the header of a container which is in memory, such as a mapped file. The memory is not copied, */
+/* so it must stay valid for as long as the container is used. Returns 0 if it is not a container. */
+int ClownNemesis_ContainerOpen(ClownNemesis_Container *container, const void *bytes, size_t size);
+
+/* Finds an archive by its position in the index, without reading any of the others. */
+/* Returns 0 if there is no such archive, or if its entry refers to data outside of the container. */
+int ClownNemesis_ContainerGetArchive(const ClownNemesis_Container *container, unsigned long index, ClownNemesis_ContainerArchive *archive);
+
+/* Returns non-zero if the archive's data matches its CRC-32. */
+int ClownNemesis_ContainerVerifyArchive(const ClownNemesis_ContainerArchive *archive);
+
+/* Decompresses an archive straight from the container's memory, using the decompressor if it is not NULL. */
+/* The container is only read, so any number of threads can decompress archives from it at once, each with its own decompressor. */
+/* Returns 0 on error. */
+int ClownNemesis_ContainerDecompress(const ClownNemesis_ContainerArchive *archive, ClownNemesis_Decompressor *decompressor, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* Writes a container of the archives, using only their 'bytes' and 'size'. Identical archives share their data. */
+/* Returns 0 on error, such as if an archive is not valid Nemesis data, or the container would be larger than 4GiB. */
+int ClownNemesis_ContainerWrite(const ClownNemesis_ContainerArchive *archives, unsigned long total_archives, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEADER_GUARD_20BE323E_814A_423A_B592_9D02B33C0273 */
@@ -2,6 +2,7 @@
 
 #include <setjmp.h>
 #include <stddef.h>
+#include <stdlib.h>
 #ifdef CLOWNNEMESIS_DEBUG
 #include <stdio.h>
 #endif
@@ -35,8 +36,20 @@ typedef struct State
 
 	unsigned char bits_available;
 	unsigned char bits_buffer;
+
+	/* If not NULL, the runs are passed to this instead of being output as bytes. */
+	ClownNemesis_RunCallback run_callback;
+	void *run_callback_user_data;
+
+	/* An estimate of how long Sega's decoder would take to decode the data. */
+	unsigned long decode_cycles;
 } State;
 
+struct ClownNemesis_Decompressor
+{
+	State state;
+};
+
 static unsigned int PopBit(State* const state)
 {
 	state->bits_buffer <<= 1;
@@ -45,6 +58,7 @@ static unsigned int PopBit(State* const state)
 	{
 		state->bits_available = 8;
 		state->bits_buffer = ReadByte(&state->common);
+		state->decode_cycles += DECODE_CYCLES_PER_BYTE;
 	}
 
 	--state->bits_available;
@@ -122,6 +136,8 @@ static void OutputNybble(State* const state, const unsigned int nybble)
 		for (i = 0; i < 4; ++i)
 			WriteByte(&state->common, (final_output >> (4 - 1 - i) * 8) & 0xFF);
 
+		state->decode_cycles += DECODE_CYCLES_PER_ROW + (state->xor_mode_enabled ? DECODE_CYCLES_PER_XOR_ROW : 0);
+
 		state->previous_output_buffer = final_output;
 	}
 }
@@ -130,6 +146,8 @@ static void OutputNybbles(State* const state, const unsigned int nybble, const u
 {
 	unsigned int i;
 
+	state->decode_cycles += DECODE_CYCLES_PER_NYBBLE * total_nybbles;
+
 	for (i = 0; i < total_nybbles; ++i)
 		OutputNybble(state, nybble);
 }
@@ -181,6 +199,9 @@ static void ProcessCodeTable(State* const state)
 			nybble_run->value = nybble_run_value;
 			nybble_run->length = run_length;
 
+			/* Sega's decoder fills every slot of its lookup table that begins with the code. */
+			state->decode_cycles += DECODE_CYCLES_PER_TABLE_ENTRY + DECODE_CYCLES_PER_TABLE_SLOT * (1u << (8 - total_code_bits));
+
 		#ifdef CLOWNNEMESIS_DEBUG
 			{
 				unsigned int i;
@@ -214,6 +235,8 @@ static void ProcessCodes(State* const state)
 		const unsigned int run_length = nybble_run != NULL ? nybble_run->length : PopBits(state, 3) + 1;
 		const unsigned int nybble = nybble_run != NULL ? nybble_run->value : PopBits(state, 4);
 
+		state->decode_cycles += nybble_run != NULL ? DECODE_CYCLES_PER_CODE : DECODE_CYCLES_PER_INLINE;
+
 		if (nybble_run != NULL)
 		{
 		#ifdef CLOWNNEMESIS_DEBUG
@@ -239,7 +262,10 @@ static void ProcessCodes(State* const state)
 			longjmp(state->common.jump_buffer, 1);
 		}
 
-		OutputNybbles(state, nybble, run_length);
+		if (state->run_callback == NULL)
+			OutputNybbles(state, nybble, run_length);
+		else if (state->run_callback(state->run_callback_user_data, nybble, run_length) == CLOWNNEMESIS_ERROR)
+			longjmp(state->common.jump_buffer, 1);
 
 		nybbles_remaining -= run_length;
 	}
@@ -249,20 +275,28 @@ static void ProcessCodes(State* const state)
 #endif
 }
 
-int ClownNemesis_Decompress(const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+static int Decompress(State* const state, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data, const ClownNemesis_RunCallback run_callback, const void* const run_callback_user_data)
 {
 	int success;
-	State state = {0};
 
 	success = 0;
 
-	InitialiseCommon(&state.common, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
+	/* The code table is cleared by 'ProcessCodeTable', so only the buffers need resetting here. */
+	state->output_buffer = state->previous_output_buffer = 0;
+	state->output_buffer_nybbles_done = 0;
+	state->bits_available = 0;
+	state->bits_buffer = 0;
+	state->decode_cycles = 0;
+	state->run_callback = run_callback;
+	state->run_callback_user_data = (void*)run_callback_user_data;
+
+	InitialiseCommon(&state->common, read_byte, read_byte_user_data, write_byte, write_byte_user_data);
 
-	if (!setjmp(state.common.jump_buffer))
+	if (!setjmp(state->common.jump_buffer))
 	{
-		ProcessHeader(&state);
-		ProcessCodeTable(&state);
-		ProcessCodes(&state);
+		ProcessHeader(state);
+		ProcessCodeTable(state);
+		ProcessCodes(state);
 
 	#ifdef CLOWNNEMESIS_DEBUG
 		{
@@ -270,7 +304,7 @@ int ClownNemesis_Decompress(const ClownNemesis_InputCallback read_byte, const vo
 
 			for (i = 0; i < 1 << 8; ++i)
 			{
-				NybbleRun* const nybble_run = &state.nybble_runs[i];
+				NybbleRun* const nybble_run = &state->nybble_runs[i];
 
 				if (NybbleRunExists(nybble_run))
 				{
@@ -296,4 +330,73 @@ int ClownNemesis_Decompress(const ClownNemesis_InputCallback read_byte, const vo
 	return success;
 }
 
+static int DiscardByte(void* const user_data, const unsigned char byte)
+{
+	(void)user_data;
+
+	return byte;
+}
+
+int ClownNemesis_Decompress(const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	State state;
+
+	return Decompress(&state, read_byte, read_byte_user_data, write_byte, write_byte_user_data, NULL, NULL);
+}
+
+size_t ClownNemesis_DecompressorWorkspaceSize(void)
+{
+	return sizeof(ClownNemesis_Decompressor);
+}
+
+ClownNemesis_Decompressor* ClownNemesis_DecompressorInitialise(void* const workspace)
+{
+	/* The workspace does not need clearing: every decompression sets up the buffers itself, and the code table is */
+	/* cleared when it is read, so a decompressor never needs resetting between decompressions either. */
+	return (ClownNemesis_Decompressor*)workspace;
+}
+
+ClownNemesis_Decompressor* ClownNemesis_DecompressorCreate(void)
+{
+	void* const workspace = malloc(ClownNemesis_DecompressorWorkspaceSize());
+
+	if (workspace == NULL)
+		return NULL;
+
+	return ClownNemesis_DecompressorInitialise(workspace);
+}
+
+void ClownNemesis_DecompressorDestroy(ClownNemesis_Decompressor* const decompressor)
+{
+	free(decompressor);
+}
+
+int ClownNemesis_DecompressorDecompress(ClownNemesis_Decompressor* const decompressor, const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, const ClownNemesis_OutputCallback write_byte, const void* const write_byte_user_data)
+{
+	return Decompress(&decompressor->state, read_byte, read_byte_user_data, write_byte, write_byte_user_data, NULL, NULL);
+}
+
+int ClownNemesis_DecompressRuns(const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data, int* const xor_mode_enabled, const ClownNemesis_RunCallback run_callback, const void* const run_callback_user_data)
+{
+	State state;
+
+	/* No bytes are output, so the output callback is never used. */
+	if (!Decompress(&state, read_byte, read_byte_user_data, DiscardByte, NULL, run_callback, run_callback_user_data))
+		return 0;
+
+	*xor_mode_enabled = state.xor_mode_enabled;
+
+	return 1;
+}
+
+unsigned long ClownNemesis_EstimateDecodeCycles(const ClownNemesis_InputCallback read_byte, const void* const read_byte_user_data)
+{
+	State state;
+
+	if (!Decompress(&state, read_byte, read_byte_user_data, DiscardByte, NULL, NULL, NULL))
+		return 0;
+
+	return state.decode_cycles;
+}
+
 #undef MAXIMUM_CODE_BITS
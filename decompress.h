@@ -1,6 +1,8 @@
 #ifndef HEADER_GUARD_111EDE24_F9D8_44E2_A676_16DE5186D50E
 #define HEADER_GUARD_111EDE24_F9D8_44E2_A676_16DE5186D50E
 
+#include <stddef.h>
+
 #include "common.h"
 
 #ifdef __cplusplus
@@ -10,6 +12,41 @@ extern "C" {
 /* Returns 0 on error. */
 int ClownNemesis_Decompress(ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
 
+/* A decompressor can be reused for any number of decompressions, to avoid setting one up every time. */
+typedef struct ClownNemesis_Decompressor ClownNemesis_Decompressor;
+
+/* The number of bytes of memory that a decompressor needs. */
+size_t ClownNemesis_DecompressorWorkspaceSize(void);
+
+/* Sets up a decompressor in memory provided by the caller, which must be at least 'ClownNemesis_DecompressorWorkspaceSize' bytes large and aligned like memory from 'malloc'. */
+/* The decompressor does not need to be destroyed: the caller simply stops using the memory. */
+/* The memory does not need to be cleared first, and the decompressor never needs resetting, as each decompression */
+/* sets up the state that it uses. */
+ClownNemesis_Decompressor* ClownNemesis_DecompressorInitialise(void *workspace);
+
+/* Allocates and sets up a decompressor. Returns NULL on error. */
+ClownNemesis_Decompressor* ClownNemesis_DecompressorCreate(void);
+
+/* Frees a decompressor that was made by 'ClownNemesis_DecompressorCreate'. */
+void ClownNemesis_DecompressorDestroy(ClownNemesis_Decompressor *decompressor);
+
+/* Like 'ClownNemesis_Decompress', but using the given decompressor. */
+/* Returns 0 on error. */
+int ClownNemesis_DecompressorDecompress(ClownNemesis_Decompressor *decompressor, ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, ClownNemesis_OutputCallback write_byte, const void *write_byte_user_data);
+
+/* Receives a run of 'run_length' nybbles which are all 'nybble'. Returns 'CLOWNNEMESIS_ERROR' to stop decompressing. */
+typedef int (*ClownNemesis_RunCallback)(void *user_data, unsigned int nybble, unsigned int run_length);
+
+/* Like 'ClownNemesis_Decompress', but, instead of outputting bytes, each run of nybbles is passed to 'run_callback' as it is decoded. */
+/* If the data is in XOR mode, then 'xor_mode_enabled' is set to non-zero, and the runs are of the rows after being XORed together. */
+/* Returns 0 on error. */
+int ClownNemesis_DecompressRuns(ClownNemesis_InputCallback read_byte, const void *read_byte_user_data, int *xor_mode_enabled, ClownNemesis_RunCallback run_callback, const void *run_callback_user_data);
+
+/* Returns an estimate of how many cycles Sega's 68000 Nemesis decoder would take to decode the given compressed data. */
+/* This comes from a model of the decoder's instruction timings, so it is approximate, but good for comparing data. */
+/* Returns 0 on error. */
+unsigned long ClownNemesis_EstimateDecodeCycles(ClownNemesis_InputCallback read_byte, const void *read_byte_user_data);
+
 #ifdef __cplusplus
 }
 #endif
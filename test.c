@@ -1,11 +1,14 @@
+#include <limits.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "clowncommon/clowncommon.h"
 
 #include "compress.h"
+#include "container.h"
 #include "decompress.h"
 
 typedef struct MemoryStream
@@ -30,6 +33,672 @@ static void MemoryStream_Clear(MemoryStream* const stream)
 	stream->read_index = stream->write_index = 0;
 }
 
+static const char* const test_files[] = {
+	"tests/s1disasm/artnem/8x8 - GHZ1.nem",
+	"tests/s1disasm/artnem/8x8 - GHZ2.nem",
+	"tests/s1disasm/artnem/8x8 - LZ.nem",
+	"tests/s1disasm/artnem/8x8 - MZ.nem",
+	"tests/s1disasm/artnem/8x8 - SBZ.nem",
+	"tests/s1disasm/artnem/8x8 - SLZ.nem",
+	"tests/s1disasm/artnem/8x8 - SYZ.nem",
+	"tests/s1disasm/artnem/Animal Chicken.nem",
+	"tests/s1disasm/artnem/Animal Flicky.nem",
+	"tests/s1disasm/artnem/Animal Penguin.nem",
+	"tests/s1disasm/artnem/Animal Pig.nem",
+	"tests/s1disasm/artnem/Animal Rabbit.nem",
+	"tests/s1disasm/artnem/Animal Seal.nem",
+	"tests/s1disasm/artnem/Animal Squirrel.nem",
+	"tests/s1disasm/artnem/Boss - Eggman after FZ Fight.nem",
+	"tests/s1disasm/artnem/Boss - Eggman in SBZ2 & FZ.nem",
+	"tests/s1disasm/artnem/Boss - Exhaust Flame.nem",
+	"tests/s1disasm/artnem/Boss - Final Zone.nem",
+	"tests/s1disasm/artnem/Boss - Main.nem",
+	"tests/s1disasm/artnem/Boss - Weapons.nem",
+	"tests/s1disasm/artnem/Continue Screen Sonic.nem",
+	"tests/s1disasm/artnem/Continue Screen Stuff.nem",
+	"tests/s1disasm/artnem/Ending - Credits.nem",
+	"tests/s1disasm/artnem/Ending - Emeralds.nem",
+	"tests/s1disasm/artnem/Ending - Flowers.nem",
+	"tests/s1disasm/artnem/Ending - Sonic.nem",
+	"tests/s1disasm/artnem/Ending - StH Logo.nem",
+	"tests/s1disasm/artnem/Ending - Try Again.nem",
+	"tests/s1disasm/artnem/Enemy Ball Hog.nem",
+	"tests/s1disasm/artnem/Enemy Basaran.nem",
+	"tests/s1disasm/artnem/Enemy Bomb.nem",
+	"tests/s1disasm/artnem/Enemy Burrobot.nem",
+	"tests/s1disasm/artnem/Enemy Buzz Bomber.nem",
+	"tests/s1disasm/artnem/Enemy Caterkiller.nem",
+	"tests/s1disasm/artnem/Enemy Chopper.nem",
+	"tests/s1disasm/artnem/Enemy Crabmeat.nem",
+	"tests/s1disasm/artnem/Enemy Jaws.nem",
+	"tests/s1disasm/artnem/Enemy Motobug.nem",
+	"tests/s1disasm/artnem/Enemy Newtron.nem",
+	"tests/s1disasm/artnem/Enemy Orbinaut.nem",
+	"tests/s1disasm/artnem/Enemy Roller.nem",
+	"tests/s1disasm/artnem/Enemy Splats.nem",
+	"tests/s1disasm/artnem/Enemy Yadrin.nem",
+	"tests/s1disasm/artnem/Explosion.nem",
+	"tests/s1disasm/artnem/Fireballs.nem",
+	"tests/s1disasm/artnem/GHZ Breakable Wall.nem",
+	"tests/s1disasm/artnem/GHZ Bridge.nem",
+	"tests/s1disasm/artnem/GHZ Edge Wall.nem",
+	"tests/s1disasm/artnem/GHZ Flower Stalk.nem",
+	"tests/s1disasm/artnem/GHZ Giant Ball.nem",
+	"tests/s1disasm/artnem/GHZ Purple Rock.nem",
+	"tests/s1disasm/artnem/GHZ Spiked Log.nem",
+	"tests/s1disasm/artnem/GHZ Swinging Platform.nem",
+	"tests/s1disasm/artnem/Game Over.nem",
+	"tests/s1disasm/artnem/Giant Ring Flash.nem",
+	"tests/s1disasm/artnem/HUD - Life Counter Icon.nem",
+	"tests/s1disasm/artnem/HUD.nem",
+	"tests/s1disasm/artnem/Hidden Bonuses.nem",
+	"tests/s1disasm/artnem/Hidden Japanese Credits.nem",
+	"tests/s1disasm/artnem/Invincibility Stars.nem",
+	"tests/s1disasm/artnem/LZ 32x16 Block.nem",
+	"tests/s1disasm/artnem/LZ 32x32 Block.nem",
+	"tests/s1disasm/artnem/LZ Blocks.nem",
+	"tests/s1disasm/artnem/LZ Breakable Pole.nem",
+	"tests/s1disasm/artnem/LZ Bubbles & Countdown.nem",
+	"tests/s1disasm/artnem/LZ Cork.nem",
+	"tests/s1disasm/artnem/LZ Flapping Door.nem",
+	"tests/s1disasm/artnem/LZ Gargoyle & Fireball.nem",
+	"tests/s1disasm/artnem/LZ Harpoon.nem",
+	"tests/s1disasm/artnem/LZ Horizontal Door.nem",
+	"tests/s1disasm/artnem/LZ Rising Platform.nem",
+	"tests/s1disasm/artnem/LZ Spiked Ball & Chain.nem",
+	"tests/s1disasm/artnem/LZ Vertical Door.nem",
+	"tests/s1disasm/artnem/LZ Water & Splashes.nem",
+	"tests/s1disasm/artnem/LZ Water Surface.nem",
+	"tests/s1disasm/artnem/LZ Wheel.nem",
+	"tests/s1disasm/artnem/Lamppost.nem",
+	"tests/s1disasm/artnem/MZ Green Glass Block.nem",
+	"tests/s1disasm/artnem/MZ Green Pushable Block.nem",
+	"tests/s1disasm/artnem/MZ Lava.nem",
+	"tests/s1disasm/artnem/MZ Metal Blocks.nem",
+	"tests/s1disasm/artnem/MZ Switch.nem",
+	"tests/s1disasm/artnem/Monitors.nem",
+	"tests/s1disasm/artnem/Points.nem",
+	"tests/s1disasm/artnem/Prison Capsule.nem",
+	"tests/s1disasm/artnem/Rings.nem",
+	"tests/s1disasm/artnem/SBZ Collapsing Floor.nem",
+	"tests/s1disasm/artnem/SBZ Crushing Girder.nem",
+	"tests/s1disasm/artnem/SBZ Electrocuter.nem",
+	"tests/s1disasm/artnem/SBZ Flaming Pipe.nem",
+	"tests/s1disasm/artnem/SBZ Junction Wheel.nem",
+	"tests/s1disasm/artnem/SBZ Large Horizontal Door.nem",
+	"tests/s1disasm/artnem/SBZ Pizza Cutter.nem",
+	"tests/s1disasm/artnem/SBZ Running Disc.nem",
+	"tests/s1disasm/artnem/SBZ Sliding Floor Trap.nem",
+	"tests/s1disasm/artnem/SBZ Small Vertical Door.nem",
+	"tests/s1disasm/artnem/SBZ Spinning Platform.nem",
+	"tests/s1disasm/artnem/SBZ Stomper.nem",
+	"tests/s1disasm/artnem/SBZ Trapdoor.nem",
+	"tests/s1disasm/artnem/SBZ Vanishing Block.nem",
+	"tests/s1disasm/artnem/SLZ 32x32 Block.nem",
+	"tests/s1disasm/artnem/SLZ Breakable Wall.nem",
+	"tests/s1disasm/artnem/SLZ Cannon.nem",
+	"tests/s1disasm/artnem/SLZ Fan.nem",
+	"tests/s1disasm/artnem/SLZ Little Spikeball.nem",
+	"tests/s1disasm/artnem/SLZ Pylon.nem",
+	"tests/s1disasm/artnem/SLZ Seesaw.nem",
+	"tests/s1disasm/artnem/SLZ Swinging Platform.nem",
+	"tests/s1disasm/artnem/SYZ Bumper.nem",
+	"tests/s1disasm/artnem/SYZ Large Spikeball.nem",
+	"tests/s1disasm/artnem/SYZ Small Spikeball.nem",
+	"tests/s1disasm/artnem/Sega Logo (JP1).nem",
+	"tests/s1disasm/artnem/Sega Logo.nem",
+	"tests/s1disasm/artnem/Shield.nem",
+	"tests/s1disasm/artnem/Signpost.nem",
+	"tests/s1disasm/artnem/Special 1UP.nem",
+	"tests/s1disasm/artnem/Special Birds & Fish.nem",
+	"tests/s1disasm/artnem/Special Clouds.nem",
+	"tests/s1disasm/artnem/Special Emerald Twinkle.nem",
+	"tests/s1disasm/artnem/Special Emeralds.nem",
+	"tests/s1disasm/artnem/Special GOAL.nem",
+	"tests/s1disasm/artnem/Special Ghost.nem",
+	"tests/s1disasm/artnem/Special Glass.nem",
+	"tests/s1disasm/artnem/Special R.nem",
+	"tests/s1disasm/artnem/Special Red-White.nem",
+	"tests/s1disasm/artnem/Special Result Emeralds.nem",
+	"tests/s1disasm/artnem/Special UP-DOWN.nem",
+	"tests/s1disasm/artnem/Special W.nem",
+	"tests/s1disasm/artnem/Special Walls.nem",
+	"tests/s1disasm/artnem/Special ZONE1.nem",
+	"tests/s1disasm/artnem/Special ZONE2.nem",
+	"tests/s1disasm/artnem/Special ZONE3.nem",
+	"tests/s1disasm/artnem/Special ZONE4.nem",
+	"tests/s1disasm/artnem/Special ZONE5.nem",
+	"tests/s1disasm/artnem/Special ZONE6.nem",
+	"tests/s1disasm/artnem/Spikes.nem",
+	"tests/s1disasm/artnem/Spring Horizontal.nem",
+	"tests/s1disasm/artnem/Spring Vertical.nem",
+	"tests/s1disasm/artnem/Switch.nem",
+	"tests/s1disasm/artnem/Title Cards.nem",
+	"tests/s1disasm/artnem/Title Screen Foreground.nem",
+	"tests/s1disasm/artnem/Title Screen Sonic.nem",
+	"tests/s1disasm/artnem/Title Screen TM.nem",
+	"tests/s1disasm/artnem/Unused - Eggman Ending.nem",
+	"tests/s1disasm/artnem/Unused - Explosion.nem",
+	"tests/s1disasm/artnem/Unused - Fireball.nem",
+	"tests/s1disasm/artnem/Unused - GHZ Block.nem",
+	"tests/s1disasm/artnem/Unused - GHZ Log.nem",
+	"tests/s1disasm/artnem/Unused - Goggles.nem",
+	"tests/s1disasm/artnem/Unused - Grass.nem",
+	"tests/s1disasm/artnem/Unused - LZ Sonic.nem",
+	"tests/s1disasm/artnem/Unused - MZ Background.nem",
+	"tests/s1disasm/artnem/Unused - SStage Flash.nem",
+	"tests/s1disasm/artnem/Unused - SYZ Sparkles.nem",
+	"tests/s1disasm/artnem/Unused - Smoke.nem",
+	"tests/s2disasm/art/nemesis/1P and 2P wins text from 2P mode.nem",
+	"tests/s2disasm/art/nemesis/1Player2VS.nem",
+	"tests/s2disasm/art/nemesis/4 stripy blocks from OOZ.nem",
+	"tests/s2disasm/art/nemesis/A few menu blocks.nem",
+	"tests/s2disasm/art/nemesis/A menu box with a shadow.nem",
+	"tests/s2disasm/art/nemesis/ARZ boss.nem",
+	"tests/s2disasm/art/nemesis/Arrow shooter and arrow from ARZ.nem",
+	"tests/s2disasm/art/nemesis/Background art for special stage.nem",
+	"tests/s2disasm/art/nemesis/Balkrie (jet badnik) from SCZ.nem",
+	"tests/s2disasm/art/nemesis/Ball on spring from OOZ (beta holdovers).nem",
+	"tests/s2disasm/art/nemesis/Bear.nem",
+	"tests/s2disasm/art/nemesis/Blowfly from ARZ.nem",
+	"tests/s2disasm/art/nemesis/Bolt end and rope from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Bomb from special stage.nem",
+	"tests/s2disasm/art/nemesis/Bomber badnik from SCZ.nem",
+	"tests/s2disasm/art/nemesis/Bouncer badnik from CNZ.nem",
+	"tests/s2disasm/art/nemesis/Breakaway panels from WFZ.nem",
+	"tests/s2disasm/art/nemesis/Bubble generator.nem",
+	"tests/s2disasm/art/nemesis/Bubbles.nem",
+	"tests/s2disasm/art/nemesis/Burner Platform from OOZ.nem",
+	"tests/s2disasm/art/nemesis/Button.nem",
+	"tests/s2disasm/art/nemesis/Buzzer enemy.nem",
+	"tests/s2disasm/art/nemesis/CNZ boss.nem",
+	"tests/s2disasm/art/nemesis/CNZ elevator.nem",
+	"tests/s2disasm/art/nemesis/CNZ slot machine bars.nem",
+	"tests/s2disasm/art/nemesis/CPZ boss.nem",
+	"tests/s2disasm/art/nemesis/CPZ large moving platform blocks.nem",
+	"tests/s2disasm/art/nemesis/CPZ metal things.nem",
+	"tests/s2disasm/art/nemesis/CPZ spintube exit cover.nem",
+	"tests/s2disasm/art/nemesis/CPZ worm enemy.nem",
+	"tests/s2disasm/art/nemesis/Cascading oil from OOZ.nem",
+	"tests/s2disasm/art/nemesis/Cascading oil hitting oil from OOZ.nem",
+	"tests/s2disasm/art/nemesis/Catapult that shoots Sonic to the side from WFZ.nem",
+	"tests/s2disasm/art/nemesis/Caterpiller platforms from CNZ.nem",
+	"tests/s2disasm/art/nemesis/Chicken.nem",
+	"tests/s2disasm/art/nemesis/Chopper blades for EHZ boss.nem",
+	"tests/s2disasm/art/nemesis/Clouds.nem",
+	"tests/s2disasm/art/nemesis/Coconuts badnik from EHZ.nem",
+	"tests/s2disasm/art/nemesis/Collapsing platform from MCZ.nem",
+	"tests/s2disasm/art/nemesis/Credit Text.nem",
+	"tests/s2disasm/art/nemesis/Diagonal impulse spring from CNZ.nem",
+	"tests/s2disasm/art/nemesis/Diagonal shadow from special stage.nem",
+	"tests/s2disasm/art/nemesis/Diagonal spring.nem",
+	"tests/s2disasm/art/nemesis/Drawbridge logs from MCZ.nem",
+	"tests/s2disasm/art/nemesis/Driller badnik from HTZ.nem",
+	"tests/s2disasm/art/nemesis/Drop target from CNZ.nem",
+	"tests/s2disasm/art/nemesis/Dynamically reloaded cliffs in HTZ background.nem",
+	"tests/s2disasm/art/nemesis/EHZ Pirahna badnik.nem",
+	"tests/s2disasm/art/nemesis/EHZ boss.nem",
+	"tests/s2disasm/art/nemesis/EHZ bridge.nem",
+	"tests/s2disasm/art/nemesis/Eagle.nem",
+	"tests/s2disasm/art/nemesis/Egg Prison.nem",
+	"tests/s2disasm/art/nemesis/Eggpod.nem",
+	"tests/s2disasm/art/nemesis/Eggrobo.nem",
+	"tests/s2disasm/art/nemesis/Emerald from special stage.nem",
+	"tests/s2disasm/art/nemesis/End of level results text.nem",
+	"tests/s2disasm/art/nemesis/Exploding star badnik from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Explosion from special stage.nem",
+	"tests/s2disasm/art/nemesis/Explosion.nem",
+	"tests/s2disasm/art/nemesis/Fan from OOZ.nem",
+	"tests/s2disasm/art/nemesis/Final image of Tails.nem",
+	"tests/s2disasm/art/nemesis/Final image of Tornado with it and Sonic facing screen.nem",
+	"tests/s2disasm/art/nemesis/Fireball 1.nem",
+	"tests/s2disasm/art/nemesis/Fireball 2.nem",
+	"tests/s2disasm/art/nemesis/Fireball 3.nem",
+	"tests/s2disasm/art/nemesis/Firefly from MCZ.nem",
+	"tests/s2disasm/art/nemesis/Flicky.nem",
+	"tests/s2disasm/art/nemesis/Flippers.nem",
+	"tests/s2disasm/art/nemesis/Font using large broken letters.nem",
+	"tests/s2disasm/art/nemesis/Game and Time Over text.nem",
+	"tests/s2disasm/art/nemesis/Green flame from OOZ burners.nem",
+	"tests/s2disasm/art/nemesis/Grounder from ARZ.nem",
+	"tests/s2disasm/art/nemesis/HTZ boss.nem",
+	"tests/s2disasm/art/nemesis/HTZ zip-line platform.nem",
+	"tests/s2disasm/art/nemesis/HUD.nem",
+	"tests/s2disasm/art/nemesis/Hexagonal bumper from CNZ.nem",
+	"tests/s2disasm/art/nemesis/Hook on chain from WFZ.nem",
+	"tests/s2disasm/art/nemesis/Horizontal jet.nem",
+	"tests/s2disasm/art/nemesis/Horizontal shadow from special stage.nem",
+	"tests/s2disasm/art/nemesis/Horizontal spinning blades in WFZ.nem",
+	"tests/s2disasm/art/nemesis/Horizontal spring.nem",
+	"tests/s2disasm/art/nemesis/Invincibility stars.nem",
+	"tests/s2disasm/art/nemesis/Large explosion.nem",
+	"tests/s2disasm/art/nemesis/Large moving platform from CPZ.nem",
+	"tests/s2disasm/art/nemesis/Large spinning wheel from MTZ - indent.nem",
+	"tests/s2disasm/art/nemesis/Large spinning wheel from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Large wooden box from MCZ.nem",
+	"tests/s2disasm/art/nemesis/Lava bubble from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Lava cup from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Leaves in ARZ.nem",
+	"tests/s2disasm/art/nemesis/Lever spring.nem",
+	"tests/s2disasm/art/nemesis/Long horizontal spike.nem",
+	"tests/s2disasm/art/nemesis/MCZ boss.nem",
+	"tests/s2disasm/art/nemesis/MTZ boss.nem",
+	"tests/s2disasm/art/nemesis/MTZ spike block.nem",
+	"tests/s2disasm/art/nemesis/Main patterns from title screen.nem",
+	"tests/s2disasm/art/nemesis/Miles life counter.nem",
+	"tests/s2disasm/art/nemesis/Monitor and contents.nem",
+	"tests/s2disasm/art/nemesis/Monkey.nem",
+	"tests/s2disasm/art/nemesis/Mouse.nem",
+	"tests/s2disasm/art/nemesis/Movie sequence at end of game.nem",
+	"tests/s2disasm/art/nemesis/Moving block from CNZ and CPZ.nem",
+	"tests/s2disasm/art/nemesis/Moving block from CPZ.nem",
+	"tests/s2disasm/art/nemesis/Moving platform from WFZ.nem",
+	"tests/s2disasm/art/nemesis/Numbers.nem",
+	"tests/s2disasm/art/nemesis/OOZ boss.nem",
+	"tests/s2disasm/art/nemesis/OOZ collapsing platform.nem",
+	"tests/s2disasm/art/nemesis/Octopus badnik from OOZ.nem",
+	"tests/s2disasm/art/nemesis/One way barrier from ARZ.nem",
+	"tests/s2disasm/art/nemesis/One way barrier from HTZ.nem",
+	"tests/s2disasm/art/nemesis/Penguin.nem",
+	"tests/s2disasm/art/nemesis/Perfect text.nem",
+	"tests/s2disasm/art/nemesis/Pictures in level preview box from level select.nem",
+	"tests/s2disasm/art/nemesis/Pig.nem",
+	"tests/s2disasm/art/nemesis/Platform on belt in WFZ.nem",
+	"tests/s2disasm/art/nemesis/Praying mantis badnik from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Pull switch from MCZ.nem",
+	"tests/s2disasm/art/nemesis/Push spring from OOZ.nem",
+	"tests/s2disasm/art/nemesis/Rabbit.nem",
+	"tests/s2disasm/art/nemesis/Red horizontal laser from WFZ.nem",
+	"tests/s2disasm/art/nemesis/Retracting platform from WFZ.nem",
+	"tests/s2disasm/art/nemesis/Rexxon (lava snake) from HTZ.nem",
+	"tests/s2disasm/art/nemesis/Ring.nem",
+	"tests/s2disasm/art/nemesis/Rising platform from OOZ.nem",
+	"tests/s2disasm/art/nemesis/Robotnik's head.nem",
+	"tests/s2disasm/art/nemesis/Robotnik's lower half.nem",
+	"tests/s2disasm/art/nemesis/Robotnik.nem",
+	"tests/s2disasm/art/nemesis/Rock from HTZ.nem",
+	"tests/s2disasm/art/nemesis/Rocket thruster for Tornado.nem",
+	"tests/s2disasm/art/nemesis/Round bumper from CNZ.nem",
+	"tests/s2disasm/art/nemesis/SEGA.nem",
+	"tests/s2disasm/art/nemesis/Scratch from WFZ.nem",
+	"tests/s2disasm/art/nemesis/Seahorse from OOZ.nem",
+	"tests/s2disasm/art/nemesis/Seal.nem",
+	"tests/s2disasm/art/nemesis/See-saw in HTZ.nem",
+	"tests/s2disasm/art/nemesis/Shaded blocks from intro.nem",
+	"tests/s2disasm/art/nemesis/Shark from ARZ.nem",
+	"tests/s2disasm/art/nemesis/Shellcracker badnik from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Shield.nem",
+	"tests/s2disasm/art/nemesis/Signpost.nem",
+	"tests/s2disasm/art/nemesis/Silver Sonic.nem",
+	"tests/s2disasm/art/nemesis/Similarly shaded blocks from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Small cog from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Small pictures of Sonic and final image of Sonic in Super Sonic mode.nem",
+	"tests/s2disasm/art/nemesis/Small pictures of Sonic and final image of Sonic.nem",
+	"tests/s2disasm/art/nemesis/Small pictures of Tornado in final ending sequence.nem",
+	"tests/s2disasm/art/nemesis/Small yellow moving platform from CPZ.nem",
+	"tests/s2disasm/art/nemesis/Smoke trail from CPZ and HTZ bosses.nem",
+	"tests/s2disasm/art/nemesis/Snake badnik from MCZ.nem",
+	"tests/s2disasm/art/nemesis/Sol badnik from HTZ.nem",
+	"tests/s2disasm/art/nemesis/Sonic and Miles number text from special stage.nem",
+	"tests/s2disasm/art/nemesis/Sonic and Tails animation frames in special stage.nem",
+	"tests/s2disasm/art/nemesis/Sonic and Tails from title screen.nem",
+	"tests/s2disasm/art/nemesis/Sonic continue.nem",
+	"tests/s2disasm/art/nemesis/Sonic lives counter.nem",
+	"tests/s2disasm/art/nemesis/Sonic the Hedgehog 2 image at end of credits.nem",
+	"tests/s2disasm/art/nemesis/Special stage Player VS Player text.nem",
+	"tests/s2disasm/art/nemesis/Special stage messages and icons.nem",
+	"tests/s2disasm/art/nemesis/Special stage results screen art and some emeralds.nem",
+	"tests/s2disasm/art/nemesis/Special stage ring art.nem",
+	"tests/s2disasm/art/nemesis/Speed booster from CPZ.nem",
+	"tests/s2disasm/art/nemesis/Spider badnik from CPZ.nem",
+	"tests/s2disasm/art/nemesis/Spike from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Spiked ball from OOZ.nem",
+	"tests/s2disasm/art/nemesis/Spikes.nem",
+	"tests/s2disasm/art/nemesis/Spikey ball from CNZ slots.nem",
+	"tests/s2disasm/art/nemesis/Spin tube flash from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Squirrel.nem",
+	"tests/s2disasm/art/nemesis/Standard font.nem",
+	"tests/s2disasm/art/nemesis/Star pole.nem",
+	"tests/s2disasm/art/nemesis/Stars in special stage.nem",
+	"tests/s2disasm/art/nemesis/Start text from special stage.nem",
+	"tests/s2disasm/art/nemesis/Steam from MTZ.nem",
+	"tests/s2disasm/art/nemesis/Striped blocks from CPZ.nem",
+	"tests/s2disasm/art/nemesis/Stripy blocks from CPZ.nem",
+	"tests/s2disasm/art/nemesis/Super Sonic stars.nem",
+	"tests/s2disasm/art/nemesis/Swinging platform from OOZ.nem",
+	"tests/s2disasm/art/nemesis/Tails continue.nem",
+	"tests/s2disasm/art/nemesis/Tails life counter.nem",
+	"tests/s2disasm/art/nemesis/Tails on continue screen.nem",
+	"tests/s2disasm/art/nemesis/Tails text patterns from special stage.nem",
+	"tests/s2disasm/art/nemesis/The Tornado.nem",
+	"tests/s2disasm/art/nemesis/Thrust from Robotnik's getaway ship in WFZ.nem",
+	"tests/s2disasm/art/nemesis/Tilting plaforms in WFZ.nem",
+	"tests/s2disasm/art/nemesis/Title card.nem",
+	"tests/s2disasm/art/nemesis/Top of water in ARZ.nem",
+	"tests/s2disasm/art/nemesis/Top of water in HPZ and CNZ.nem",
+	"tests/s2disasm/art/nemesis/Transporter ball from OOZ.nem",
+	"tests/s2disasm/art/nemesis/Turtle badnik from SCZ.nem",
+	"tests/s2disasm/art/nemesis/Turtle.nem",
+	"tests/s2disasm/art/nemesis/Unused badnik from WFZ.nem",
+	"tests/s2disasm/art/nemesis/Unused vertical laser in WFZ.nem",
+	"tests/s2disasm/art/nemesis/Vertical impulse spring.nem",
+	"tests/s2disasm/art/nemesis/Vertical shadow from special stage.nem",
+	"tests/s2disasm/art/nemesis/Vertical spinning blades in WFZ.nem",
+	"tests/s2disasm/art/nemesis/Vertical spring.nem",
+	"tests/s2disasm/art/nemesis/Vine that lowers from MCZ.nem",
+	"tests/s2disasm/art/nemesis/WFZ boss chamber switch.nem",
+	"tests/s2disasm/art/nemesis/WFZ boss.nem",
+	"tests/s2disasm/art/nemesis/Wall turret from WFZ.nem",
+	"tests/s2disasm/art/nemesis/Waterfall tiles.nem",
+	"tests/s2disasm/art/nemesis/Weird crawling badnik from CPZ.nem",
+	"tests/s2disasm/art/nemesis/Wheel for belt in WFZ.nem",
+	"tests/s2disasm/art/nemesis/Window in back that Robotnik looks through in DEZ.nem",
+	"tests/skdisasm/General/2P Zone/Nemesis Art/Lap Numbers.bin",
+	"tests/skdisasm/General/2P Zone/Nemesis Art/Misc Art 1.bin",
+	"tests/skdisasm/General/2P Zone/Nemesis Art/Misc Art 2.bin",
+	"tests/skdisasm/General/2P Zone/Nemesis Art/Misc Art 3.bin",
+	"tests/skdisasm/General/2P Zone/Nemesis Art/Position Icons.bin",
+	"tests/skdisasm/General/2P Zone/Nemesis Art/Spindash Dust.bin",
+	"tests/skdisasm/General/2P Zone/Nemesis Art/Start Post.bin",
+	"tests/skdisasm/General/2P Zone/Nemesis Art/Time Display.bin",
+	"tests/skdisasm/General/Blue Sphere/Nemesis Art/SK Logo.bin",
+	"tests/skdisasm/General/Blue Sphere/Nemesis Art/Tails Pose.bin",
+	"tests/skdisasm/General/Ending/Nemesis Art/Knuckles Ending Pose.bin",
+	"tests/skdisasm/General/Ending/Nemesis Art/Large Text.bin",
+	"tests/skdisasm/General/Ending/Nemesis Art/S3 8x16 Font.bin",
+	"tests/skdisasm/General/Ending/Nemesis Art/S3 Ending Graphics.bin",
+	"tests/skdisasm/General/Ending/Nemesis Art/S3 Large Text.bin",
+	"tests/skdisasm/General/S2Menu/Nemesis Art/1P 2P Wins.bin",
+	"tests/skdisasm/General/S2Menu/Nemesis Art/2P Options.bin",
+	"tests/skdisasm/General/S2Menu/Nemesis Art/Level Select Icons.bin",
+	"tests/skdisasm/General/S2Menu/Nemesis Art/Menu Box.bin",
+	"tests/skdisasm/General/S2Menu/Nemesis Art/Signpost.bin",
+	"tests/skdisasm/General/S2Menu/Nemesis Art/Sonic Continue Icon.bin",
+	"tests/skdisasm/General/S2Menu/Nemesis Art/Tails Continue Icon.bin",
+	"tests/skdisasm/General/S2Menu/Nemesis Art/Tails Continue Sprites.bin",
+	"tests/skdisasm/General/Special Stage/Nemesis Art/BG.bin",
+	"tests/skdisasm/General/Special Stage/Nemesis Art/Digits.bin",
+	"tests/skdisasm/General/Special Stage/Nemesis Art/Eosian Spheres.bin",
+	"tests/skdisasm/General/Special Stage/Nemesis Art/Get Blue Spheres Arrow.bin",
+	"tests/skdisasm/General/Special Stage/Nemesis Art/Get Blue Spheres.bin",
+	"tests/skdisasm/General/Special Stage/Nemesis Art/Icons.bin",
+	"tests/skdisasm/General/Special Stage/Nemesis Art/Layout.bin",
+	"tests/skdisasm/General/Special Stage/Nemesis Art/Ring.bin",
+	"tests/skdisasm/General/Special Stage/Nemesis Art/Shadow.bin",
+	"tests/skdisasm/General/Special Stage/Nemesis Art/Sphere.bin",
+	"tests/skdisasm/General/Sprites/Animals/Blue Flicky.bin",
+	"tests/skdisasm/General/Sprites/Animals/Chicken.bin",
+	"tests/skdisasm/General/Sprites/Animals/Penguin.bin",
+	"tests/skdisasm/General/Sprites/Animals/Pig.bin",
+	"tests/skdisasm/General/Sprites/Animals/Rabbit.bin",
+	"tests/skdisasm/General/Sprites/Animals/Seal.bin",
+	"tests/skdisasm/General/Sprites/Animals/Squirrel.bin",
+	"tests/skdisasm/General/Sprites/Boss Explosion/Boss Explosion.bin",
+	"tests/skdisasm/General/Sprites/Bubbles/Bubbles.bin",
+	"tests/skdisasm/General/Sprites/Buggernaut/Buggernaut.bin",
+	"tests/skdisasm/General/Sprites/Buttons/Gray Button.bin",
+	"tests/skdisasm/General/Sprites/Continue/Player Sprites.bin",
+	"tests/skdisasm/General/Sprites/Continue/Player Icons.bin",
+	"tests/skdisasm/General/Sprites/Continue/Digits.bin",
+	"tests/skdisasm/General/Sprites/Egg Capsule/Egg Capsule.bin",
+	"tests/skdisasm/General/Sprites/Egg Robo/Egg Robo Run.bin",
+	"tests/skdisasm/General/Sprites/Egg Robo/Egg Robo Stand.bin",
+	"tests/skdisasm/General/Sprites/Enemy Misc/EnemyPtsStarpost.bin",
+	"tests/skdisasm/General/Sprites/Enemy Misc/Explosion.bin",
+	"tests/skdisasm/General/Sprites/Game Over/GameOver.bin",
+	"tests/skdisasm/General/Sprites/HUD Icon/Knuckles Life Icon.bin",
+	"tests/skdisasm/General/Sprites/HUD Icon/Miles Life Icon.bin",
+	"tests/skdisasm/General/Sprites/HUD Icon/Sonic Life Icon.bin",
+	"tests/skdisasm/General/Sprites/HUD Icon/Tails Life Icon.bin",
+	"tests/skdisasm/General/Sprites/Knuckles/Cutscene/Knuckles Bomb.bin",
+	"tests/skdisasm/General/Sprites/Level Misc/Diagonal Spring.bin",
+	"tests/skdisasm/General/Sprites/Level Misc/SpikesSprings.bin",
+	"tests/skdisasm/General/Sprites/Monitors/Monitors.bin",
+	"tests/skdisasm/General/Sprites/Ring/RingHUDText.bin",
+	"tests/skdisasm/General/Sprites/Robotnik/FBZ Robotnik Head.bin",
+	"tests/skdisasm/General/Sprites/Robotnik/FBZ Robotnik Run.bin",
+	"tests/skdisasm/General/Sprites/Robotnik/FBZ Robotnik Stand.bin",
+	"tests/skdisasm/General/Sprites/Robotnik/Ship.bin",
+	"tests/skdisasm/General/Sprites/Signpost/Stub.bin",
+	"tests/skdisasm/General/Sprites/Snowboard/Snowboard Dust.bin",
+	"tests/skdisasm/General/Title/Nemesis Art/S3 Banner.bin",
+	"tests/skdisasm/General/Title/Nemesis Art/S3 Screen Text.bin",
+	"tests/skdisasm/General/Title/Nemesis Art/S3 Sonic Sprites.bin",
+	"tests/skdisasm/General/Title/Nemesis Art/SK ANDKnuckles.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/BG Tree.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Cork Floor 1.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Cork Floor 2.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Falling Log.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Intro Waves.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Miniboss Fire.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Miniboss Small.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Miniboss.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Misc Art 1.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Misc Art 2.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Swing Vine.bin",
+	"tests/skdisasm/Levels/AIZ/Nemesis Art/Zip Vine.bin",
+	"tests/skdisasm/Levels/BPZ/Nemesis Art/Misc Art.bin",
+	"tests/skdisasm/Levels/CGZ/Nemesis Art/Platform.bin",
+	"tests/skdisasm/Levels/CNZ/Nemesis Art/End Boss.bin",
+	"tests/skdisasm/Levels/CNZ/Nemesis Art/Miniboss.bin",
+	"tests/skdisasm/Levels/CNZ/Nemesis Art/Misc Art.bin",
+	"tests/skdisasm/Levels/CNZ/Nemesis Art/Platform.bin",
+	"tests/skdisasm/Levels/DEZ/Nemesis Art/Act 2 Extra Art.bin",
+	"tests/skdisasm/Levels/DEZ/Nemesis Art/Miniboss.bin",
+	"tests/skdisasm/Levels/DEZ/Nemesis Art/Misc Art.bin",
+	"tests/skdisasm/Levels/DPZ/Nemesis Art/Misc Art.bin",
+	"tests/skdisasm/Levels/EMZ/Nemesis Art/Misc Art.bin",
+	"tests/skdisasm/Levels/FBZ/Nemesis Art/Act 2 Subboss.bin",
+	"tests/skdisasm/Levels/FBZ/Nemesis Art/Egg Capsule.bin",
+	"tests/skdisasm/Levels/FBZ/Nemesis Art/End Boss Flame.bin",
+	"tests/skdisasm/Levels/FBZ/Nemesis Art/End Boss.bin",
+	"tests/skdisasm/Levels/FBZ/Nemesis Art/Misc Art 1.bin",
+	"tests/skdisasm/Levels/FBZ/Nemesis Art/Misc Art 2.bin",
+	"tests/skdisasm/Levels/FBZ/Nemesis Art/Outdoors.bin",
+	"tests/skdisasm/Levels/FBZ/Nemesis Art/S3 Miniboss.bin",
+	"tests/skdisasm/Levels/Gumball/Nemesis Art/Gumball Bonus.bin",
+	"tests/skdisasm/Levels/FBZ/Nemesis Art/Outdoors.bin",
+	"tests/skdisasm/Levels/HCZ/Nemesis Art/Act 2 Block Platform.bin",
+	"tests/skdisasm/Levels/HCZ/Nemesis Art/Act 2 Knuckles Wall.bin",
+	"tests/skdisasm/Levels/HCZ/Nemesis Art/Act 2 Slide.bin",
+	"tests/skdisasm/Levels/HCZ/Nemesis Art/Button.bin",
+	"tests/skdisasm/Levels/HCZ/Nemesis Art/End Boss.bin",
+	"tests/skdisasm/Levels/HCZ/Nemesis Art/Miniboss.bin",
+	"tests/skdisasm/Levels/HCZ/Nemesis Art/Misc Art.bin",
+	"tests/skdisasm/Levels/HCZ/Nemesis Art/Spike Ball.bin",
+	"tests/skdisasm/Levels/HCZ/Nemesis Art/Water Rush.bin",
+	"tests/skdisasm/Levels/HCZ/Nemesis Art/Wave Splash.bin",
+	"tests/skdisasm/Levels/HPZ/Nemesis Art/Emerald Misc Art.bin",
+	"tests/skdisasm/Levels/HPZ/Nemesis Art/Gray Emerald.bin",
+	"tests/skdisasm/Levels/ICZ/Nemesis Art/End Boss.bin",
+	"tests/skdisasm/Levels/ICZ/Nemesis Art/Intro Sprites.bin",
+	"tests/skdisasm/Levels/ICZ/Nemesis Art/Miniboss.bin",
+	"tests/skdisasm/Levels/ICZ/Nemesis Art/Misc Art 1.bin",
+	"tests/skdisasm/Levels/ICZ/Nemesis Art/Misc Art 2.bin",
+	"tests/skdisasm/Levels/ICZ/Nemesis Art/Teleporter Beam.bin",
+	"tests/skdisasm/Levels/LBZ/Nemesis Art/Act 2 Misc Art.bin",
+	"tests/skdisasm/Levels/LBZ/Nemesis Art/Final Boss 1.bin",
+	"tests/skdisasm/Levels/LBZ/Nemesis Art/Misc Art.bin",
+	"tests/skdisasm/Levels/LBZ/Nemesis Art/Tube Transport.bin",
+	"tests/skdisasm/Levels/LRZ/Nemesis Art/Act 2 Misc Art.bin",
+	"tests/skdisasm/Levels/LRZ/Nemesis Art/Act 2 Spinning Drum.bin",
+	"tests/skdisasm/Levels/LRZ/Nemesis Art/Big Spike Ball.bin",
+	"tests/skdisasm/Levels/LRZ/Nemesis Art/Misc Art.bin",
+	"tests/skdisasm/Levels/LRZ/Nemesis Art/Spike Crush.bin",
+	"tests/skdisasm/Levels/MGZ/Nemesis Art/Direction Signs.bin",
+	"tests/skdisasm/Levels/MGZ/Nemesis Art/Misc Art 1.bin",
+	"tests/skdisasm/Levels/MGZ/Nemesis Art/Misc Art 2.bin",
+	"tests/skdisasm/Levels/MGZ/Nemesis Art/Spire.bin",
+	"tests/skdisasm/Levels/MHZ/Nemesis Art/Misc Art.bin",
+	"tests/skdisasm/Levels/Pachinko/Nemesis Art/Main.bin",
+	"tests/skdisasm/Levels/Slots/Nemesis Art/Blocks.bin",
+	"tests/skdisasm/Levels/SOZ/Nemesis Art/Act 2 Extra Art.bin",
+	"tests/skdisasm/Levels/SOZ/Nemesis Art/Misc Art.bin",
+	"tests/skdisasm/Levels/SOZ/Nemesis Art/Tile.bin",
+	"tests/skdisasm/Levels/SSZ/Nemesis Art/Misc.bin",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Aquis.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Arrow_S.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Asteron.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/AutoDoor.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BBumpers.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BMonster.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/B_Blades.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Backgnd.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Balkiry.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Ball.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Batbot.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Bear.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Blink.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BlueBird.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Boost_Up.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Boss.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BossBall.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BossFire.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Boss_Car.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Boss_Smk.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Box.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Bridge.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BrkBlock.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BrkBst_H.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BrkBst_V.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Bubbles.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Bumpers.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Buzzer.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/CNZDyn_Init.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/CPZBoss.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/CPZDyn_Init.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/CPZPlatform.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Cannon.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Chicken.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/ChopChop.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Clp_Ptfm.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Clucker.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Coconuts.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Crawl.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Crawlton.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Crocobot.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/DHZBoss.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/DHZBox.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/DSpring1.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/D_Launch.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/D_Spring.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Dinobot.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/DynInit2.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Dyn_Init.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/EHZBridge.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/EHZWatrFall.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Elevator.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Emerald.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/EndPanel.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Explosn.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Explosns.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Fans.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Fire_Bst.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Fireball.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Flasher.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Flippers.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/GBumpers.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/GSpkball.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/GT_Over.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Gear.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/GearHole.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Grabber.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/GreenPtf.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Grounder.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/HPZBridge.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/HPZWatrFall.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/HTZAutoDoor.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/HTZDyn_Init.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/H_Spikes.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/H_Spring.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Harp_Ptf.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Harpoon.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Hud.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/HudSonic.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/InvStars.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/LampPost.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Lander.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Leaves.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/LvBubble.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/MZDyn_Init.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/MZElevator.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/MZLvBubble.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Masher.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Metal_St.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/MiniGear.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Miscelns.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Monitors.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Monkey.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Motobug.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Mouse.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/NGHZAutoDoor.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/NGHZBoss.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/NGHZDyn_Init.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/NGHZWatrSurf.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Nebula.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/OC_Ptfrm.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/OOZBoss.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/OOZDyn_Init.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/OOZElevator.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/OOZPlatform.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Octus.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Oil.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Oil_01.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Orbs.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Oxygen.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Parallel.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Penguin.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Pig.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Pigeon.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Piranha.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Platform.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Points.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Rabbit.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Rexon.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Rhinobot.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Rings.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Robotnik.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Rock.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/ScrewNut.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Seal.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/See-saw.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/See-sawb.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Sega.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Shellcrc.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Shield.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/ShpBoost.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Slicer.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SlotMach.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SncMlScr.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SpeedBst.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SpgTubes.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Spikball.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Spiker.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Spikes.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SpinBall.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SpngPush.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Squirrel.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Steam.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Switch.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SwngPtfm.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Telefrcs.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/TitleScr.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/TlpFlash.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Tri_Ptfm.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Turtle.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Turtloid.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/UnkFball.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/UnkPtfm.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/V_Launch.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/V_Spring.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Vines.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Vines_1.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/W_Splash.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/WatrSurf.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Whisp.nem",
+	"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Worms.nem",
+};
+
 static int ReadByteFromFile(void* const user_data)
 {
 	FILE* const file = (FILE*)user_data;
@@ -88,688 +757,900 @@ static int WriteByteToMemoryStream(void* const user_data, const unsigned char by
 	return byte;
 }
 
-static void DoTests(const cc_bool accurate)
+static cc_bool ReadTestFileTiles(const char* const file_path, MemoryStream* const tile_stream)
+{
+	/* Returns cc_false if the file is not there, as not every copy of the tests has every file. */
+	cc_bool success;
+	FILE* const file = fopen(file_path, "rb");
+
+	MemoryStream_Clear(tile_stream);
+
+	if (file == NULL)
+		return cc_false;
+
+	success = ClownNemesis_Decompress(ReadByteFromFile, file, WriteByteToMemoryStream, tile_stream);
+
+	fclose(file);
+
+	if (!success)
+		fprintf(stdout, "Could not decompress file '%s'.\n", file_path);
+
+	return success;
+}
+
+static cc_bool TestBudget(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, MemoryStream* const input_stream, MemoryStream* const scratch_stream, const size_t compressed_size)
+{
+	/* The data must fit a budget of exactly its size, and be rejected by a budget of one byte less. */
+	ClownNemesis_CompressOptions budgeted_options;
+	int fits, does_not_fit;
+
+	budgeted_options = *options;
+
+	budgeted_options.max_output_bytes = compressed_size;
+	MemoryStream_Clear(scratch_stream);
+	fits = ClownNemesis_CompressorCompress(compressor, &budgeted_options, ReadByteFromMemoryStream, input_stream, WriteByteToMemoryStream, scratch_stream);
+
+	budgeted_options.max_output_bytes = compressed_size - 1;
+	MemoryStream_Clear(scratch_stream);
+	does_not_fit = ClownNemesis_CompressorCompress(compressor, &budgeted_options, ReadByteFromMemoryStream, input_stream, WriteByteToMemoryStream, scratch_stream);
+
+	MemoryStream_Clear(scratch_stream);
+
+	return fits == 1 && does_not_fit == CLOWNNEMESIS_OVER_BUDGET;
+}
+
+static cc_bool TestBitmap(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const MemoryStream* const tile_stream, MemoryStream* const scratch_stream, const MemoryStream* const compressed_stream)
+{
+	/* The tiles are laid out as an 8-bit bitmap in column order, with junk in the upper nybbles and at the end of each row, */
+	/* which must compress identically to the tiles themselves. */
+	cc_bool success;
+	ClownNemesis_Bitmap bitmap;
+	unsigned char *pixels;
+	size_t tiles_across, tiles_down, i;
+
+	const size_t total_tiles = tile_stream->write_index / 0x20;
+
+	for (tiles_across = 5; total_tiles % tiles_across != 0; --tiles_across);
+	tiles_down = total_tiles / tiles_across;
+
+	bitmap.width = tiles_across * 8;
+	bitmap.height = tiles_down * 8;
+	bitmap.stride = bitmap.width + 3;
+	bitmap.bits_per_pixel = 8;
+	bitmap.tile_order = CLOWNNEMESIS_TILE_ORDER_COLUMNS;
+
+	success = cc_false;
+	pixels = (unsigned char*)malloc(bitmap.stride * bitmap.height + 1);
+
+	if (pixels != NULL)
+	{
+		ClownNemesis_BitmapReader reader;
+
+		memset(pixels, 0xA5, bitmap.stride * bitmap.height + 1);
+
+		for (i = 0; i < tile_stream->write_index * 2; ++i)
+		{
+			const size_t tile = i / 0x40, y = i / 8 % 8, x = i % 8;
+			unsigned char* const pixel = &pixels[(tile % tiles_down * 8 + y) * bitmap.stride + tile / tiles_down * 8 + x];
+
+			*pixel = (*pixel & 0xF0) | ((tile_stream->buffer[i / 2] >> (i % 2 == 0 ? 4 : 0)) & 0xF);
+		}
+
+		bitmap.pixels = pixels;
+		MemoryStream_Clear(scratch_stream);
+
+		success = ClownNemesis_BitmapReaderInitialise(&reader, &bitmap)
+		       && ClownNemesis_CompressorCompress(compressor, options, ClownNemesis_ReadBitmap, &reader, WriteByteToMemoryStream, scratch_stream)
+		       && scratch_stream->write_index == compressed_stream->write_index
+		       && memcmp(scratch_stream->buffer, compressed_stream->buffer, compressed_stream->write_index) == 0;
+
+		MemoryStream_Clear(scratch_stream);
+		free(pixels);
+	}
+
+	return success;
+}
+
+static cc_bool TestRecompress(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, MemoryStream* const original_compressed_stream, MemoryStream* const scratch_stream, const MemoryStream* const compressed_stream)
+{
+	/* Recompressing the original file must produce the same data as decompressing it and then compressing it. */
+	cc_bool success;
+
+	MemoryStream_Clear(scratch_stream);
+	original_compressed_stream->read_index = 0;
+
+	success = ClownNemesis_CompressorRecompress(compressor, options, ReadByteFromMemoryStream, original_compressed_stream, WriteByteToMemoryStream, scratch_stream)
+	       && scratch_stream->write_index == compressed_stream->write_index
+	       && memcmp(scratch_stream->buffer, compressed_stream->buffer, compressed_stream->write_index) == 0;
+
+	MemoryStream_Clear(scratch_stream);
+
+	return success;
+}
+
+static cc_bool TestPartialHistograms(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, MemoryStream* const input_stream, MemoryStream* const scratch_stream, const MemoryStream* const compressed_stream)
+{
+	/* Counting the data in three parts, and then merging them, must give the same counts as counting it all at once, */
+	/* and compressing the data with those counts must produce the same data as counting them while compressing. */
+	ClownNemesis_TrainingHistogram whole_histogram, merged_histogram;
+	ClownNemesis_PartialHistogram partials[3];
+	size_t i;
+	cc_bool success;
+
+	const size_t total_rows = input_stream->write_index / 4;
+
+	ClownNemesis_TrainingHistogramInitialise(&whole_histogram);
+	ClownNemesis_TrainingHistogramInitialise(&merged_histogram);
+
+	if (!ClownNemesis_TrainingHistogramAdd(&whole_histogram, ReadByteFromMemoryStream, input_stream))
+		return cc_false;
+
+	for (i = 0; i < CC_COUNT_OF(partials); ++i)
+	{
+		const size_t start = total_rows * i / CC_COUNT_OF(partials) * 4;
+		const size_t end = total_rows * (i + 1) / CC_COUNT_OF(partials) * 4;
+		size_t j;
+
+		MemoryStream_Clear(scratch_stream);
+
+		for (j = start; j < end; ++j)
+			WriteByteToMemoryStream(scratch_stream, input_stream->buffer[j]);
+
+		if (!ClownNemesis_PartialHistogramCount(&partials[i], i == 0 ? NULL : &input_stream->buffer[start - 4], ReadByteFromMemoryStream, scratch_stream))
+			return cc_false;
+	}
+
+	MemoryStream_Clear(scratch_stream);
+
+	ClownNemesis_PartialHistogramMerge(&partials[1], &partials[2]);
+	ClownNemesis_PartialHistogramMerge(&partials[0], &partials[1]);
+	ClownNemesis_TrainingHistogramAddPartial(&merged_histogram, &partials[0]);
+
+	if (memcmp(&whole_histogram, &merged_histogram, sizeof(whole_histogram)) != 0
+	 || !ClownNemesis_CompressorCompressWithHistogram(compressor, options, &merged_histogram, ReadByteFromMemoryStream, input_stream, WriteByteToMemoryStream, scratch_stream))
+		return cc_false;
+
+	success = scratch_stream->write_index == compressed_stream->write_index
+	       && memcmp(scratch_stream->buffer, compressed_stream->buffer, compressed_stream->write_index) == 0;
+
+	MemoryStream_Clear(scratch_stream);
+
+	return success;
+}
+
+static cc_bool TestRefinedSeeds(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, MemoryStream* const input_stream, MemoryStream* const scratch_stream, const MemoryStream* const compressed_stream)
+{
+	/* Refining each seed on its own, and then reducing them in the order that they are numbered, or in reverse as if */
+	/* they had finished in that order, must both pick the seed that normal compression uses. */
+	ClownNemesis_RefinedSeed refined_seeds[8], forward, reverse;
+	unsigned int i;
+	cc_bool success;
+
+	const unsigned int total_seeds = ClownNemesis_TotalSeeds(options);
+
+	if (total_seeds == 0 || total_seeds > CC_COUNT_OF(refined_seeds))
+		return cc_false;
+
+	for (i = 0; i < total_seeds; ++i)
+		if (!ClownNemesis_CompressorRefineSeed(compressor, options, i, ReadByteFromMemoryStream, input_stream, &refined_seeds[i]))
+			return cc_false;
+
+	forward = refined_seeds[0];
+	reverse = refined_seeds[total_seeds - 1];
+
+	for (i = 1; i < total_seeds; ++i)
+	{
+		ClownNemesis_ReduceRefinedSeeds(&forward, &refined_seeds[i]);
+		ClownNemesis_ReduceRefinedSeeds(&reverse, &refined_seeds[total_seeds - 1 - i]);
+	}
+
+	MemoryStream_Clear(scratch_stream);
+
+	success = memcmp(&forward, &reverse, sizeof(forward)) == 0
+	       && ClownNemesis_CompressorCompressWithRefinedSeed(compressor, options, &forward, ReadByteFromMemoryStream, input_stream, WriteByteToMemoryStream, scratch_stream)
+	       && scratch_stream->write_index == compressed_stream->write_index
+	       && memcmp(scratch_stream->buffer, compressed_stream->buffer, compressed_stream->write_index) == 0;
+
+	MemoryStream_Clear(scratch_stream);
+
+	return success;
+}
+
+static cc_bool TestDecodeSpeed(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, MemoryStream* const input_stream, MemoryStream* const scratch_stream, const MemoryStream* const compressed_stream)
+{
+	/* A weight of 0 must compress exactly like the default, and every weight must produce valid data of the estimated */
+	/* size. Favouring decoding more must never make the data slower to decode. */
+	static const int decode_speeds[] = {0, 1, 4, 8, 16, 32, 64};
+
+	ClownNemesis_CompressOptions decode_speed_options;
+	MemoryStream decompressed_stream;
+	unsigned long previous_cycles;
+	size_t i;
+	cc_bool success;
+
+	decode_speed_options = *options;
+	previous_cycles = ULONG_MAX;
+	success = cc_true;
+
+	MemoryStream_Initialise(&decompressed_stream);
+
+	for (i = 0; i < CC_COUNT_OF(decode_speeds) && success; ++i)
+	{
+		unsigned long cycles;
+
+		decode_speed_options.decode_speed = decode_speeds[i];
+
+		MemoryStream_Clear(scratch_stream);
+		MemoryStream_Clear(&decompressed_stream);
+
+		if (!ClownNemesis_CompressorCompress(compressor, &decode_speed_options, ReadByteFromMemoryStream, input_stream, WriteByteToMemoryStream, scratch_stream)
+		 || !ClownNemesis_Decompress(ReadByteFromMemoryStream, scratch_stream, WriteByteToMemoryStream, &decompressed_stream))
+		{
+			success = cc_false;
+			break;
+		}
+
+		/* Decompression stops at the end of the tiles, without reaching the end of the stream to rewind it. */
+		scratch_stream->read_index = 0;
+		cycles = ClownNemesis_EstimateDecodeCycles(ReadByteFromMemoryStream, scratch_stream);
+
+		success = cycles != 0 && cycles <= previous_cycles
+		       && decompressed_stream.write_index == input_stream->write_index
+		       && memcmp(decompressed_stream.buffer, input_stream->buffer, input_stream->write_index) == 0
+		       && scratch_stream->write_index == ClownNemesis_EstimateCompressedSize(&decode_speed_options, ReadByteFromMemoryStream, input_stream);
+
+		if (decode_speeds[i] == 0)
+			success &= scratch_stream->write_index == compressed_stream->write_index
+			        && memcmp(scratch_stream->buffer, compressed_stream->buffer, compressed_stream->write_index) == 0;
+
+		previous_cycles = cycles;
+	}
+
+	MemoryStream_Deinitialise(&decompressed_stream);
+	MemoryStream_Clear(scratch_stream);
+
+	return success;
+}
+
+static cc_bool TestChunkedEmission(ClownNemesis_Compressor* const compressor, const ClownNemesis_ChunkCodes* const codes, const MemoryStream* const tile_stream, MemoryStream* const scratch_stream, const MemoryStream* const compressed_stream, const unsigned long tiles_per_chunk)
+{
+	ClownNemesis_Chunk *chunks;
+	unsigned long total_chunks, i;
+	cc_bool success;
+
+	const unsigned long total_tiles = tile_stream->write_index / 0x20;
+
+	/* The first chunk is empty, so that both an empty chunk and a chunk that starts at the very beginning are tested. */
+	total_chunks = 1 + CC_DIVIDE_CEILING(total_tiles, tiles_per_chunk);
+	chunks = (ClownNemesis_Chunk*)malloc(total_chunks * sizeof(ClownNemesis_Chunk));
+
+	if (chunks == NULL)
+		return cc_false;
+
+	success = ClownNemesis_CompressorEmitChunk(compressor, codes, tile_stream->buffer, 0, 0, &chunks[0]);
+
+	/* The chunks are emitted backwards, as if they were finished by threads in any order. */
+	for (i = total_chunks; success && i-- > 1; )
+	{
+		const unsigned long first_tile = (i - 1) * tiles_per_chunk;
+
+		if (!ClownNemesis_CompressorEmitChunk(compressor, codes, tile_stream->buffer, first_tile, CC_MIN(first_tile + tiles_per_chunk, total_tiles), &chunks[i]))
+		{
+			ClownNemesis_FreeChunk(&chunks[0]);
+
+			for (++i; i < total_chunks; ++i)
+				ClownNemesis_FreeChunk(&chunks[i]);
+
+			free(chunks);
+			return cc_false;
+		}
+	}
+
+	MemoryStream_Clear(scratch_stream);
+
+	success = success
+	       && ClownNemesis_CompressorWriteChunks(compressor, codes, chunks, total_chunks, WriteByteToMemoryStream, scratch_stream)
+	       && scratch_stream->write_index == compressed_stream->write_index
+	       && memcmp(scratch_stream->buffer, compressed_stream->buffer, compressed_stream->write_index) == 0;
+
+	for (i = 0; i < total_chunks; ++i)
+		ClownNemesis_FreeChunk(&chunks[i]);
+
+	free(chunks);
+	MemoryStream_Clear(scratch_stream);
+
+	return success;
+}
+
+static cc_bool TestChunks(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const MemoryStream* const tile_stream, MemoryStream* const scratch_stream, const MemoryStream* const compressed_stream)
+{
+	/* Emitting the tiles in chunks, and then joining the chunks, must produce the same data as normal compression. */
+	/* The chunks are a tile each, so that runs cross every boundary that they can, and also a third of the tiles each. */
+	ClownNemesis_ChunkCodes codes;
+
+	const unsigned long total_tiles = tile_stream->write_index / 0x20;
+
+	return ClownNemesis_CompressorComputeChunkCodes(compressor, options, tile_stream->buffer, total_tiles, &codes)
+	    && TestChunkedEmission(compressor, &codes, tile_stream, scratch_stream, compressed_stream, 1)
+	    && TestChunkedEmission(compressor, &codes, tile_stream, scratch_stream, compressed_stream, CC_MAX(1, CC_DIVIDE_CEILING(total_tiles, 3)));
+}
+
+static cc_bool DecompressSession(const ClownNemesis_Session* const session, MemoryStream* const output_stream)
+{
+	MemoryStream session_stream;
+	size_t size;
+
+	session_stream.buffer = (unsigned char*)ClownNemesis_SessionCompressedData(session, &size);
+	session_stream.size = session_stream.write_index = size;
+	session_stream.read_index = 0;
+
+	MemoryStream_Clear(output_stream);
+
+	return ClownNemesis_Decompress(ReadByteFromMemoryStream, &session_stream, WriteByteToMemoryStream, output_stream);
+}
+
+static unsigned long NextRandom(unsigned long* const seed)
+{
+	/* A linear congruential generator, so that the same edits are made every time. */
+	*seed = (*seed * 1103515245 + 12345) & 0xFFFFFFFF;
+	return *seed >> 16;
+}
+
+static size_t CodeTableSize(const unsigned char* const data, const size_t size)
+{
+	/* The size of the code table, including its terminator, which follows the 2-byte header. */
+	size_t position;
+
+	for (position = 2; position < size && data[position] != 0xFF; )
+		position += (data[position] & 0x80) != 0 ? 1 : 2;
+
+	return position - 2 + 1;
+}
+
+static void MakeEditTile(unsigned long* const seed, const MemoryStream* const tile_stream, unsigned char* const tile, const cc_bool xor_friendly)
+{
+	/* Edits are a mix of tiles from elsewhere in the data, solid tiles, and noise, like a person editing tiles would */
+	/* make. Tiles with alternating nybbles are very small in XOR mode, as every row is the same as the one before it */
+	/* XORed with a single nybble, but are very large otherwise, so lots of them make the session switch to XOR mode. */
+	const unsigned int kind = xor_friendly ? 3 : (unsigned int)(NextRandom(seed) % 3);
+	unsigned int i;
+
+	if (kind == 0)
+	{
+		memcpy(tile, &tile_stream->buffer[NextRandom(seed) % (tile_stream->write_index / 0x20) * 0x20], 0x20);
+	}
+	else if (kind == 1)
+	{
+		memset(tile, (int)(NextRandom(seed) % 0x10 * 0x11), 0x20);
+	}
+	else if (kind == 2)
+	{
+		for (i = 0; i < 0x20; ++i)
+			tile[i] = (unsigned char)NextRandom(seed);
+	}
+	else
+	{
+		const unsigned int nybbles = (unsigned int)(NextRandom(seed) % 0x100);
+
+		for (i = 0; i < 0x20; ++i)
+			tile[i] = (unsigned char)(i / 4 % 2 == 0 ? nybbles : (nybbles >> 4 | nybbles << 4) & 0xFF);
+	}
+}
+
+static cc_bool CheckSessionEdit(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const ClownNemesis_Session* const session, MemoryStream* const current_stream, MemoryStream* const scratch_stream, MemoryStream* const table_stream, unsigned long* const total_rebuilds, cc_bool* const xor_mode_used)
+{
+	/* The session must decompress to the edited tiles, and, whenever it makes a new code table, it must produce the */
+	/* same data as compressing the tiles afresh. Its data must never be more than 1/64 larger than that. */
+	const unsigned char *data;
+	size_t size, table_size, session_bits, fresh_bits;
+
+	if (!DecompressSession(session, scratch_stream)
+	 || scratch_stream->write_index != current_stream->write_index
+	 || memcmp(scratch_stream->buffer, current_stream->buffer, current_stream->write_index) != 0)
+		return cc_false;
+
+	MemoryStream_Clear(scratch_stream);
+	current_stream->read_index = 0;
+
+	if (!ClownNemesis_CompressorCompress(compressor, options, ReadByteFromMemoryStream, current_stream, WriteByteToMemoryStream, scratch_stream))
+		return cc_false;
+
+	data = ClownNemesis_SessionCompressedData(session, &size);
+	table_size = CodeTableSize(data, size);
+
+	if ((data[0] & 0x80) != 0)
+		*xor_mode_used = cc_true;
+
+	if (table_size != table_stream->write_index || memcmp(&data[2], table_stream->buffer, table_size) != 0)
+	{
+		++*total_rebuilds;
+
+		if (size != scratch_stream->write_index || memcmp(data, scratch_stream->buffer, size) != 0)
+			return cc_false;
+
+		MemoryStream_Clear(table_stream);
+
+		for (size = 0; size < table_size; ++size)
+			WriteByteToMemoryStream(table_stream, data[2 + size]);
+
+		return cc_true;
+	}
+
+	/* Everything but the header and the code table's terminator, rounded up to whole bytes. */
+	session_bits = (size - 3) * 8;
+	fresh_bits = (scratch_stream->write_index - 3) * 8;
+
+	return session_bits <= fresh_bits + fresh_bits / 64 + 8;
+}
+
+static cc_bool TestSessionEdits(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const MemoryStream* const tile_stream, MemoryStream* const scratch_stream)
+{
+	/* A fixed sequence of random edits, which includes the first and last tiles, and then a large edit which makes */
+	/* the code table stale, after which the edits are repeated in XOR mode. Every edit is compared to compressing the */
+	/* tiles afresh, so only the start of the data is used, to keep this quick. */
+	ClownNemesis_Session *session;
+	MemoryStream current_stream, table_stream;
+	unsigned char tile[0x20];
+	unsigned long seed, total_rebuilds, first_tile, i;
+	unsigned int pass;
+	cc_bool success, xor_mode_used;
+
+	const unsigned long total_tiles = CC_MIN(0x40, tile_stream->write_index / 0x20);
+
+	session = ClownNemesis_SessionCreate(tile_stream->buffer, total_tiles);
+
+	if (session == NULL)
+		return cc_false;
+
+	MemoryStream_Initialise(&current_stream);
+	MemoryStream_Initialise(&table_stream);
+
+	for (i = 0; i < total_tiles * 0x20; ++i)
+		WriteByteToMemoryStream(&current_stream, tile_stream->buffer[i]);
+
+	seed = total_tiles;
+	total_rebuilds = 0;
+	xor_mode_used = cc_false;
+
+	/* The session starts with the same table as a fresh compression, which counts as the first rebuild. */
+	success = CheckSessionEdit(compressor, options, session, &current_stream, scratch_stream, &table_stream, &total_rebuilds, &xor_mode_used);
+
+	for (pass = 0; pass < 2 && success; ++pass)
+	{
+		for (i = 0; i < 2 + 16 && success; ++i)
+		{
+			const unsigned long tile_index = i == 0 ? 0 : i == 1 ? total_tiles - 1 : NextRandom(&seed) % total_tiles;
+
+			MakeEditTile(&seed, tile_stream, tile, cc_false);
+			memcpy(&current_stream.buffer[tile_index * 0x20], tile, 0x20);
+
+			success = ClownNemesis_SessionSetTile(session, tile_index, tile)
+			       && CheckSessionEdit(compressor, options, session, &current_stream, scratch_stream, &table_stream, &total_rebuilds, &xor_mode_used);
+		}
+
+		if (pass != 0)
+			break;
+
+		first_tile = NextRandom(&seed) % (total_tiles / 2 + 1);
+
+		for (i = first_tile; i < total_tiles && success; ++i)
+		{
+			MakeEditTile(&seed, tile_stream, tile, cc_true);
+			memcpy(&current_stream.buffer[i * 0x20], tile, 0x20);
+
+			success = ClownNemesis_SessionSetTile(session, i, tile)
+			       && CheckSessionEdit(compressor, options, session, &current_stream, scratch_stream, &table_stream, &total_rebuilds, &xor_mode_used);
+		}
+	}
+
+	MemoryStream_Deinitialise(&current_stream);
+	MemoryStream_Deinitialise(&table_stream);
+	MemoryStream_Clear(scratch_stream);
+	ClownNemesis_SessionDestroy(session);
+
+	return success && total_rebuilds > 1 && xor_mode_used;
+}
+
+static cc_bool TestSession(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const MemoryStream* const tile_stream, MemoryStream* const scratch_stream, const MemoryStream* const compressed_stream)
+{
+	/* A session must start with the same data as normal compression, and then stay in step with its tiles as they are */
+	/* edited. The middle tile is replaced with the first tile, and is then put back. */
+	cc_bool success;
+	ClownNemesis_Session *session;
+	const unsigned char *data;
+	size_t size;
+
+	const size_t total_tiles = tile_stream->write_index / 0x20;
+	const size_t middle = total_tiles / 2 * 0x20;
+
+	session = ClownNemesis_SessionCreate(tile_stream->buffer, total_tiles);
+
+	if (session == NULL)
+		return cc_false;
+
+	data = ClownNemesis_SessionCompressedData(session, &size);
+
+	success = size == compressed_stream->write_index
+	       && memcmp(data, compressed_stream->buffer, size) == 0
+	       && ClownNemesis_SessionSetTile(session, total_tiles / 2, &tile_stream->buffer[0])
+	       && DecompressSession(session, scratch_stream)
+	       && scratch_stream->write_index == tile_stream->write_index
+	       && memcmp(scratch_stream->buffer, tile_stream->buffer, middle) == 0
+	       && memcmp(&scratch_stream->buffer[middle], &tile_stream->buffer[0], 0x20) == 0
+	       && memcmp(&scratch_stream->buffer[middle + 0x20], &tile_stream->buffer[middle + 0x20], tile_stream->write_index - middle - 0x20) == 0
+	       && ClownNemesis_SessionSetTile(session, total_tiles / 2, &tile_stream->buffer[middle])
+	       && DecompressSession(session, scratch_stream)
+	       && scratch_stream->write_index == tile_stream->write_index
+	       && memcmp(scratch_stream->buffer, tile_stream->buffer, tile_stream->write_index) == 0;
+
+	MemoryStream_Clear(scratch_stream);
+	ClownNemesis_SessionDestroy(session);
+
+	success = success && TestSessionEdits(compressor, options, tile_stream, scratch_stream);
+
+	return success;
+}
+
+static cc_bool DecompressContainerArchive(const ClownNemesis_Container* const container, const unsigned long index, ClownNemesis_ContainerArchive* const archive, MemoryStream* const output_stream)
+{
+	MemoryStream_Clear(output_stream);
+
+	return ClownNemesis_ContainerGetArchive(container, index, archive)
+	    && ClownNemesis_ContainerVerifyArchive(archive)
+	    && ClownNemesis_ContainerDecompress(archive, NULL, WriteByteToMemoryStream, output_stream);
+}
+
+static cc_bool TestContainer(const MemoryStream* const tile_stream, MemoryStream* const scratch_stream, const MemoryStream* const original_compressed_stream, const MemoryStream* const compressed_stream)
+{
+	/* The original archive is packed twice, so that its second copy should share the data of its first. */
+	cc_bool success;
+	ClownNemesis_ContainerArchive archives[3];
+	MemoryStream container_stream;
+	ClownNemesis_Container container;
+
+	archives[0].bytes = archives[2].bytes = original_compressed_stream->buffer;
+	archives[0].size = archives[2].size = (unsigned long)original_compressed_stream->write_index;
+	archives[1].bytes = compressed_stream->buffer;
+	archives[1].size = (unsigned long)compressed_stream->write_index;
+
+	MemoryStream_Initialise(&container_stream);
+
+	success = ClownNemesis_ContainerWrite(archives, 3, WriteByteToMemoryStream, &container_stream)
+	       && ClownNemesis_ContainerOpen(&container, container_stream.buffer, container_stream.write_index)
+	       && container.total_archives == 3
+	       && DecompressContainerArchive(&container, 1, &archives[1], scratch_stream)
+	       && archives[1].total_tiles == tile_stream->write_index / 0x20
+	       && scratch_stream->write_index == tile_stream->write_index
+	       && memcmp(scratch_stream->buffer, tile_stream->buffer, tile_stream->write_index) == 0
+	       && DecompressContainerArchive(&container, 0, &archives[0], scratch_stream)
+	       && scratch_stream->write_index == tile_stream->write_index
+	       && memcmp(scratch_stream->buffer, tile_stream->buffer, tile_stream->write_index) == 0
+	       && ClownNemesis_ContainerGetArchive(&container, 2, &archives[2])
+	       && archives[2].bytes == archives[0].bytes
+	       && !ClownNemesis_ContainerGetArchive(&container, 3, &archives[2]);
+
+	MemoryStream_Clear(scratch_stream);
+	MemoryStream_Deinitialise(&container_stream);
+
+	return success;
+}
+
+static cc_bool CompressWithCodeTable(ClownNemesis_Compressor* const compressor, const ClownNemesis_CodeTable* const table, MemoryStream* const tile_stream, MemoryStream* const compressed_stream, MemoryStream* const scratch_stream)
+{
+	/* Both ways of compressing with a table must produce the same data, which must decompress to the tiles. */
+	MemoryStream_Clear(compressed_stream);
+	MemoryStream_Clear(scratch_stream);
+
+	if (!ClownNemesis_CompressWithTable(table, ReadByteFromMemoryStream, tile_stream, WriteByteToMemoryStream, compressed_stream)
+	 || !ClownNemesis_CompressorCompressWithTable(compressor, table, ReadByteFromMemoryStream, tile_stream, WriteByteToMemoryStream, scratch_stream)
+	 || scratch_stream->write_index != compressed_stream->write_index
+	 || memcmp(scratch_stream->buffer, compressed_stream->buffer, compressed_stream->write_index) != 0)
+		return cc_false;
+
+	MemoryStream_Clear(scratch_stream);
+
+	return ClownNemesis_Decompress(ReadByteFromMemoryStream, compressed_stream, WriteByteToMemoryStream, scratch_stream)
+	    && scratch_stream->write_index == tile_stream->write_index
+	    && memcmp(scratch_stream->buffer, tile_stream->buffer, tile_stream->write_index) == 0;
+}
+
+static cc_bool TestCodeTables(ClownNemesis_Compressor* const compressor)
+{
+	/* A table trained on the whole corpus must compress every file of it. As every file stores its own copy of the */
+	/* table, training on several copies of a file must make the same table as training on it once. Tables with codes */
+	/* that are too long, or that do not fit in the code space, must be rejected. */
+	ClownNemesis_TrainingHistogram histogram, single_histogram, repeated_histogram;
+	ClownNemesis_CodeTable table, single_table, repeated_table;
+	MemoryStream tile_stream, compressed_stream, scratch_stream;
+	cc_bool success;
+	size_t i;
+	unsigned int j;
+
+	MemoryStream_Initialise(&tile_stream);
+	MemoryStream_Initialise(&compressed_stream);
+	MemoryStream_Initialise(&scratch_stream);
+
+	success = cc_true;
+
+	ClownNemesis_TrainingHistogramInitialise(&histogram);
+
+	for (i = 0; i < CC_COUNT_OF(test_files); ++i)
+		if (ReadTestFileTiles(test_files[i], &tile_stream))
+			success &= ClownNemesis_TrainingHistogramAdd(&histogram, ReadByteFromMemoryStream, &tile_stream);
+
+	ClownNemesis_TrainCodeTable(&table, &histogram);
+
+	for (i = 0; i < CC_COUNT_OF(test_files); ++i)
+	{
+		if (!ReadTestFileTiles(test_files[i], &tile_stream))
+			continue;
+
+		if (!CompressWithCodeTable(compressor, &table, &tile_stream, &compressed_stream, &scratch_stream))
+		{
+			fprintf(stdout, "File '%s' did not compress correctly with a trained code table.\n", test_files[i]);
+			success = cc_false;
+		}
+
+		ClownNemesis_TrainingHistogramInitialise(&single_histogram);
+		ClownNemesis_TrainingHistogramInitialise(&repeated_histogram);
+		success &= ClownNemesis_TrainingHistogramAdd(&single_histogram, ReadByteFromMemoryStream, &tile_stream);
+
+		for (j = 0; j < 3; ++j)
+			success &= ClownNemesis_TrainingHistogramAdd(&repeated_histogram, ReadByteFromMemoryStream, &tile_stream);
+
+		ClownNemesis_TrainCodeTable(&single_table, &single_histogram);
+		ClownNemesis_TrainCodeTable(&repeated_table, &repeated_histogram);
+
+		if (memcmp(&single_table, &repeated_table, sizeof(single_table)) != 0)
+		{
+			fprintf(stdout, "Training on copies of file '%s' did not make the same table as training on it once.\n", test_files[i]);
+			success = cc_false;
+		}
+	}
+
+	/* 63 codes of 6 bits fill the code space exactly, leaving only the inline marker. */
+	MemoryStream_Clear(&tile_stream);
+
+	for (j = 0; j < 0x40; ++j)
+		WriteByteToMemoryStream(&tile_stream, (unsigned char)(j / 3 * 0x11));
+
+	memset(&table, 0, sizeof(table));
+
+	for (j = 0; j < 63; ++j)
+		table.code_lengths[j / 8][j % 8] = 6;
+
+	if (!CompressWithCodeTable(compressor, &table, &tile_stream, &compressed_stream, &scratch_stream))
+	{
+		fputs("A code table which fills the code space was rejected.\n", stdout);
+		success = cc_false;
+	}
+
+	/* One more code overlaps the inline marker. */
+	table.code_lengths[7][7] = 6;
+
+	if (CompressWithCodeTable(compressor, &table, &tile_stream, &compressed_stream, &scratch_stream))
+	{
+		fputs("A code table which overflows the code space was accepted.\n", stdout);
+		success = cc_false;
+	}
+
+	table.code_lengths[7][7] = 0;
+	table.code_lengths[0][0] = 9;
+
+	if (CompressWithCodeTable(compressor, &table, &tile_stream, &compressed_stream, &scratch_stream))
+	{
+		fputs("A code table with a code longer than 8 bits was accepted.\n", stdout);
+		success = cc_false;
+	}
+
+	MemoryStream_Deinitialise(&tile_stream);
+	MemoryStream_Deinitialise(&compressed_stream);
+	MemoryStream_Deinitialise(&scratch_stream);
+
+	return success;
+}
+
+static cc_bool SplitAndCompress(ClownNemesis_Compressor* const compressor, const char* const name, const MemoryStream* const tile_stream, MemoryStream* const compressed_stream, MemoryStream* const scratch_stream)
+{
+	/* Every archive must fit in the header, the archives must decompress to the tiles, and splitting must never */
+	/* make the data larger than a single archive, whenever a single archive can hold it. */
+	ClownNemesis_Segment segments[CLOWNNEMESIS_MAXIMUM_SEGMENTS];
+	ClownNemesis_CompressOptions options;
+	MemoryStream input_stream;
+	unsigned long next_tile, total_size;
+	size_t total_segments, i;
+
+	const unsigned long total_tiles = tile_stream->write_index / 0x20;
+
+	ClownNemesis_DefaultCompressOptions(&options);
+
+	input_stream = *tile_stream;
+	input_stream.read_index = 0;
+
+	total_segments = ClownNemesis_Split(segments, ReadByteFromMemoryStream, &input_stream);
+
+	if (total_segments == 0)
+	{
+		fprintf(stdout, "Could not split %s.\n", name);
+		return cc_false;
+	}
+
+	MemoryStream_Clear(scratch_stream);
+	next_tile = total_size = 0;
+
+	for (i = 0; i < total_segments; ++i)
+	{
+		if (segments[i].first_tile != next_tile || segments[i].total_tiles > 0x7FFF || (segments[i].total_tiles == 0 && total_tiles != 0))
+		{
+			fprintf(stdout, "Archive %lu of %s has an invalid range of tiles.\n", (unsigned long)i, name);
+			return cc_false;
+		}
+
+		next_tile += segments[i].total_tiles;
+
+		input_stream.buffer = &tile_stream->buffer[segments[i].first_tile * 0x20];
+		input_stream.write_index = segments[i].total_tiles * 0x20;
+		input_stream.read_index = 0;
+
+		MemoryStream_Clear(compressed_stream);
+
+		/* The decompressed archives are appended to each other. */
+		if (!ClownNemesis_CompressorCompress(compressor, &options, ReadByteFromMemoryStream, &input_stream, WriteByteToMemoryStream, compressed_stream)
+		 || !ClownNemesis_Decompress(ReadByteFromMemoryStream, compressed_stream, WriteByteToMemoryStream, scratch_stream))
+		{
+			fprintf(stdout, "Archive %lu of %s could not be compressed.\n", (unsigned long)i, name);
+			return cc_false;
+		}
+
+		total_size += compressed_stream->write_index;
+	}
+
+	if (next_tile != total_tiles || scratch_stream->write_index != tile_stream->write_index || memcmp(scratch_stream->buffer, tile_stream->buffer, tile_stream->write_index) != 0)
+	{
+		fprintf(stdout, "The archives of %s do not decompress to its tiles.\n", name);
+		return cc_false;
+	}
+
+	if (total_tiles <= 0x7FFF)
+	{
+		input_stream = *tile_stream;
+		input_stream.read_index = 0;
+
+		MemoryStream_Clear(compressed_stream);
+
+		if (!ClownNemesis_CompressorCompress(compressor, &options, ReadByteFromMemoryStream, &input_stream, WriteByteToMemoryStream, compressed_stream)
+		 || total_size > compressed_stream->write_index)
+		{
+			fprintf(stdout, "The archives of %s are larger than a single archive.\n", name);
+			return cc_false;
+		}
+	}
+
+	return cc_true;
+}
+
+static cc_bool TestSplit(ClownNemesis_Compressor* const compressor)
 {
+	/* Each file of the corpus is split on its own, and then all of them are split together, repeated until they are */
+	/* too large for a single archive, which is the same as a large sheet of unrelated graphics. */
+	MemoryStream tile_stream, all_tile_stream, compressed_stream, scratch_stream;
+	cc_bool success;
+	size_t i;
+
+	MemoryStream_Initialise(&tile_stream);
+	MemoryStream_Initialise(&all_tile_stream);
+	MemoryStream_Initialise(&compressed_stream);
+	MemoryStream_Initialise(&scratch_stream);
+
+	success = cc_true;
+
+	for (i = 0; i < CC_COUNT_OF(test_files); ++i)
+	{
+		char name[0x100];
+		size_t j;
+
+		if (!ReadTestFileTiles(test_files[i], &tile_stream))
+			continue;
+
+		sprintf(name, "file '%.*s'", (int)(sizeof(name) - 0x10), test_files[i]);
+		success &= SplitAndCompress(compressor, name, &tile_stream, &compressed_stream, &scratch_stream);
+
+		for (j = 0; j < tile_stream.write_index; ++j)
+			WriteByteToMemoryStream(&all_tile_stream, tile_stream.buffer[j]);
+	}
+
+	/* Without the corpus, some tiles of every kind of nybble are made up instead. */
+	if (all_tile_stream.write_index == 0)
+		for (i = 0; i < 0x20 * 0x100; ++i)
+			WriteByteToMemoryStream(&all_tile_stream, (unsigned char)(i / 0x20 % 3 == 0 ? i * 0x11 : i / 0x40 * 0x11));
+
+	{
+	const size_t corpus_size = all_tile_stream.write_index;
+
+	while (all_tile_stream.write_index <= 0x7FFF * 0x20)
+		for (i = 0; i < corpus_size; ++i)
+			WriteByteToMemoryStream(&all_tile_stream, all_tile_stream.buffer[i]);
+	}
+
+	success &= SplitAndCompress(compressor, "the whole corpus", &all_tile_stream, &compressed_stream, &scratch_stream);
+
+	MemoryStream_Deinitialise(&tile_stream);
+	MemoryStream_Deinitialise(&all_tile_stream);
+	MemoryStream_Deinitialise(&compressed_stream);
+	MemoryStream_Deinitialise(&scratch_stream);
+
+	return success;
+}
+
+static cc_bool TestEmptyInput(void)
+{
+	/* Empty input must compress to an archive of no tiles at every effort level, even in a compressor whose memory is */
+	/* full of junk, so that nothing is read from the state before it is set. */
+	cc_bool success;
+	void *workspace;
+	ClownNemesis_Compressor *compressor;
+	ClownNemesis_CompressOptions options;
+	MemoryStream empty_stream, compressed_stream, decompressed_stream;
+
+	workspace = malloc(ClownNemesis_CompressorWorkspaceSize());
+
+	if (workspace == NULL)
+		return cc_false;
+
+	memset(workspace, 0xFF, ClownNemesis_CompressorWorkspaceSize());
+	compressor = ClownNemesis_CompressorInitialise(workspace);
+
+	MemoryStream_Initialise(&empty_stream);
+	MemoryStream_Initialise(&compressed_stream);
+	MemoryStream_Initialise(&decompressed_stream);
+
+	ClownNemesis_DefaultCompressOptions(&options);
+
+	success = cc_true;
+
+	for (options.effort = CLOWNNEMESIS_EFFORT_FASTEST; options.effort <= CLOWNNEMESIS_EFFORT_EXHAUSTIVE; ++options.effort)
+	{
+		MemoryStream_Clear(&compressed_stream);
+		MemoryStream_Clear(&decompressed_stream);
+
+		if (!ClownNemesis_CompressorCompress(compressor, &options, ReadByteFromMemoryStream, &empty_stream, WriteByteToMemoryStream, &compressed_stream)
+		 || compressed_stream.write_index < 2 || (compressed_stream.buffer[0] & 0x7F) != 0 || compressed_stream.buffer[1] != 0
+		 || !ClownNemesis_Decompress(ReadByteFromMemoryStream, &compressed_stream, WriteByteToMemoryStream, &decompressed_stream)
+		 || decompressed_stream.write_index != 0)
+		{
+			fprintf(stdout, "Empty input did not compress correctly with effort level %d.\n", options.effort);
+			success = cc_false;
+		}
+	}
+
+	MemoryStream_Deinitialise(&empty_stream);
+	MemoryStream_Deinitialise(&compressed_stream);
+	MemoryStream_Deinitialise(&decompressed_stream);
+	free(workspace);
+
+	return success;
+}
+
+static cc_bool DoTests(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options)
+{
+	cc_bool success;
+	clock_t total_compression_time;
 	size_t total_uncompressed_size, total_original_compressed_size, total_new_compressed_size;
 	MemoryStream compressed_memory_stream, decompressed_memory_stream, compressed_memory_stream_2, decompressed_memory_stream_2;
 	size_t i;
 
-	static const char* const files[] = {
-		"tests/s1disasm/artnem/8x8 - GHZ1.nem",
-		"tests/s1disasm/artnem/8x8 - GHZ2.nem",
-		"tests/s1disasm/artnem/8x8 - LZ.nem",
-		"tests/s1disasm/artnem/8x8 - MZ.nem",
-		"tests/s1disasm/artnem/8x8 - SBZ.nem",
-		"tests/s1disasm/artnem/8x8 - SLZ.nem",
-		"tests/s1disasm/artnem/8x8 - SYZ.nem",
-		"tests/s1disasm/artnem/Animal Chicken.nem",
-		"tests/s1disasm/artnem/Animal Flicky.nem",
-		"tests/s1disasm/artnem/Animal Penguin.nem",
-		"tests/s1disasm/artnem/Animal Pig.nem",
-		"tests/s1disasm/artnem/Animal Rabbit.nem",
-		"tests/s1disasm/artnem/Animal Seal.nem",
-		"tests/s1disasm/artnem/Animal Squirrel.nem",
-		"tests/s1disasm/artnem/Boss - Eggman after FZ Fight.nem",
-		"tests/s1disasm/artnem/Boss - Eggman in SBZ2 & FZ.nem",
-		"tests/s1disasm/artnem/Boss - Exhaust Flame.nem",
-		"tests/s1disasm/artnem/Boss - Final Zone.nem",
-		"tests/s1disasm/artnem/Boss - Main.nem",
-		"tests/s1disasm/artnem/Boss - Weapons.nem",
-		"tests/s1disasm/artnem/Continue Screen Sonic.nem",
-		"tests/s1disasm/artnem/Continue Screen Stuff.nem",
-		"tests/s1disasm/artnem/Ending - Credits.nem",
-		"tests/s1disasm/artnem/Ending - Emeralds.nem",
-		"tests/s1disasm/artnem/Ending - Flowers.nem",
-		"tests/s1disasm/artnem/Ending - Sonic.nem",
-		"tests/s1disasm/artnem/Ending - StH Logo.nem",
-		"tests/s1disasm/artnem/Ending - Try Again.nem",
-		"tests/s1disasm/artnem/Enemy Ball Hog.nem",
-		"tests/s1disasm/artnem/Enemy Basaran.nem",
-		"tests/s1disasm/artnem/Enemy Bomb.nem",
-		"tests/s1disasm/artnem/Enemy Burrobot.nem",
-		"tests/s1disasm/artnem/Enemy Buzz Bomber.nem",
-		"tests/s1disasm/artnem/Enemy Caterkiller.nem",
-		"tests/s1disasm/artnem/Enemy Chopper.nem",
-		"tests/s1disasm/artnem/Enemy Crabmeat.nem",
-		"tests/s1disasm/artnem/Enemy Jaws.nem",
-		"tests/s1disasm/artnem/Enemy Motobug.nem",
-		"tests/s1disasm/artnem/Enemy Newtron.nem",
-		"tests/s1disasm/artnem/Enemy Orbinaut.nem",
-		"tests/s1disasm/artnem/Enemy Roller.nem",
-		"tests/s1disasm/artnem/Enemy Splats.nem",
-		"tests/s1disasm/artnem/Enemy Yadrin.nem",
-		"tests/s1disasm/artnem/Explosion.nem",
-		"tests/s1disasm/artnem/Fireballs.nem",
-		"tests/s1disasm/artnem/GHZ Breakable Wall.nem",
-		"tests/s1disasm/artnem/GHZ Bridge.nem",
-		"tests/s1disasm/artnem/GHZ Edge Wall.nem",
-		"tests/s1disasm/artnem/GHZ Flower Stalk.nem",
-		"tests/s1disasm/artnem/GHZ Giant Ball.nem",
-		"tests/s1disasm/artnem/GHZ Purple Rock.nem",
-		"tests/s1disasm/artnem/GHZ Spiked Log.nem",
-		"tests/s1disasm/artnem/GHZ Swinging Platform.nem",
-		"tests/s1disasm/artnem/Game Over.nem",
-		"tests/s1disasm/artnem/Giant Ring Flash.nem",
-		"tests/s1disasm/artnem/HUD - Life Counter Icon.nem",
-		"tests/s1disasm/artnem/HUD.nem",
-		"tests/s1disasm/artnem/Hidden Bonuses.nem",
-		"tests/s1disasm/artnem/Hidden Japanese Credits.nem",
-		"tests/s1disasm/artnem/Invincibility Stars.nem",
-		"tests/s1disasm/artnem/LZ 32x16 Block.nem",
-		"tests/s1disasm/artnem/LZ 32x32 Block.nem",
-		"tests/s1disasm/artnem/LZ Blocks.nem",
-		"tests/s1disasm/artnem/LZ Breakable Pole.nem",
-		"tests/s1disasm/artnem/LZ Bubbles & Countdown.nem",
-		"tests/s1disasm/artnem/LZ Cork.nem",
-		"tests/s1disasm/artnem/LZ Flapping Door.nem",
-		"tests/s1disasm/artnem/LZ Gargoyle & Fireball.nem",
-		"tests/s1disasm/artnem/LZ Harpoon.nem",
-		"tests/s1disasm/artnem/LZ Horizontal Door.nem",
-		"tests/s1disasm/artnem/LZ Rising Platform.nem",
-		"tests/s1disasm/artnem/LZ Spiked Ball & Chain.nem",
-		"tests/s1disasm/artnem/LZ Vertical Door.nem",
-		"tests/s1disasm/artnem/LZ Water & Splashes.nem",
-		"tests/s1disasm/artnem/LZ Water Surface.nem",
-		"tests/s1disasm/artnem/LZ Wheel.nem",
-		"tests/s1disasm/artnem/Lamppost.nem",
-		"tests/s1disasm/artnem/MZ Green Glass Block.nem",
-		"tests/s1disasm/artnem/MZ Green Pushable Block.nem",
-		"tests/s1disasm/artnem/MZ Lava.nem",
-		"tests/s1disasm/artnem/MZ Metal Blocks.nem",
-		"tests/s1disasm/artnem/MZ Switch.nem",
-		"tests/s1disasm/artnem/Monitors.nem",
-		"tests/s1disasm/artnem/Points.nem",
-		"tests/s1disasm/artnem/Prison Capsule.nem",
-		"tests/s1disasm/artnem/Rings.nem",
-		"tests/s1disasm/artnem/SBZ Collapsing Floor.nem",
-		"tests/s1disasm/artnem/SBZ Crushing Girder.nem",
-		"tests/s1disasm/artnem/SBZ Electrocuter.nem",
-		"tests/s1disasm/artnem/SBZ Flaming Pipe.nem",
-		"tests/s1disasm/artnem/SBZ Junction Wheel.nem",
-		"tests/s1disasm/artnem/SBZ Large Horizontal Door.nem",
-		"tests/s1disasm/artnem/SBZ Pizza Cutter.nem",
-		"tests/s1disasm/artnem/SBZ Running Disc.nem",
-		"tests/s1disasm/artnem/SBZ Sliding Floor Trap.nem",
-		"tests/s1disasm/artnem/SBZ Small Vertical Door.nem",
-		"tests/s1disasm/artnem/SBZ Spinning Platform.nem",
-		"tests/s1disasm/artnem/SBZ Stomper.nem",
-		"tests/s1disasm/artnem/SBZ Trapdoor.nem",
-		"tests/s1disasm/artnem/SBZ Vanishing Block.nem",
-		"tests/s1disasm/artnem/SLZ 32x32 Block.nem",
-		"tests/s1disasm/artnem/SLZ Breakable Wall.nem",
-		"tests/s1disasm/artnem/SLZ Cannon.nem",
-		"tests/s1disasm/artnem/SLZ Fan.nem",
-		"tests/s1disasm/artnem/SLZ Little Spikeball.nem",
-		"tests/s1disasm/artnem/SLZ Pylon.nem",
-		"tests/s1disasm/artnem/SLZ Seesaw.nem",
-		"tests/s1disasm/artnem/SLZ Swinging Platform.nem",
-		"tests/s1disasm/artnem/SYZ Bumper.nem",
-		"tests/s1disasm/artnem/SYZ Large Spikeball.nem",
-		"tests/s1disasm/artnem/SYZ Small Spikeball.nem",
-		"tests/s1disasm/artnem/Sega Logo (JP1).nem",
-		"tests/s1disasm/artnem/Sega Logo.nem",
-		"tests/s1disasm/artnem/Shield.nem",
-		"tests/s1disasm/artnem/Signpost.nem",
-		"tests/s1disasm/artnem/Special 1UP.nem",
-		"tests/s1disasm/artnem/Special Birds & Fish.nem",
-		"tests/s1disasm/artnem/Special Clouds.nem",
-		"tests/s1disasm/artnem/Special Emerald Twinkle.nem",
-		"tests/s1disasm/artnem/Special Emeralds.nem",
-		"tests/s1disasm/artnem/Special GOAL.nem",
-		"tests/s1disasm/artnem/Special Ghost.nem",
-		"tests/s1disasm/artnem/Special Glass.nem",
-		"tests/s1disasm/artnem/Special R.nem",
-		"tests/s1disasm/artnem/Special Red-White.nem",
-		"tests/s1disasm/artnem/Special Result Emeralds.nem",
-		"tests/s1disasm/artnem/Special UP-DOWN.nem",
-		"tests/s1disasm/artnem/Special W.nem",
-		"tests/s1disasm/artnem/Special Walls.nem",
-		"tests/s1disasm/artnem/Special ZONE1.nem",
-		"tests/s1disasm/artnem/Special ZONE2.nem",
-		"tests/s1disasm/artnem/Special ZONE3.nem",
-		"tests/s1disasm/artnem/Special ZONE4.nem",
-		"tests/s1disasm/artnem/Special ZONE5.nem",
-		"tests/s1disasm/artnem/Special ZONE6.nem",
-		"tests/s1disasm/artnem/Spikes.nem",
-		"tests/s1disasm/artnem/Spring Horizontal.nem",
-		"tests/s1disasm/artnem/Spring Vertical.nem",
-		"tests/s1disasm/artnem/Switch.nem",
-		"tests/s1disasm/artnem/Title Cards.nem",
-		"tests/s1disasm/artnem/Title Screen Foreground.nem",
-		"tests/s1disasm/artnem/Title Screen Sonic.nem",
-		"tests/s1disasm/artnem/Title Screen TM.nem",
-		"tests/s1disasm/artnem/Unused - Eggman Ending.nem",
-		"tests/s1disasm/artnem/Unused - Explosion.nem",
-		"tests/s1disasm/artnem/Unused - Fireball.nem",
-		"tests/s1disasm/artnem/Unused - GHZ Block.nem",
-		"tests/s1disasm/artnem/Unused - GHZ Log.nem",
-		"tests/s1disasm/artnem/Unused - Goggles.nem",
-		"tests/s1disasm/artnem/Unused - Grass.nem",
-		"tests/s1disasm/artnem/Unused - LZ Sonic.nem",
-		"tests/s1disasm/artnem/Unused - MZ Background.nem",
-		"tests/s1disasm/artnem/Unused - SStage Flash.nem",
-		"tests/s1disasm/artnem/Unused - SYZ Sparkles.nem",
-		"tests/s1disasm/artnem/Unused - Smoke.nem",
-		"tests/s2disasm/art/nemesis/1P and 2P wins text from 2P mode.nem",
-		"tests/s2disasm/art/nemesis/1Player2VS.nem",
-		"tests/s2disasm/art/nemesis/4 stripy blocks from OOZ.nem",
-		"tests/s2disasm/art/nemesis/A few menu blocks.nem",
-		"tests/s2disasm/art/nemesis/A menu box with a shadow.nem",
-		"tests/s2disasm/art/nemesis/ARZ boss.nem",
-		"tests/s2disasm/art/nemesis/Arrow shooter and arrow from ARZ.nem",
-		"tests/s2disasm/art/nemesis/Background art for special stage.nem",
-		"tests/s2disasm/art/nemesis/Balkrie (jet badnik) from SCZ.nem",
-		"tests/s2disasm/art/nemesis/Ball on spring from OOZ (beta holdovers).nem",
-		"tests/s2disasm/art/nemesis/Bear.nem",
-		"tests/s2disasm/art/nemesis/Blowfly from ARZ.nem",
-		"tests/s2disasm/art/nemesis/Bolt end and rope from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Bomb from special stage.nem",
-		"tests/s2disasm/art/nemesis/Bomber badnik from SCZ.nem",
-		"tests/s2disasm/art/nemesis/Bouncer badnik from CNZ.nem",
-		"tests/s2disasm/art/nemesis/Breakaway panels from WFZ.nem",
-		"tests/s2disasm/art/nemesis/Bubble generator.nem",
-		"tests/s2disasm/art/nemesis/Bubbles.nem",
-		"tests/s2disasm/art/nemesis/Burner Platform from OOZ.nem",
-		"tests/s2disasm/art/nemesis/Button.nem",
-		"tests/s2disasm/art/nemesis/Buzzer enemy.nem",
-		"tests/s2disasm/art/nemesis/CNZ boss.nem",
-		"tests/s2disasm/art/nemesis/CNZ elevator.nem",
-		"tests/s2disasm/art/nemesis/CNZ slot machine bars.nem",
-		"tests/s2disasm/art/nemesis/CPZ boss.nem",
-		"tests/s2disasm/art/nemesis/CPZ large moving platform blocks.nem",
-		"tests/s2disasm/art/nemesis/CPZ metal things.nem",
-		"tests/s2disasm/art/nemesis/CPZ spintube exit cover.nem",
-		"tests/s2disasm/art/nemesis/CPZ worm enemy.nem",
-		"tests/s2disasm/art/nemesis/Cascading oil from OOZ.nem",
-		"tests/s2disasm/art/nemesis/Cascading oil hitting oil from OOZ.nem",
-		"tests/s2disasm/art/nemesis/Catapult that shoots Sonic to the side from WFZ.nem",
-		"tests/s2disasm/art/nemesis/Caterpiller platforms from CNZ.nem",
-		"tests/s2disasm/art/nemesis/Chicken.nem",
-		"tests/s2disasm/art/nemesis/Chopper blades for EHZ boss.nem",
-		"tests/s2disasm/art/nemesis/Clouds.nem",
-		"tests/s2disasm/art/nemesis/Coconuts badnik from EHZ.nem",
-		"tests/s2disasm/art/nemesis/Collapsing platform from MCZ.nem",
-		"tests/s2disasm/art/nemesis/Credit Text.nem",
-		"tests/s2disasm/art/nemesis/Diagonal impulse spring from CNZ.nem",
-		"tests/s2disasm/art/nemesis/Diagonal shadow from special stage.nem",
-		"tests/s2disasm/art/nemesis/Diagonal spring.nem",
-		"tests/s2disasm/art/nemesis/Drawbridge logs from MCZ.nem",
-		"tests/s2disasm/art/nemesis/Driller badnik from HTZ.nem",
-		"tests/s2disasm/art/nemesis/Drop target from CNZ.nem",
-		"tests/s2disasm/art/nemesis/Dynamically reloaded cliffs in HTZ background.nem",
-		"tests/s2disasm/art/nemesis/EHZ Pirahna badnik.nem",
-		"tests/s2disasm/art/nemesis/EHZ boss.nem",
-		"tests/s2disasm/art/nemesis/EHZ bridge.nem",
-		"tests/s2disasm/art/nemesis/Eagle.nem",
-		"tests/s2disasm/art/nemesis/Egg Prison.nem",
-		"tests/s2disasm/art/nemesis/Eggpod.nem",
-		"tests/s2disasm/art/nemesis/Eggrobo.nem",
-		"tests/s2disasm/art/nemesis/Emerald from special stage.nem",
-		"tests/s2disasm/art/nemesis/End of level results text.nem",
-		"tests/s2disasm/art/nemesis/Exploding star badnik from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Explosion from special stage.nem",
-		"tests/s2disasm/art/nemesis/Explosion.nem",
-		"tests/s2disasm/art/nemesis/Fan from OOZ.nem",
-		"tests/s2disasm/art/nemesis/Final image of Tails.nem",
-		"tests/s2disasm/art/nemesis/Final image of Tornado with it and Sonic facing screen.nem",
-		"tests/s2disasm/art/nemesis/Fireball 1.nem",
-		"tests/s2disasm/art/nemesis/Fireball 2.nem",
-		"tests/s2disasm/art/nemesis/Fireball 3.nem",
-		"tests/s2disasm/art/nemesis/Firefly from MCZ.nem",
-		"tests/s2disasm/art/nemesis/Flicky.nem",
-		"tests/s2disasm/art/nemesis/Flippers.nem",
-		"tests/s2disasm/art/nemesis/Font using large broken letters.nem",
-		"tests/s2disasm/art/nemesis/Game and Time Over text.nem",
-		"tests/s2disasm/art/nemesis/Green flame from OOZ burners.nem",
-		"tests/s2disasm/art/nemesis/Grounder from ARZ.nem",
-		"tests/s2disasm/art/nemesis/HTZ boss.nem",
-		"tests/s2disasm/art/nemesis/HTZ zip-line platform.nem",
-		"tests/s2disasm/art/nemesis/HUD.nem",
-		"tests/s2disasm/art/nemesis/Hexagonal bumper from CNZ.nem",
-		"tests/s2disasm/art/nemesis/Hook on chain from WFZ.nem",
-		"tests/s2disasm/art/nemesis/Horizontal jet.nem",
-		"tests/s2disasm/art/nemesis/Horizontal shadow from special stage.nem",
-		"tests/s2disasm/art/nemesis/Horizontal spinning blades in WFZ.nem",
-		"tests/s2disasm/art/nemesis/Horizontal spring.nem",
-		"tests/s2disasm/art/nemesis/Invincibility stars.nem",
-		"tests/s2disasm/art/nemesis/Large explosion.nem",
-		"tests/s2disasm/art/nemesis/Large moving platform from CPZ.nem",
-		"tests/s2disasm/art/nemesis/Large spinning wheel from MTZ - indent.nem",
-		"tests/s2disasm/art/nemesis/Large spinning wheel from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Large wooden box from MCZ.nem",
-		"tests/s2disasm/art/nemesis/Lava bubble from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Lava cup from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Leaves in ARZ.nem",
-		"tests/s2disasm/art/nemesis/Lever spring.nem",
-		"tests/s2disasm/art/nemesis/Long horizontal spike.nem",
-		"tests/s2disasm/art/nemesis/MCZ boss.nem",
-		"tests/s2disasm/art/nemesis/MTZ boss.nem",
-		"tests/s2disasm/art/nemesis/MTZ spike block.nem",
-		"tests/s2disasm/art/nemesis/Main patterns from title screen.nem",
-		"tests/s2disasm/art/nemesis/Miles life counter.nem",
-		"tests/s2disasm/art/nemesis/Monitor and contents.nem",
-		"tests/s2disasm/art/nemesis/Monkey.nem",
-		"tests/s2disasm/art/nemesis/Mouse.nem",
-		"tests/s2disasm/art/nemesis/Movie sequence at end of game.nem",
-		"tests/s2disasm/art/nemesis/Moving block from CNZ and CPZ.nem",
-		"tests/s2disasm/art/nemesis/Moving block from CPZ.nem",
-		"tests/s2disasm/art/nemesis/Moving platform from WFZ.nem",
-		"tests/s2disasm/art/nemesis/Numbers.nem",
-		"tests/s2disasm/art/nemesis/OOZ boss.nem",
-		"tests/s2disasm/art/nemesis/OOZ collapsing platform.nem",
-		"tests/s2disasm/art/nemesis/Octopus badnik from OOZ.nem",
-		"tests/s2disasm/art/nemesis/One way barrier from ARZ.nem",
-		"tests/s2disasm/art/nemesis/One way barrier from HTZ.nem",
-		"tests/s2disasm/art/nemesis/Penguin.nem",
-		"tests/s2disasm/art/nemesis/Perfect text.nem",
-		"tests/s2disasm/art/nemesis/Pictures in level preview box from level select.nem",
-		"tests/s2disasm/art/nemesis/Pig.nem",
-		"tests/s2disasm/art/nemesis/Platform on belt in WFZ.nem",
-		"tests/s2disasm/art/nemesis/Praying mantis badnik from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Pull switch from MCZ.nem",
-		"tests/s2disasm/art/nemesis/Push spring from OOZ.nem",
-		"tests/s2disasm/art/nemesis/Rabbit.nem",
-		"tests/s2disasm/art/nemesis/Red horizontal laser from WFZ.nem",
-		"tests/s2disasm/art/nemesis/Retracting platform from WFZ.nem",
-		"tests/s2disasm/art/nemesis/Rexxon (lava snake) from HTZ.nem",
-		"tests/s2disasm/art/nemesis/Ring.nem",
-		"tests/s2disasm/art/nemesis/Rising platform from OOZ.nem",
-		"tests/s2disasm/art/nemesis/Robotnik's head.nem",
-		"tests/s2disasm/art/nemesis/Robotnik's lower half.nem",
-		"tests/s2disasm/art/nemesis/Robotnik.nem",
-		"tests/s2disasm/art/nemesis/Rock from HTZ.nem",
-		"tests/s2disasm/art/nemesis/Rocket thruster for Tornado.nem",
-		"tests/s2disasm/art/nemesis/Round bumper from CNZ.nem",
-		"tests/s2disasm/art/nemesis/SEGA.nem",
-		"tests/s2disasm/art/nemesis/Scratch from WFZ.nem",
-		"tests/s2disasm/art/nemesis/Seahorse from OOZ.nem",
-		"tests/s2disasm/art/nemesis/Seal.nem",
-		"tests/s2disasm/art/nemesis/See-saw in HTZ.nem",
-		"tests/s2disasm/art/nemesis/Shaded blocks from intro.nem",
-		"tests/s2disasm/art/nemesis/Shark from ARZ.nem",
-		"tests/s2disasm/art/nemesis/Shellcracker badnik from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Shield.nem",
-		"tests/s2disasm/art/nemesis/Signpost.nem",
-		"tests/s2disasm/art/nemesis/Silver Sonic.nem",
-		"tests/s2disasm/art/nemesis/Similarly shaded blocks from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Small cog from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Small pictures of Sonic and final image of Sonic in Super Sonic mode.nem",
-		"tests/s2disasm/art/nemesis/Small pictures of Sonic and final image of Sonic.nem",
-		"tests/s2disasm/art/nemesis/Small pictures of Tornado in final ending sequence.nem",
-		"tests/s2disasm/art/nemesis/Small yellow moving platform from CPZ.nem",
-		"tests/s2disasm/art/nemesis/Smoke trail from CPZ and HTZ bosses.nem",
-		"tests/s2disasm/art/nemesis/Snake badnik from MCZ.nem",
-		"tests/s2disasm/art/nemesis/Sol badnik from HTZ.nem",
-		"tests/s2disasm/art/nemesis/Sonic and Miles number text from special stage.nem",
-		"tests/s2disasm/art/nemesis/Sonic and Tails animation frames in special stage.nem",
-		"tests/s2disasm/art/nemesis/Sonic and Tails from title screen.nem",
-		"tests/s2disasm/art/nemesis/Sonic continue.nem",
-		"tests/s2disasm/art/nemesis/Sonic lives counter.nem",
-		"tests/s2disasm/art/nemesis/Sonic the Hedgehog 2 image at end of credits.nem",
-		"tests/s2disasm/art/nemesis/Special stage Player VS Player text.nem",
-		"tests/s2disasm/art/nemesis/Special stage messages and icons.nem",
-		"tests/s2disasm/art/nemesis/Special stage results screen art and some emeralds.nem",
-		"tests/s2disasm/art/nemesis/Special stage ring art.nem",
-		"tests/s2disasm/art/nemesis/Speed booster from CPZ.nem",
-		"tests/s2disasm/art/nemesis/Spider badnik from CPZ.nem",
-		"tests/s2disasm/art/nemesis/Spike from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Spiked ball from OOZ.nem",
-		"tests/s2disasm/art/nemesis/Spikes.nem",
-		"tests/s2disasm/art/nemesis/Spikey ball from CNZ slots.nem",
-		"tests/s2disasm/art/nemesis/Spin tube flash from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Squirrel.nem",
-		"tests/s2disasm/art/nemesis/Standard font.nem",
-		"tests/s2disasm/art/nemesis/Star pole.nem",
-		"tests/s2disasm/art/nemesis/Stars in special stage.nem",
-		"tests/s2disasm/art/nemesis/Start text from special stage.nem",
-		"tests/s2disasm/art/nemesis/Steam from MTZ.nem",
-		"tests/s2disasm/art/nemesis/Striped blocks from CPZ.nem",
-		"tests/s2disasm/art/nemesis/Stripy blocks from CPZ.nem",
-		"tests/s2disasm/art/nemesis/Super Sonic stars.nem",
-		"tests/s2disasm/art/nemesis/Swinging platform from OOZ.nem",
-		"tests/s2disasm/art/nemesis/Tails continue.nem",
-		"tests/s2disasm/art/nemesis/Tails life counter.nem",
-		"tests/s2disasm/art/nemesis/Tails on continue screen.nem",
-		"tests/s2disasm/art/nemesis/Tails text patterns from special stage.nem",
-		"tests/s2disasm/art/nemesis/The Tornado.nem",
-		"tests/s2disasm/art/nemesis/Thrust from Robotnik's getaway ship in WFZ.nem",
-		"tests/s2disasm/art/nemesis/Tilting plaforms in WFZ.nem",
-		"tests/s2disasm/art/nemesis/Title card.nem",
-		"tests/s2disasm/art/nemesis/Top of water in ARZ.nem",
-		"tests/s2disasm/art/nemesis/Top of water in HPZ and CNZ.nem",
-		"tests/s2disasm/art/nemesis/Transporter ball from OOZ.nem",
-		"tests/s2disasm/art/nemesis/Turtle badnik from SCZ.nem",
-		"tests/s2disasm/art/nemesis/Turtle.nem",
-		"tests/s2disasm/art/nemesis/Unused badnik from WFZ.nem",
-		"tests/s2disasm/art/nemesis/Unused vertical laser in WFZ.nem",
-		"tests/s2disasm/art/nemesis/Vertical impulse spring.nem",
-		"tests/s2disasm/art/nemesis/Vertical shadow from special stage.nem",
-		"tests/s2disasm/art/nemesis/Vertical spinning blades in WFZ.nem",
-		"tests/s2disasm/art/nemesis/Vertical spring.nem",
-		"tests/s2disasm/art/nemesis/Vine that lowers from MCZ.nem",
-		"tests/s2disasm/art/nemesis/WFZ boss chamber switch.nem",
-		"tests/s2disasm/art/nemesis/WFZ boss.nem",
-		"tests/s2disasm/art/nemesis/Wall turret from WFZ.nem",
-		"tests/s2disasm/art/nemesis/Waterfall tiles.nem",
-		"tests/s2disasm/art/nemesis/Weird crawling badnik from CPZ.nem",
-		"tests/s2disasm/art/nemesis/Wheel for belt in WFZ.nem",
-		"tests/s2disasm/art/nemesis/Window in back that Robotnik looks through in DEZ.nem",
-		"tests/skdisasm/General/2P Zone/Nemesis Art/Lap Numbers.bin",
-		"tests/skdisasm/General/2P Zone/Nemesis Art/Misc Art 1.bin",
-		"tests/skdisasm/General/2P Zone/Nemesis Art/Misc Art 2.bin",
-		"tests/skdisasm/General/2P Zone/Nemesis Art/Misc Art 3.bin",
-		"tests/skdisasm/General/2P Zone/Nemesis Art/Position Icons.bin",
-		"tests/skdisasm/General/2P Zone/Nemesis Art/Spindash Dust.bin",
-		"tests/skdisasm/General/2P Zone/Nemesis Art/Start Post.bin",
-		"tests/skdisasm/General/2P Zone/Nemesis Art/Time Display.bin",
-		"tests/skdisasm/General/Blue Sphere/Nemesis Art/SK Logo.bin",
-		"tests/skdisasm/General/Blue Sphere/Nemesis Art/Tails Pose.bin",
-		"tests/skdisasm/General/Ending/Nemesis Art/Knuckles Ending Pose.bin",
-		"tests/skdisasm/General/Ending/Nemesis Art/Large Text.bin",
-		"tests/skdisasm/General/Ending/Nemesis Art/S3 8x16 Font.bin",
-		"tests/skdisasm/General/Ending/Nemesis Art/S3 Ending Graphics.bin",
-		"tests/skdisasm/General/Ending/Nemesis Art/S3 Large Text.bin",
-		"tests/skdisasm/General/S2Menu/Nemesis Art/1P 2P Wins.bin",
-		"tests/skdisasm/General/S2Menu/Nemesis Art/2P Options.bin",
-		"tests/skdisasm/General/S2Menu/Nemesis Art/Level Select Icons.bin",
-		"tests/skdisasm/General/S2Menu/Nemesis Art/Menu Box.bin",
-		"tests/skdisasm/General/S2Menu/Nemesis Art/Signpost.bin",
-		"tests/skdisasm/General/S2Menu/Nemesis Art/Sonic Continue Icon.bin",
-		"tests/skdisasm/General/S2Menu/Nemesis Art/Tails Continue Icon.bin",
-		"tests/skdisasm/General/S2Menu/Nemesis Art/Tails Continue Sprites.bin",
-		"tests/skdisasm/General/Special Stage/Nemesis Art/BG.bin",
-		"tests/skdisasm/General/Special Stage/Nemesis Art/Digits.bin",
-		"tests/skdisasm/General/Special Stage/Nemesis Art/Eosian Spheres.bin",
-		"tests/skdisasm/General/Special Stage/Nemesis Art/Get Blue Spheres Arrow.bin",
-		"tests/skdisasm/General/Special Stage/Nemesis Art/Get Blue Spheres.bin",
-		"tests/skdisasm/General/Special Stage/Nemesis Art/Icons.bin",
-		"tests/skdisasm/General/Special Stage/Nemesis Art/Layout.bin",
-		"tests/skdisasm/General/Special Stage/Nemesis Art/Ring.bin",
-		"tests/skdisasm/General/Special Stage/Nemesis Art/Shadow.bin",
-		"tests/skdisasm/General/Special Stage/Nemesis Art/Sphere.bin",
-		"tests/skdisasm/General/Sprites/Animals/Blue Flicky.bin",
-		"tests/skdisasm/General/Sprites/Animals/Chicken.bin",
-		"tests/skdisasm/General/Sprites/Animals/Penguin.bin",
-		"tests/skdisasm/General/Sprites/Animals/Pig.bin",
-		"tests/skdisasm/General/Sprites/Animals/Rabbit.bin",
-		"tests/skdisasm/General/Sprites/Animals/Seal.bin",
-		"tests/skdisasm/General/Sprites/Animals/Squirrel.bin",
-		"tests/skdisasm/General/Sprites/Boss Explosion/Boss Explosion.bin",
-		"tests/skdisasm/General/Sprites/Bubbles/Bubbles.bin",
-		"tests/skdisasm/General/Sprites/Buggernaut/Buggernaut.bin",
-		"tests/skdisasm/General/Sprites/Buttons/Gray Button.bin",
-		"tests/skdisasm/General/Sprites/Continue/Player Sprites.bin",
-		"tests/skdisasm/General/Sprites/Continue/Player Icons.bin",
-		"tests/skdisasm/General/Sprites/Continue/Digits.bin",
-		"tests/skdisasm/General/Sprites/Egg Capsule/Egg Capsule.bin",
-		"tests/skdisasm/General/Sprites/Egg Robo/Egg Robo Run.bin",
-		"tests/skdisasm/General/Sprites/Egg Robo/Egg Robo Stand.bin",
-		"tests/skdisasm/General/Sprites/Enemy Misc/EnemyPtsStarpost.bin",
-		"tests/skdisasm/General/Sprites/Enemy Misc/Explosion.bin",
-		"tests/skdisasm/General/Sprites/Game Over/GameOver.bin",
-		"tests/skdisasm/General/Sprites/HUD Icon/Knuckles Life Icon.bin",
-		"tests/skdisasm/General/Sprites/HUD Icon/Miles Life Icon.bin",
-		"tests/skdisasm/General/Sprites/HUD Icon/Sonic Life Icon.bin",
-		"tests/skdisasm/General/Sprites/HUD Icon/Tails Life Icon.bin",
-		"tests/skdisasm/General/Sprites/Knuckles/Cutscene/Knuckles Bomb.bin",
-		"tests/skdisasm/General/Sprites/Level Misc/Diagonal Spring.bin",
-		"tests/skdisasm/General/Sprites/Level Misc/SpikesSprings.bin",
-		"tests/skdisasm/General/Sprites/Monitors/Monitors.bin",
-		"tests/skdisasm/General/Sprites/Ring/RingHUDText.bin",
-		"tests/skdisasm/General/Sprites/Robotnik/FBZ Robotnik Head.bin",
-		"tests/skdisasm/General/Sprites/Robotnik/FBZ Robotnik Run.bin",
-		"tests/skdisasm/General/Sprites/Robotnik/FBZ Robotnik Stand.bin",
-		"tests/skdisasm/General/Sprites/Robotnik/Ship.bin",
-		"tests/skdisasm/General/Sprites/Signpost/Stub.bin",
-		"tests/skdisasm/General/Sprites/Snowboard/Snowboard Dust.bin",
-		"tests/skdisasm/General/Title/Nemesis Art/S3 Banner.bin",
-		"tests/skdisasm/General/Title/Nemesis Art/S3 Screen Text.bin",
-		"tests/skdisasm/General/Title/Nemesis Art/S3 Sonic Sprites.bin",
-		"tests/skdisasm/General/Title/Nemesis Art/SK ANDKnuckles.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/BG Tree.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Cork Floor 1.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Cork Floor 2.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Falling Log.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Intro Waves.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Miniboss Fire.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Miniboss Small.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Miniboss.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Misc Art 1.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Misc Art 2.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Swing Vine.bin",
-		"tests/skdisasm/Levels/AIZ/Nemesis Art/Zip Vine.bin",
-		"tests/skdisasm/Levels/BPZ/Nemesis Art/Misc Art.bin",
-		"tests/skdisasm/Levels/CGZ/Nemesis Art/Platform.bin",
-		"tests/skdisasm/Levels/CNZ/Nemesis Art/End Boss.bin",
-		"tests/skdisasm/Levels/CNZ/Nemesis Art/Miniboss.bin",
-		"tests/skdisasm/Levels/CNZ/Nemesis Art/Misc Art.bin",
-		"tests/skdisasm/Levels/CNZ/Nemesis Art/Platform.bin",
-		"tests/skdisasm/Levels/DEZ/Nemesis Art/Act 2 Extra Art.bin",
-		"tests/skdisasm/Levels/DEZ/Nemesis Art/Miniboss.bin",
-		"tests/skdisasm/Levels/DEZ/Nemesis Art/Misc Art.bin",
-		"tests/skdisasm/Levels/DPZ/Nemesis Art/Misc Art.bin",
-		"tests/skdisasm/Levels/EMZ/Nemesis Art/Misc Art.bin",
-		"tests/skdisasm/Levels/FBZ/Nemesis Art/Act 2 Subboss.bin",
-		"tests/skdisasm/Levels/FBZ/Nemesis Art/Egg Capsule.bin",
-		"tests/skdisasm/Levels/FBZ/Nemesis Art/End Boss Flame.bin",
-		"tests/skdisasm/Levels/FBZ/Nemesis Art/End Boss.bin",
-		"tests/skdisasm/Levels/FBZ/Nemesis Art/Misc Art 1.bin",
-		"tests/skdisasm/Levels/FBZ/Nemesis Art/Misc Art 2.bin",
-		"tests/skdisasm/Levels/FBZ/Nemesis Art/Outdoors.bin",
-		"tests/skdisasm/Levels/FBZ/Nemesis Art/S3 Miniboss.bin",
-		"tests/skdisasm/Levels/Gumball/Nemesis Art/Gumball Bonus.bin",
-		"tests/skdisasm/Levels/FBZ/Nemesis Art/Outdoors.bin",
-		"tests/skdisasm/Levels/HCZ/Nemesis Art/Act 2 Block Platform.bin",
-		"tests/skdisasm/Levels/HCZ/Nemesis Art/Act 2 Knuckles Wall.bin",
-		"tests/skdisasm/Levels/HCZ/Nemesis Art/Act 2 Slide.bin",
-		"tests/skdisasm/Levels/HCZ/Nemesis Art/Button.bin",
-		"tests/skdisasm/Levels/HCZ/Nemesis Art/End Boss.bin",
-		"tests/skdisasm/Levels/HCZ/Nemesis Art/Miniboss.bin",
-		"tests/skdisasm/Levels/HCZ/Nemesis Art/Misc Art.bin",
-		"tests/skdisasm/Levels/HCZ/Nemesis Art/Spike Ball.bin",
-		"tests/skdisasm/Levels/HCZ/Nemesis Art/Water Rush.bin",
-		"tests/skdisasm/Levels/HCZ/Nemesis Art/Wave Splash.bin",
-		"tests/skdisasm/Levels/HPZ/Nemesis Art/Emerald Misc Art.bin",
-		"tests/skdisasm/Levels/HPZ/Nemesis Art/Gray Emerald.bin",
-		"tests/skdisasm/Levels/ICZ/Nemesis Art/End Boss.bin",
-		"tests/skdisasm/Levels/ICZ/Nemesis Art/Intro Sprites.bin",
-		"tests/skdisasm/Levels/ICZ/Nemesis Art/Miniboss.bin",
-		"tests/skdisasm/Levels/ICZ/Nemesis Art/Misc Art 1.bin",
-		"tests/skdisasm/Levels/ICZ/Nemesis Art/Misc Art 2.bin",
-		"tests/skdisasm/Levels/ICZ/Nemesis Art/Teleporter Beam.bin",
-		"tests/skdisasm/Levels/LBZ/Nemesis Art/Act 2 Misc Art.bin",
-		"tests/skdisasm/Levels/LBZ/Nemesis Art/Final Boss 1.bin",
-		"tests/skdisasm/Levels/LBZ/Nemesis Art/Misc Art.bin",
-		"tests/skdisasm/Levels/LBZ/Nemesis Art/Tube Transport.bin",
-		"tests/skdisasm/Levels/LRZ/Nemesis Art/Act 2 Misc Art.bin",
-		"tests/skdisasm/Levels/LRZ/Nemesis Art/Act 2 Spinning Drum.bin",
-		"tests/skdisasm/Levels/LRZ/Nemesis Art/Big Spike Ball.bin",
-		"tests/skdisasm/Levels/LRZ/Nemesis Art/Misc Art.bin",
-		"tests/skdisasm/Levels/LRZ/Nemesis Art/Spike Crush.bin",
-		"tests/skdisasm/Levels/MGZ/Nemesis Art/Direction Signs.bin",
-		"tests/skdisasm/Levels/MGZ/Nemesis Art/Misc Art 1.bin",
-		"tests/skdisasm/Levels/MGZ/Nemesis Art/Misc Art 2.bin",
-		"tests/skdisasm/Levels/MGZ/Nemesis Art/Spire.bin",
-		"tests/skdisasm/Levels/MHZ/Nemesis Art/Misc Art.bin",
-		"tests/skdisasm/Levels/Pachinko/Nemesis Art/Main.bin",
-		"tests/skdisasm/Levels/Slots/Nemesis Art/Blocks.bin",
-		"tests/skdisasm/Levels/SOZ/Nemesis Art/Act 2 Extra Art.bin",
-		"tests/skdisasm/Levels/SOZ/Nemesis Art/Misc Art.bin",
-		"tests/skdisasm/Levels/SOZ/Nemesis Art/Tile.bin",
-		"tests/skdisasm/Levels/SSZ/Nemesis Art/Misc.bin",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Aquis.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Arrow_S.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Asteron.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/AutoDoor.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BBumpers.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BMonster.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/B_Blades.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Backgnd.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Balkiry.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Ball.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Batbot.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Bear.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Blink.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BlueBird.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Boost_Up.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Boss.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BossBall.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BossFire.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Boss_Car.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Boss_Smk.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Box.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Bridge.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BrkBlock.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BrkBst_H.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/BrkBst_V.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Bubbles.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Bumpers.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Buzzer.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/CNZDyn_Init.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/CPZBoss.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/CPZDyn_Init.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/CPZPlatform.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Cannon.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Chicken.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/ChopChop.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Clp_Ptfm.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Clucker.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Coconuts.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Crawl.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Crawlton.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Crocobot.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/DHZBoss.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/DHZBox.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/DSpring1.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/D_Launch.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/D_Spring.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Dinobot.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/DynInit2.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Dyn_Init.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/EHZBridge.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/EHZWatrFall.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Elevator.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Emerald.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/EndPanel.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Explosn.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Explosns.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Fans.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Fire_Bst.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Fireball.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Flasher.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Flippers.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/GBumpers.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/GSpkball.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/GT_Over.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Gear.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/GearHole.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Grabber.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/GreenPtf.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Grounder.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/HPZBridge.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/HPZWatrFall.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/HTZAutoDoor.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/HTZDyn_Init.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/H_Spikes.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/H_Spring.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Harp_Ptf.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Harpoon.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Hud.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/HudSonic.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/InvStars.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/LampPost.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Lander.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Leaves.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/LvBubble.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/MZDyn_Init.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/MZElevator.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/MZLvBubble.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Masher.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Metal_St.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/MiniGear.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Miscelns.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Monitors.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Monkey.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Motobug.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Mouse.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/NGHZAutoDoor.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/NGHZBoss.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/NGHZDyn_Init.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/NGHZWatrSurf.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Nebula.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/OC_Ptfrm.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/OOZBoss.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/OOZDyn_Init.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/OOZElevator.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/OOZPlatform.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Octus.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Oil.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Oil_01.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Orbs.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Oxygen.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Parallel.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Penguin.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Pig.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Pigeon.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Piranha.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Platform.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Points.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Rabbit.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Rexon.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Rhinobot.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Rings.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Robotnik.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Rock.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/ScrewNut.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Seal.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/See-saw.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/See-sawb.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Sega.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Shellcrc.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Shield.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/ShpBoost.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Slicer.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SlotMach.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SncMlScr.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SpeedBst.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SpgTubes.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Spikball.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Spiker.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Spikes.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SpinBall.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SpngPush.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Squirrel.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Steam.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Switch.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/SwngPtfm.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Telefrcs.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/TitleScr.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/TlpFlash.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Tri_Ptfm.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Turtle.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Turtloid.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/UnkFball.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/UnkPtfm.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/V_Launch.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/V_Spring.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Vines.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Vines_1.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/W_Splash.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/WatrSurf.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Whisp.nem",
-		"tests/Sonic-2-Aug-21st-Disassembly/Art/Nemesis/Worms.nem",
-	};
-
+	success = cc_true;
 	total_uncompressed_size = total_original_compressed_size = total_new_compressed_size = 0;
+	total_compression_time = 0;
 
 	MemoryStream_Initialise(&compressed_memory_stream);
 	MemoryStream_Initialise(&decompressed_memory_stream);
 	MemoryStream_Initialise(&compressed_memory_stream_2);
 	MemoryStream_Initialise(&decompressed_memory_stream_2);
 
-	for (i = 0; i < CC_COUNT_OF(files); ++i)
+	for (i = 0; i < CC_COUNT_OF(test_files); ++i)
 	{
-		const char* const file_path = files[i];
+		const char* const file_path = test_files[i];
 		FILE* const file = fopen(file_path, "rb");
 
 		if (file == NULL)
@@ -801,24 +1682,91 @@ static void DoTests(const cc_bool accurate)
 			if (!ClownNemesis_Decompress(ReadByteFromMemoryStream, &compressed_memory_stream, WriteByteToMemoryStream, &decompressed_memory_stream))
 			{
 				fprintf(stdout, "Could not decompress file '%s'.\n", file_path);
+				success = cc_false;
 			}
 			else
 			{
-				if (!ClownNemesis_Compress(accurate, ReadByteFromMemoryStream, &decompressed_memory_stream, WriteByteToMemoryStream, &compressed_memory_stream_2))
+				const clock_t start_time = clock();
+				const int compressed = ClownNemesis_CompressorCompress(compressor, options, ReadByteFromMemoryStream, &decompressed_memory_stream, WriteByteToMemoryStream, &compressed_memory_stream_2);
+
+				total_compression_time += clock() - start_time;
+
+				if (!compressed)
 				{
 					fprintf(stdout, "Could not compress file '%s'.\n", file_path);
+					success = cc_false;
+				}
+				else if (compressed_memory_stream_2.write_index > ClownNemesis_CompressBound(decompressed_memory_stream.write_index / 0x20))
+				{
+					fprintf(stdout, "Compression of file '%s' exceeds the bound.\n", file_path);
+					success = cc_false;
+				}
+				else if (compressed_memory_stream_2.write_index != ClownNemesis_EstimateCompressedSize(options, ReadByteFromMemoryStream, &decompressed_memory_stream))
+				{
+					fprintf(stdout, "Estimated size of file '%s' does not match its compressed size.\n", file_path);
+					success = cc_false;
+				}
+				else if (!TestBudget(compressor, options, &decompressed_memory_stream, &decompressed_memory_stream_2, compressed_memory_stream_2.write_index))
+				{
+					fprintf(stdout, "Budget was not enforced correctly for file '%s'.\n", file_path);
+					success = cc_false;
+				}
+				else if (options->accurate && !TestBitmap(compressor, options, &decompressed_memory_stream, &decompressed_memory_stream_2, &compressed_memory_stream_2))
+				{
+					/* This is only tested once, as it is the same for every option. */
+					fprintf(stdout, "Bitmap of file '%s' did not compress the same as its tiles.\n", file_path);
+					success = cc_false;
+				}
+				else if (!TestPartialHistograms(compressor, options, &decompressed_memory_stream, &decompressed_memory_stream_2, &compressed_memory_stream_2))
+				{
+					fprintf(stdout, "Partial histograms of file '%s' do not add up to its histogram, or do not compress like it.\n", file_path);
+					success = cc_false;
+				}
+				else if ((options->accurate || options->effort < CLOWNNEMESIS_EFFORT_HIGH) && !TestRecompress(compressor, options, &compressed_memory_stream, &decompressed_memory_stream_2, &compressed_memory_stream_2))
+				{
+					/* The slower effort levels are skipped, as they read the input the same way as the others. */
+					fprintf(stdout, "Recompression of file '%s' does not match its compression.\n", file_path);
+					success = cc_false;
+				}
+				else if (!options->accurate && options->effort == CLOWNNEMESIS_EFFORT_NORMAL && !TestSession(compressor, options, &decompressed_memory_stream, &decompressed_memory_stream_2, &compressed_memory_stream_2))
+				{
+					/* Sessions always compress like the normal effort level. */
+					fprintf(stdout, "Session of file '%s' does not match its tiles.\n", file_path);
+					success = cc_false;
+				}
+				else if (!options->accurate && options->effort >= CLOWNNEMESIS_EFFORT_HIGH && !TestRefinedSeeds(compressor, options, &decompressed_memory_stream, &decompressed_memory_stream_2, &compressed_memory_stream_2))
+				{
+					fprintf(stdout, "Refined seeds of file '%s' do not match its compression.\n", file_path);
+					success = cc_false;
+				}
+				else if (!options->accurate && options->effort > CLOWNNEMESIS_EFFORT_FASTEST && !TestDecodeSpeed(compressor, options, &decompressed_memory_stream, &decompressed_memory_stream_2, &compressed_memory_stream_2))
+				{
+					fprintf(stdout, "Favouring the decoding speed of file '%s' is not valid, or does not decode faster.\n", file_path);
+					success = cc_false;
+				}
+				else if (!TestChunks(compressor, options, &decompressed_memory_stream, &decompressed_memory_stream_2, &compressed_memory_stream_2))
+				{
+					fprintf(stdout, "Chunks of file '%s' do not join up to its compression.\n", file_path);
+					success = cc_false;
+				}
+				else if (options->accurate && !TestContainer(&decompressed_memory_stream, &decompressed_memory_stream_2, &compressed_memory_stream, &compressed_memory_stream_2))
+				{
+					fprintf(stdout, "Container of file '%s' does not match its archives.\n", file_path);
+					success = cc_false;
 				}
 				else
 				{
 					if (!ClownNemesis_Decompress(ReadByteFromMemoryStream, &compressed_memory_stream_2, WriteByteToMemoryStream, &decompressed_memory_stream_2))
 					{
 						fprintf(stdout, "Could not re-decompress file '%s'.\n", file_path);
+						success = cc_false;
 					}
 					else
 					{
 						if (decompressed_memory_stream.write_index != decompressed_memory_stream_2.write_index || memcmp(decompressed_memory_stream.buffer, decompressed_memory_stream_2.buffer, decompressed_memory_stream.write_index) != 0)
 						{
 							fprintf(stdout, "Decompressions of file '%s' do not match.\n", file_path);
+							success = cc_false;
 						}
 						else
 						{
@@ -826,10 +1774,13 @@ static void DoTests(const cc_bool accurate)
 							total_uncompressed_size += decompressed_memory_stream.write_index;
 							total_new_compressed_size += compressed_memory_stream_2.write_index;
 
-							if (accurate)
+							if (options->accurate)
 							{
 								if ((compressed_memory_stream.write_index < compressed_memory_stream_2.write_index || memcmp(compressed_memory_stream.buffer, compressed_memory_stream_2.buffer, compressed_memory_stream_2.write_index) != 0))
+								{
 									fprintf(stdout, "Compressions of file '%s' do not match.\n", file_path);
+									success = cc_false;
+								}
 								else if (compressed_memory_stream.write_index > compressed_memory_stream_2.write_index)
 
 								{
@@ -853,17 +1804,55 @@ static void DoTests(const cc_bool accurate)
 	MemoryStream_Deinitialise(&decompressed_memory_stream_2);
 
 	fprintf(stdout, "Uncompressed size:   %ld\nOld compressed size: %ld\nNew compressed size: %ld\nNew vs. old: %f%%\n", (unsigned long)total_uncompressed_size, (unsigned long)total_original_compressed_size, (unsigned long)total_new_compressed_size, (double)total_new_compressed_size / total_original_compressed_size * 100);
+	fprintf(stdout, "Compression time:    %f seconds\n", (double)total_compression_time / CLOCKS_PER_SEC);
+
+	return success;
 }
 
 int main(const int argc, char** const argv)
 {
+	cc_bool success;
+	ClownNemesis_CompressOptions options;
+	ClownNemesis_Compressor *compressor;
+
 	(void)argc;
 	(void)argv;
 
+	/* The same compressor is reused for every test, like a program compressing many files would. */
+	compressor = ClownNemesis_CompressorCreate();
+
+	if (compressor == NULL)
+	{
+		fputs("Could not create compressor.\n", stdout);
+		return EXIT_FAILURE;
+	}
+
+	ClownNemesis_DefaultCompressOptions(&options);
+
+	/* Accurate compression must produce byte-identical output to Sega's compressor for every file. */
 	fputs("Testing accurate compression...\n", stdout);
-	DoTests(cc_true);
-	fputs("\nTesting improved compression...\n", stdout);
-	DoTests(cc_false);
+	options.accurate = cc_true;
+	success = DoTests(compressor, &options);
+
+	/* Every effort level must produce valid data; the sizes and times show the trade-off between them. */
+	options.accurate = cc_false;
+
+	for (options.effort = CLOWNNEMESIS_EFFORT_FASTEST; options.effort <= CLOWNNEMESIS_EFFORT_EXHAUSTIVE; ++options.effort)
+	{
+		fprintf(stdout, "\nTesting compression with effort level %d...\n", options.effort);
+		success &= DoTests(compressor, &options);
+	}
+
+	fputs("\nTesting shared code tables...\n", stdout);
+	success &= TestCodeTables(compressor);
+
+	fputs("\nTesting splitting...\n", stdout);
+	success &= TestSplit(compressor);
+
+	fputs("\nTesting empty input...\n", stdout);
+	success &= TestEmptyInput();
+
+	ClownNemesis_CompressorDestroy(compressor);
 
-	return EXIT_SUCCESS;
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
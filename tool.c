@@ -1,98 +1,3133 @@
+#if (defined(CLOWNNEMESIS_THREADS) || defined(CLOWNNEMESIS_MAPPED_FILES) || defined(CLOWNNEMESIS_HAVE_LSTAT) || defined(CLOWNNEMESIS_HAVE_GETPID)) && !defined(_WIN32)
+/* For 'clock_gettime', 'mmap', 'lstat', and 'fdopen'. */
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+/* For condition variables. */
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+#include <windows.h>
+#elif defined(CLOWNNEMESIS_THREADS) || defined(CLOWNNEMESIS_MAPPED_FILES) || defined(CLOWNNEMESIS_HAVE_GETPID)
+#include <unistd.h>
+#endif
+
+#if defined(CLOWNNEMESIS_THREADS) && !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#if (defined(CLOWNNEMESIS_MAPPED_FILES) || defined(CLOWNNEMESIS_HAVE_GETPID)) && !defined(_WIN32)
+#include <fcntl.h>
+#endif
+
+#if defined(CLOWNNEMESIS_MAPPED_FILES) && !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#if (defined(CLOWNNEMESIS_MAPPED_FILES) || defined(CLOWNNEMESIS_HAVE_LSTAT)) && !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+#include "clowncommon/clowncommon.h"
+
+#include "compress.h"
+#include "container.h"
+#include "decompress.h"
+
+#define VERSION "v1.1.1"
+
+static int InputCallback(void* const user_data)
+{
+	/* The compressor reads its input more than once, so the file is rewound at the end. */
+	/* Streams which cannot be rewound, such as pipes, must be read into memory with 'ReadStream' instead. */
+	FILE* const file = (FILE*)user_data;
+	const int character = fgetc(file);
+
+	if (character == EOF)
+	{
+		if (ferror(file))
+			return CLOWNNEMESIS_ERROR;
+
+		rewind(file);
+		return CLOWNNEMESIS_EOF;
+	}
+
+	return character;
+}
+
+static int OutputCallback(void* const user_data, const unsigned char byte)
+{
+	const int return_value = fputc(byte, (FILE*)user_data);
+
+	return return_value == EOF ? CLOWNNEMESIS_ERROR : return_value;
+}
+
+typedef struct MemoryBuffer
+{
+	unsigned char *bytes;
+	size_t size, capacity, position;
+} MemoryBuffer;
+
+static int MemoryInputCallback(void* const user_data)
+{
+	MemoryBuffer* const buffer = (MemoryBuffer*)user_data;
+
+	if (buffer->position == buffer->size)
+	{
+		buffer->position = 0;
+		return CLOWNNEMESIS_EOF;
+	}
+
+	return buffer->bytes[buffer->position++];
+}
+
+static int MemoryOutputCallback(void* const user_data, const unsigned char byte)
+{
+	MemoryBuffer* const buffer = (MemoryBuffer*)user_data;
+
+	if (buffer->size == buffer->capacity)
+	{
+		unsigned char *new_bytes;
+
+		const size_t new_capacity = buffer->capacity == 0 ? 0x1000 : buffer->capacity * 2;
+
+		if (buffer->capacity > (size_t)-1 / 2)
+			return CLOWNNEMESIS_ERROR;
+
+		new_bytes = (unsigned char*)realloc(buffer->bytes, new_capacity);
+
+		if (new_bytes == NULL)
+			return CLOWNNEMESIS_ERROR;
+
+		buffer->bytes = new_bytes;
+		buffer->capacity = new_capacity;
+	}
+
+	buffer->bytes[buffer->size++] = byte;
+
+	return byte;
+}
+
+static cc_bool ReadStream(FILE* const file, MemoryBuffer* const buffer)
+{
+	/* Reads all of the stream into the buffer, which must be freed even on failure. */
+	int character;
+
+	buffer->bytes = NULL;
+	buffer->size = buffer->capacity = buffer->position = 0;
+
+	while ((character = fgetc(file)) != EOF)
+		if (MemoryOutputCallback(buffer, (unsigned char)character) == CLOWNNEMESIS_ERROR)
+			return cc_false;
+
+	return !ferror(file);
+}
+
+static cc_bool IsStandardStream(const char* const path)
+{
+	/* '-' means standard input or standard output, so that the tool can be used in pipelines. */
+	return path[0] == '-' && path[1] == '\0';
+}
+
+static void UseBinaryStandardStreams(void)
+{
+	/* Otherwise, Windows would translate line endings in the data. */
+#ifdef _WIN32
+	_setmode(_fileno(stdin), _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+}
+
+static char* ReadWholeFile(const char* const file_path, size_t* const size)
+{
+	/* Returns the contents of the file with a terminator added, or NULL on error. */
+	/* The size does not include the terminator, and can be NULL. */
+	char *contents;
+	FILE* const file = fopen(file_path, "rb");
+	long file_size;
+
+	contents = NULL;
+
+	if (file != NULL)
+	{
+		if (fseek(file, 0, SEEK_END) == 0 && (file_size = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0)
+		{
+			contents = (char*)malloc((size_t)file_size + 1);
+
+			if (contents != NULL)
+			{
+				if (fread(contents, 1, (size_t)file_size, file) == (size_t)file_size)
+				{
+					contents[file_size] = '\0';
+
+					if (size != NULL)
+						*size = (size_t)file_size;
+				}
+				else
+				{
+					free(contents);
+					contents = NULL;
+				}
+			}
+		}
+
+		fclose(file);
+	}
+
+	return contents;
+}
+
+typedef struct InputFile
+{
+	/* The bytes are not writable if the file is mapped. */
+	MemoryBuffer buffer;
+	cc_bool mapped;
+} InputFile;
+
+static cc_bool OpenInputFile(const char* const file_path, InputFile* const file)
+{
+	/* Maps the file into memory, so that it can be read as many times as the compressor needs without copying it. */
+	/* If it cannot be mapped, such as when it is empty or not a regular file, it is read instead. */
+	/* Standard input is always read, as it can be neither mapped nor rewound. */
+	file->buffer.position = 0;
+	file->mapped = cc_false;
+
+	if (IsStandardStream(file_path))
+	{
+		if (ReadStream(stdin, &file->buffer))
+			return cc_true;
+
+		free(file->buffer.bytes);
+		return cc_false;
+	}
+
+#if defined(CLOWNNEMESIS_MAPPED_FILES) && defined(_WIN32)
+	{
+		const HANDLE handle = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+		if (handle != INVALID_HANDLE_VALUE)
+		{
+			LARGE_INTEGER size;
+
+			if (GetFileSizeEx(handle, &size) && size.QuadPart > 0 && (LONGLONG)(size_t)size.QuadPart == size.QuadPart)
+			{
+				const HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+				if (mapping != NULL)
+				{
+					/* The view keeps the mapping open by itself. */
+					file->buffer.bytes = (unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+					file->buffer.size = file->buffer.capacity = (size_t)size.QuadPart;
+					file->mapped = file->buffer.bytes != NULL;
+					CloseHandle(mapping);
+				}
+			}
+
+			CloseHandle(handle);
+		}
+	}
+#elif defined(CLOWNNEMESIS_MAPPED_FILES)
+	{
+		const int descriptor = open(file_path, O_RDONLY);
+
+		if (descriptor != -1)
+		{
+			struct stat status;
+
+			if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0 && (off_t)(size_t)status.st_size == status.st_size)
+			{
+				/* The mapping stays valid after the file is closed. */
+				void* const bytes = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+				if (bytes != MAP_FAILED)
+				{
+					file->buffer.bytes = (unsigned char*)bytes;
+					file->buffer.size = file->buffer.capacity = (size_t)status.st_size;
+					file->mapped = cc_true;
+				}
+			}
+
+			close(descriptor);
+		}
+	}
+#endif
+
+	if (!file->mapped)
+	{
+		file->buffer.bytes = (unsigned char*)ReadWholeFile(file_path, &file->buffer.size);
+		file->buffer.capacity = file->buffer.size;
+	}
+
+	return file->buffer.bytes != NULL;
+}
+
+static void CloseInputFile(InputFile* const file)
+{
+#if defined(CLOWNNEMESIS_MAPPED_FILES) && defined(_WIN32)
+	if (file->mapped)
+		UnmapViewOfFile(file->buffer.bytes);
+	else
+#elif defined(CLOWNNEMESIS_MAPPED_FILES)
+	if (file->mapped)
+		munmap(file->buffer.bytes, file->buffer.size);
+	else
+#endif
+		free(file->buffer.bytes);
+}
+
+/* The most temporary files for one file that can be left behind before no more can be made. */
+#define MAXIMUM_TEMPORARY_FILE_ATTEMPTS 100
+
+static FILE* OpenTemporaryFile(const char* const path, const cc_bool binary, char** const temporary_path)
+{
+	/* Makes a new file next to the given one, to replace it with. Other threads and processes can be writing the */
+	/* same file at once, such as batch workers or workers which share a cache, so the name has the process's ID in */
+	/* it, and the file is only opened if it did not exist yet. If it did, the next name is tried instead. */
+	FILE *file;
+	unsigned int attempt;
+	unsigned long process_id;
+
+	*temporary_path = (char*)malloc(strlen(path) + sizeof(".4294967295-99.tmp"));
+
+	if (*temporary_path == NULL)
+		return NULL;
+
+#ifdef _WIN32
+	process_id = GetCurrentProcessId();
+#elif defined(CLOWNNEMESIS_HAVE_GETPID)
+	process_id = (unsigned long)getpid();
+#else
+	process_id = 0;
+#endif
+
+	file = NULL;
+
+	for (attempt = 0; file == NULL && attempt < MAXIMUM_TEMPORARY_FILE_ATTEMPTS; ++attempt)
+	{
+#if defined(_WIN32) || defined(CLOWNNEMESIS_HAVE_GETPID)
+		int descriptor;
+#endif
+
+		sprintf(*temporary_path, "%s.%lu-%u.tmp", path, process_id & 0xFFFFFFFF, attempt);
+
+#ifdef _WIN32
+		descriptor = _open(*temporary_path, _O_WRONLY | _O_CREAT | _O_EXCL | (binary ? _O_BINARY : _O_TEXT), _S_IREAD | _S_IWRITE);
+
+		if (descriptor != -1)
+		{
+			file = _fdopen(descriptor, binary ? "wb" : "w");
+
+			if (file == NULL)
+				_close(descriptor);
+		}
+#elif defined(CLOWNNEMESIS_HAVE_GETPID)
+		descriptor = open(*temporary_path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+
+		if (descriptor != -1)
+		{
+			file = fdopen(descriptor, binary ? "wb" : "w");
+
+			if (file == NULL)
+				close(descriptor);
+		}
+#else
+		/* Without a way to create a file only if it does not exist, this can race with other processes. */
+		file = fopen(*temporary_path, "rb");
+
+		if (file != NULL)
+		{
+			fclose(file);
+			file = NULL;
+		}
+		else
+		{
+			file = fopen(*temporary_path, binary ? "wb" : "w");
+
+			/* If the file could not be made at all, then another name will not help. */
+			if (file == NULL)
+				break;
+		}
+#endif
+	}
+
+	if (file == NULL)
+	{
+		free(*temporary_path);
+		*temporary_path = NULL;
+	}
+
+	return file;
+}
+
+#undef MAXIMUM_TEMPORARY_FILE_ATTEMPTS
+
+static cc_bool ReplaceFile(const char* const temporary_path, const char* const path)
+{
+	/* The file is replaced in one step, so that it is never missing or incomplete. If that fails, the temporary file */
+	/* is removed, and the file is left as it was. */
+	cc_bool success;
+
+#ifdef _WIN32
+	/* 'rename' fails on Windows if the file already exists. */
+	success = MoveFileExA(temporary_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	success = rename(temporary_path, path) == 0;
+#endif
+
+	if (!success)
+		remove(temporary_path);
+
+	return success;
+}
+
+static cc_bool IsReplaceableFile(const char* const file_path)
+{
+	/* Only a regular file, or a file which does not exist yet, can be replaced by another file. */
+	/* Replacing a symbolic link or a device, such as '/dev/null', would turn it into a regular file. */
+#ifdef _WIN32
+	const DWORD attributes = GetFileAttributesA(file_path);
+
+	return attributes == INVALID_FILE_ATTRIBUTES || (attributes & (FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_DEVICE)) == 0;
+#elif defined(CLOWNNEMESIS_HAVE_LSTAT)
+	struct stat status;
+
+	return lstat(file_path, &status) != 0 || S_ISREG(status.st_mode);
+#else
+	(void)file_path;
+
+	return cc_true;
+#endif
+}
+
+static cc_bool WriteAndCloseFile(FILE* const file, const unsigned char* const header, const size_t header_size, const unsigned char* const bytes, const size_t size)
+{
+	cc_bool success;
+
+	success = (header_size == 0 || fwrite(header, 1, header_size, file) == header_size) && (size == 0 || fwrite(bytes, 1, size, file) == size);
+
+	if (fclose(file) != 0)
+		success = cc_false;
+
+	return success;
+}
+
+static cc_bool WriteWholeFile(const char* const file_path, const unsigned char* const header, const size_t header_size, const unsigned char* const bytes, const size_t size)
+{
+	/* The file is written to a temporary file which replaces it once it is complete, */
+	/* so that a failed or interrupted write never leaves a partial file behind. */
+	/* Links and devices cannot be replaced, so they are written to directly instead. */
+	cc_bool success;
+	char *temporary_path;
+	FILE *file;
+
+	if (!IsReplaceableFile(file_path))
+	{
+		file = fopen(file_path, "wb");
+
+		return file != NULL && WriteAndCloseFile(file, header, header_size, bytes, size);
+	}
+
+	file = OpenTemporaryFile(file_path, cc_true, &temporary_path);
+	success = cc_false;
+
+	if (file != NULL)
+	{
+		success = WriteAndCloseFile(file, header, header_size, bytes, size);
+
+		if (!success)
+			remove(temporary_path);
+		else
+			success = ReplaceFile(temporary_path, file_path);
+
+		free(temporary_path);
+	}
+
+	return success;
+}
+
+static int CountingOutputCallback(void* const user_data, const unsigned char byte)
+{
+	++*(unsigned long*)user_data;
+
+	return byte;
+}
+
+static cc_bool ReadCodeTable(const char* const file_path, ClownNemesis_CodeTable* const table)
+{
+	/* The file is the XOR mode flag, followed by the code length of each nybble run. */
+	cc_bool success;
+	FILE* const file = fopen(file_path, "rb");
+
+	success = cc_false;
+
+	if (file != NULL)
+	{
+		const int xor_mode_enabled = fgetc(file);
+
+		if (xor_mode_enabled != EOF && fread(table->code_lengths, sizeof(table->code_lengths), 1, file) == 1)
+		{
+			table->xor_mode_enabled = xor_mode_enabled;
+			success = cc_true;
+		}
+
+		fclose(file);
+	}
+
+	return success;
+}
+
+static cc_bool WriteCodeTable(const char* const file_path, const ClownNemesis_CodeTable* const table)
+{
+	cc_bool success;
+	FILE* const file = fopen(file_path, "wb");
+
+	success = cc_false;
+
+	if (file != NULL)
+	{
+		success = fputc(table->xor_mode_enabled != 0, file) != EOF && fwrite(table->code_lengths, sizeof(table->code_lengths), 1, file) == 1;
+
+		if (fclose(file) != 0)
+			success = cc_false;
+	}
+
+	return success;
+}
+
+static int TrainCodeTable(const char* const table_path, char** const input_paths, const int total_input_paths)
+{
+	int exit_code;
+	ClownNemesis_TrainingHistogram histogram;
+	ClownNemesis_CodeTable table;
+	ClownNemesis_Compressor *compressor;
+	unsigned long total_shared_size, total_own_size;
+	int i;
+
+	exit_code = EXIT_FAILURE;
+
+	ClownNemesis_TrainingHistogramInitialise(&histogram);
+
+	for (i = 0; i < total_input_paths; ++i)
+	{
+		FILE* const input_file = fopen(input_paths[i], "rb");
+
+		if (input_file == NULL)
+		{
+			fprintf(stderr, "Error: Could not open input file '%s' for reading.\n", input_paths[i]);
+			return exit_code;
+		}
+		else
+		{
+			const int success = ClownNemesis_TrainingHistogramAdd(&histogram, InputCallback, input_file);
+
+			fclose(input_file);
+
+			if (!success)
+			{
+				fprintf(stderr, "Error: Could not read input file '%s'.\n", input_paths[i]);
+				return exit_code;
+			}
+		}
+	}
+
+	ClownNemesis_TrainCodeTable(&table, &histogram);
+
+	if (!WriteCodeTable(table_path, &table))
+	{
+		fputs("Error: Could not write code table file.\n", stderr);
+		return exit_code;
+	}
+
+	compressor = ClownNemesis_CompressorCreate();
+
+	if (compressor == NULL)
+	{
+		fputs("Error: Could not create compressor.\n", stderr);
+		return exit_code;
+	}
+
+	/* Compare the shared table against each file's own table, so that the cost of using it can be judged. */
+	exit_code = EXIT_SUCCESS;
+	total_shared_size = total_own_size = 0;
+
+	for (i = 0; i < total_input_paths; ++i)
+	{
+		InputFile input;
+
+		if (!OpenInputFile(input_paths[i], &input))
+		{
+			fprintf(stderr, "Error: Could not read input file '%s'.\n", input_paths[i]);
+			exit_code = EXIT_FAILURE;
+		}
+		else
+		{
+			ClownNemesis_CompressOptions options;
+			unsigned long shared_size, own_size;
+
+			ClownNemesis_DefaultCompressOptions(&options);
+			shared_size = own_size = 0;
+
+			if (!ClownNemesis_CompressorCompressWithTable(compressor, &table, MemoryInputCallback, &input.buffer, CountingOutputCallback, &shared_size)
+			 || !ClownNemesis_CompressorCompress(compressor, &options, MemoryInputCallback, &input.buffer, CountingOutputCallback, &own_size))
+			{
+				fprintf(stderr, "Error: Could not compress input file '%s'.\n", input_paths[i]);
+				exit_code = EXIT_FAILURE;
+			}
+			else
+			{
+				fprintf(stdout, "%s: %lu bytes with the shared table, %lu bytes with its own table (%+ld).\n", input_paths[i], shared_size, own_size, (long)shared_size - (long)own_size);
+
+				total_shared_size += shared_size;
+				total_own_size += own_size;
+			}
+
+			CloseInputFile(&input);
+		}
+	}
+
+	fprintf(stdout, "Total: %lu bytes with the shared table, %lu bytes with their own tables (%+ld).\n", total_shared_size, total_own_size, (long)total_shared_size - (long)total_own_size);
+
+	ClownNemesis_CompressorDestroy(compressor);
+
+	return exit_code;
+}
+
+static int EstimateCompressedSizes(const char* const input_path)
+{
+	int exit_code;
+	InputFile input;
+
+	exit_code = EXIT_FAILURE;
+
+	if (!OpenInputFile(input_path, &input))
+	{
+		fputs("Error: Could not read input file.\n", stderr);
+	}
+	else
+	{
+		ClownNemesis_CompressOptions options;
+		unsigned long size;
+
+		ClownNemesis_DefaultCompressOptions(&options);
+		options.accurate = cc_true;
+		size = ClownNemesis_EstimateCompressedSize(&options, MemoryInputCallback, &input.buffer);
+
+		if (size == 0)
+		{
+			fputs("Error: Could not measure data.\nThe input data is either too large or its size is not a multiple of 0x20 bytes.\n", stderr);
+		}
+		else
+		{
+			fprintf(stdout, "-ca: %lu bytes\n", size);
+
+			options.accurate = cc_false;
+
+			for (options.effort = CLOWNNEMESIS_EFFORT_FASTEST; options.effort <= CLOWNNEMESIS_EFFORT_EXHAUSTIVE; ++options.effort)
+				fprintf(stdout, "-c%d: %lu bytes\n", options.effort, ClownNemesis_EstimateCompressedSize(&options, MemoryInputCallback, &input.buffer));
+
+			fprintf(stdout, "Sampled approximation: %lu bytes\n", ClownNemesis_EstimateCompressedSizeSampled(MemoryInputCallback, &input.buffer));
+
+			exit_code = EXIT_SUCCESS;
+		}
+
+		CloseInputFile(&input);
+	}
+
+	return exit_code;
+}
+
+static int EstimateDecodeTimes(char** const input_paths, const int total_input_paths)
+{
+	int exit_code;
+	int i;
+
+	exit_code = EXIT_SUCCESS;
+
+	for (i = 0; i < total_input_paths; ++i)
+	{
+		FILE* const input_file = fopen(input_paths[i], "rb");
+
+		if (input_file == NULL)
+		{
+			fprintf(stderr, "Error: Could not open input file '%s' for reading.\n", input_paths[i]);
+			exit_code = EXIT_FAILURE;
+		}
+		else
+		{
+			const unsigned long cycles = ClownNemesis_EstimateDecodeCycles(InputCallback, input_file);
+
+			if (cycles == 0)
+			{
+				fprintf(stderr, "Error: '%s' is not valid Nemesis data.\n", input_paths[i]);
+				exit_code = EXIT_FAILURE;
+			}
+			else
+			{
+				/* A 60Hz frame is 127841 cycles of the Mega Drive's 68000. */
+				fprintf(stdout, "%s: %lu cycles (%lu.%02lu frames)\n", input_paths[i], cycles, cycles / 127841, cycles % 127841 * 100 / 127841);
+			}
+
+			fclose(input_file);
+		}
+	}
+
+	return exit_code;
+}
+
+typedef struct TileRange
+{
+	FILE *file;
+	unsigned long start, position, end;
+} TileRange;
+
+static int TileRangeInputCallback(void* const user_data)
+{
+	TileRange* const range = (TileRange*)user_data;
+	int character;
+
+	if (range->position == range->end)
+	{
+		/* Rewind to the start of the range, like 'InputCallback' does for a whole file. */
+		if (fseek(range->file, (long)range->start, SEEK_SET) != 0)
+			return CLOWNNEMESIS_ERROR;
+
+		range->position = range->start;
+		return CLOWNNEMESIS_EOF;
+	}
+
+	character = fgetc(range->file);
+
+	if (character == EOF)
+		return CLOWNNEMESIS_ERROR;
+
+	++range->position;
+
+	return character;
+}
+
+static int CompressSplit(const char* const input_path, const char* const output_path)
+{
+	int exit_code;
+	FILE* const input_file = fopen(input_path, "rb");
+
+	exit_code = EXIT_FAILURE;
+
+	if (input_file == NULL)
+	{
+		fputs("Error: Could not open input file for reading.\n", stderr);
+	}
+	else
+	{
+		ClownNemesis_Segment segments[CLOWNNEMESIS_MAXIMUM_SEGMENTS];
+		const size_t total_segments = ClownNemesis_Split(segments, InputCallback, input_file);
+
+		if (total_segments == 0)
+		{
+			fputs("Error: Could not split data.\nThe input data is either too large or its size is not a multiple of 0x20 bytes.\n", stderr);
+		}
+		else
+		{
+			ClownNemesis_CompressOptions options;
+			size_t i;
+
+			ClownNemesis_DefaultCompressOptions(&options);
+			exit_code = EXIT_SUCCESS;
+
+			/* Each archive goes in its own file, with its index appended to the output path. */
+			for (i = 0; i < total_segments && exit_code == EXIT_SUCCESS; ++i)
+			{
+				char *segment_output_path;
+
+				exit_code = EXIT_FAILURE;
+				segment_output_path = (char*)malloc(strlen(output_path) + 1 + 20 + 1);
+
+				if (segment_output_path == NULL)
+				{
+					fputs("Error: Could not allocate memory.\n", stderr);
+				}
+				else
+				{
+					FILE *output_file;
+
+					sprintf(segment_output_path, "%s.%lu", output_path, (unsigned long)i);
+					output_file = fopen(segment_output_path, "wb");
+
+					if (output_file == NULL)
+					{
+						fprintf(stderr, "Error: Could not open output file '%s' for writing.\n", segment_output_path);
+					}
+					else
+					{
+						TileRange range;
+
+						range.file = input_file;
+						range.start = range.position = segments[i].first_tile * 0x20;
+						range.end = range.start + segments[i].total_tiles * 0x20;
+
+						if (fseek(input_file, (long)range.start, SEEK_SET) != 0 || !ClownNemesis_CompressWithOptions(&options, TileRangeInputCallback, &range, OutputCallback, output_file))
+						{
+							fputs("Error: Could not compress data.\n", stderr);
+						}
+						else
+						{
+							/* This listing tells the loader which tiles each archive holds. */
+							fprintf(stdout, "%s: tiles 0x%lX to 0x%lX\n", segment_output_path, segments[i].first_tile, segments[i].first_tile + segments[i].total_tiles);
+							exit_code = EXIT_SUCCESS;
+						}
+
+						fclose(output_file);
+					}
+
+					free(segment_output_path);
+				}
+			}
+		}
+
+		fclose(input_file);
+	}
+
+	return exit_code;
+}
+
+static int CompressBitmap(const char* const width_string, const char* const bits_per_pixel_string, const char* const input_path, const char* const output_path)
+{
+	int exit_code;
+	FILE* const input_file = fopen(input_path, "rb");
+
+	exit_code = EXIT_FAILURE;
+
+	if (input_file == NULL)
+	{
+		fputs("Error: Could not open input file for reading.\n", stderr);
+	}
+	else
+	{
+		ClownNemesis_Bitmap bitmap;
+		unsigned char *pixels;
+		long file_size;
+
+		bitmap.width = strtoul(width_string, NULL, 0);
+		bitmap.bits_per_pixel = (unsigned int)strtoul(bits_per_pixel_string, NULL, 0);
+		bitmap.stride = bitmap.width * bitmap.bits_per_pixel / 8;
+		bitmap.tile_order = CLOWNNEMESIS_TILE_ORDER_ROWS;
+
+		/* The bitmap has no header, so its height is however many rows fit in the file. */
+		if (fseek(input_file, 0, SEEK_END) != 0 || (file_size = ftell(input_file)) < 0 || fseek(input_file, 0, SEEK_SET) != 0)
+		{
+			fputs("Error: Could not measure input file.\n", stderr);
+		}
+		else if (bitmap.stride == 0 || (unsigned long)file_size % bitmap.stride != 0)
+		{
+			fputs("Error: Input file is not a whole number of rows of the given width.\n", stderr);
+		}
+		else if ((pixels = (unsigned char*)malloc(file_size == 0 ? 1 : (size_t)file_size)) == NULL)
+		{
+			fputs("Error: Could not allocate memory.\n", stderr);
+		}
+		else
+		{
+			ClownNemesis_BitmapReader reader;
+
+			bitmap.pixels = pixels;
+			bitmap.height = (unsigned long)file_size / bitmap.stride;
+
+			if (fread(pixels, 1, (size_t)file_size, input_file) != (size_t)file_size)
+			{
+				fputs("Error: Could not read input file.\n", stderr);
+			}
+			else if (!ClownNemesis_BitmapReaderInitialise(&reader, &bitmap))
+			{
+				fputs("Error: The width and height must be multiples of 8, and there must be 4 or 8 bits per pixel.\n", stderr);
+			}
+			else
+			{
+				FILE* const output_file = fopen(output_path, "wb");
+
+				if (output_file == NULL)
+				{
+					fputs("Error: Could not open output file for writing.\n", stderr);
+				}
+				else
+				{
+					if (!ClownNemesis_Compress(cc_false, ClownNemesis_ReadBitmap, &reader, OutputCallback, output_file))
+						fputs("Error: Could not compress data.\nThe bitmap is likely too large.\n", stderr);
+					else
+						exit_code = EXIT_SUCCESS;
+
+					fclose(output_file);
+				}
+			}
+
+			free(pixels);
+		}
+
+		fclose(input_file);
+	}
+
+	return exit_code;
+}
+
+typedef struct Mode
+{
+	cc_bool compress, recompress;
+	ClownNemesis_CompressOptions options;
+} Mode;
+
+static cc_bool ParseMode(const char* const option, Mode* const mode)
+{
+	/* Reads the options which compress or decompress a single input into a single output. */
+	mode->compress = mode->recompress = cc_false;
+	ClownNemesis_DefaultCompressOptions(&mode->options);
+
+	if (option[0] == '-' && option[1] == 'c' && option[2] == '\0')
+	{
+		mode->compress = cc_true;
+	}
+	else if (option[0] == '-' && option[1] == 'c' && option[2] == 'a' && option[3] == '\0')
+	{
+		mode->compress = cc_true;
+		mode->options.accurate = cc_true;
+	}
+	else if (option[0] == '-' && option[1] == 'c' && option[2] == 'u' && option[3] == '\0')
+	{
+		mode->compress = cc_true;
+		mode->options.effort = CLOWNNEMESIS_EFFORT_EXHAUSTIVE;
+	}
+	else if (option[0] == '-' && option[1] == 'c' && option[2] >= '0' && option[2] <= '0' + CLOWNNEMESIS_EFFORT_EXHAUSTIVE && option[3] == '\0')
+	{
+		mode->compress = cc_true;
+		mode->options.effort = option[2] - '0';
+	}
+	else if (option[0] == '-' && option[1] == 'c' && option[2] == 'f' && option[3] == '\0')
+	{
+		mode->compress = cc_true;
+		/* Past this, the data only gets bigger without decoding much faster. */
+		mode->options.decode_speed = 16;
+	}
+	else if (option[0] == '-' && option[1] == 'd' && option[2] == '\0')
+	{
+		mode->compress = cc_false;
+	}
+	else if (option[0] == '-' && option[1] == 'r' && option[2] == '\0')
+	{
+		mode->compress = cc_true;
+		mode->recompress = cc_true;
+	}
+	else
+	{
+		return cc_false;
+	}
+
+	return cc_true;
+}
+
+static const char* ModeErrorMessage(const Mode* const mode)
+{
+	if (mode->recompress)
+		return "Could not recompress data. The input data is not valid Nemesis data.";
+	else if (mode->compress)
+		return "Could not compress data.\nThe input data is either too large or its size is not a multiple of 0x20 bytes.";
+	else
+		return "Could not decompress data. The input data is not valid Nemesis data.";
+}
+
+/***********/
+/* Threads */
+/***********/
+
+/* Threads are optional, so that the tool is still plain C89 without them. When they are not available, */
+/* all of the work that would be shared between threads is done by the main thread instead. */
+
+#ifdef CLOWNNEMESIS_THREADS
+typedef struct Thread
+{
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+	void (*function)(void *user_data);
+	void *user_data;
+} Thread;
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE Condition;
+
+static DWORD WINAPI ThreadEntry(const LPVOID user_data)
+{
+	Thread* const thread = (Thread*)user_data;
+
+	thread->function(thread->user_data);
+	return 0;
+}
+#else
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+
+static void* ThreadEntry(void* const user_data)
+{
+	Thread* const thread = (Thread*)user_data;
+
+	thread->function(thread->user_data);
+	return NULL;
+}
+#endif
+
+static cc_bool StartThread(Thread* const thread, void (* const function)(void *user_data), void* const user_data)
+{
+	thread->function = function;
+	thread->user_data = user_data;
+
+#ifdef _WIN32
+	thread->handle = CreateThread(NULL, 0, ThreadEntry, thread, 0, NULL);
+	return thread->handle != NULL;
+#else
+	return pthread_create(&thread->handle, NULL, ThreadEntry, thread) == 0;
+#endif
+}
+
+static void JoinThread(Thread* const thread)
+{
+#ifdef _WIN32
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+#else
+	pthread_join(thread->handle, NULL);
+#endif
+}
+#else
+typedef int Mutex; /* Unused. */
+#endif
+
+static cc_bool InitialiseMutex(Mutex* const mutex)
+{
+#if !defined(CLOWNNEMESIS_THREADS)
+	(void)mutex;
+	return cc_true;
+#elif defined(_WIN32)
+	InitializeCriticalSection(mutex);
+	return cc_true;
+#else
+	return pthread_mutex_init(mutex, NULL) == 0;
+#endif
+}
+
+static void DeinitialiseMutex(Mutex* const mutex)
+{
+#if !defined(CLOWNNEMESIS_THREADS)
+	(void)mutex;
+#elif defined(_WIN32)
+	DeleteCriticalSection(mutex);
+#else
+	pthread_mutex_destroy(mutex);
+#endif
+}
+
+static void LockMutex(Mutex* const mutex)
+{
+#if !defined(CLOWNNEMESIS_THREADS)
+	(void)mutex;
+#elif defined(_WIN32)
+	EnterCriticalSection(mutex);
+#else
+	pthread_mutex_lock(mutex);
+#endif
+}
+
+static void UnlockMutex(Mutex* const mutex)
+{
+#if !defined(CLOWNNEMESIS_THREADS)
+	(void)mutex;
+#elif defined(_WIN32)
+	LeaveCriticalSection(mutex);
+#else
+	pthread_mutex_unlock(mutex);
+#endif
+}
+
+#ifdef CLOWNNEMESIS_THREADS
+static cc_bool InitialiseCondition(Condition* const condition)
+{
+#ifdef _WIN32
+	InitializeConditionVariable(condition);
+	return cc_true;
+#else
+	return pthread_cond_init(condition, NULL) == 0;
+#endif
+}
+
+static void DeinitialiseCondition(Condition* const condition)
+{
+#ifdef _WIN32
+	(void)condition;
+#else
+	pthread_cond_destroy(condition);
+#endif
+}
+
+static void WaitForCondition(Condition* const condition, Mutex* const mutex)
+{
+	/* The mutex must be locked, and is unlocked while waiting. */
+#ifdef _WIN32
+	SleepConditionVariableCS(condition, mutex, INFINITE);
+#else
+	pthread_cond_wait(condition, mutex);
+#endif
+}
+
+static void SignalCondition(Condition* const condition)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable(condition);
+#else
+	pthread_cond_broadcast(condition);
+#endif
+}
+#endif
+
+static unsigned int CountProcessors(void)
+{
+#if defined(CLOWNNEMESIS_THREADS) && defined(_WIN32)
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#elif defined(CLOWNNEMESIS_THREADS) && defined(_SC_NPROCESSORS_ONLN)
+	const long total_processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return total_processors < 1 ? 1 : (unsigned int)total_processors;
+#else
+	return 1;
+#endif
+}
+
+static double CurrentSeconds(void)
+{
+	/* With threads, the processor time of the whole process would count the time of every thread, so the real time is used. */
+#if defined(CLOWNNEMESIS_THREADS) && defined(_WIN32)
+	LARGE_INTEGER counter, frequency;
+
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / frequency.QuadPart;
+#elif defined(CLOWNNEMESIS_THREADS)
+	struct timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1000000000.0;
+#else
+	return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/******************/
+/* End of Threads */
+/******************/
+
+/*********/
+/* Cache */
+/*********/
+
+/* Rebuilds mostly compress data which has not changed, so the outputs can be kept in a directory and reused. */
+/* The cache is used when the 'CLOWNNEMESIS_CACHE' environment variable is the path of a directory, which must exist. */
+/* Each output is stored in a file named after a hash of the tool's version, the mode, and the input. The directory */
+/* also has an index of the size of each file and when it was last used, so that the least recently used files can */
+/* be removed once the cache is larger than the 'CLOWNNEMESIS_CACHE_SIZE' environment variable's number of bytes. */
+
+#define CACHE_DEFAULT_MAXIMUM_SIZE 0x4000000UL
+#define CACHE_NAME_LENGTH 16
+#define CACHE_INDEX_HEADER "clownnemesis cache index 1\n"
+/* The input's size and the output's size, as 4-byte big-endian numbers, are stored before the output. */
+#define CACHE_HEADER_SIZE 8
+
+typedef struct CacheEntry
+{
+	char name[CACHE_NAME_LENGTH + 1];
+	unsigned long size, last_used;
+} CacheEntry;
+
+typedef struct CacheIndex
+{
+	/* Sorted by name. */
+	CacheEntry *entries;
+	size_t total_entries, capacity;
+	unsigned long total_size, hits, misses;
+} CacheIndex;
+
+typedef struct Cache
+{
+	const char *directory;
+	unsigned long maximum_size;
+	CacheIndex index;
+	/* Only this run's, as other runs may save theirs to the index in the meantime. */
+	unsigned long hits, misses;
+	Mutex mutex;
+} Cache;
+
+static void HashCacheKey(unsigned long hashes[2], const unsigned char* const bytes, const size_t total_bytes)
+{
+	/* A CRC-32 and a 32-bit FNV-1a hash, which together make a 64-bit hash without needing a 64-bit type. */
+	size_t i;
+
+	hashes[0] = ClownNemesis_CRC32(hashes[0], bytes, total_bytes);
+
+	for (i = 0; i < total_bytes; ++i)
+		hashes[1] = ((hashes[1] ^ bytes[i]) * 0x01000193) & 0xFFFFFFFF;
+}
+
+static void MakeCacheName(const Mode* const mode, const MemoryBuffer* const input, char* const name)
+{
+	/* Everything which affects the output is hashed along with the input, including the version, as a newer version may compress differently. */
+	char key[0x40];
+	unsigned long hashes[2];
+
+	sprintf(key, "clownnemesis %s %d %d %d %d", VERSION, mode->recompress, mode->options.accurate, mode->options.effort, mode->options.decode_speed);
+
+	hashes[0] = 0;
+	hashes[1] = 0x811C9DC5;
+	HashCacheKey(hashes, (const unsigned char*)key, strlen(key) + 1);
+	HashCacheKey(hashes, input->bytes, input->size);
+
+	sprintf(name, "%08lx%08lx", hashes[0], hashes[1]);
+}
+
+static char* MakeCachePath(const Cache* const cache, const char* const file_name)
+{
+	char* const path = (char*)malloc(strlen(cache->directory) + 1 + strlen(file_name) + 1);
+
+	if (path != NULL)
+		sprintf(path, "%s/%s", cache->directory, file_name);
+
+	return path;
+}
+
+static CacheEntry* FindCacheEntry(CacheIndex* const index, const char* const name, const cc_bool create)
+{
+	/* Returns NULL if there is no entry with the name and one cannot be created. New entries have a size of 0. */
+	CacheEntry *entry;
+	size_t low, high;
+
+	low = 0;
+	high = index->total_entries;
+
+	while (low != high)
+	{
+		const size_t middle = low + (high - low) / 2;
+		const int comparison = strcmp(name, index->entries[middle].name);
+
+		if (comparison == 0)
+			return &index->entries[middle];
+		else if (comparison < 0)
+			high = middle;
+		else
+			low = middle + 1;
+	}
+
+	if (!create)
+		return NULL;
+
+	if (index->total_entries == index->capacity)
+	{
+		const size_t new_capacity = index->capacity == 0 ? 0x40 : index->capacity * 2;
+		CacheEntry* const new_entries = (CacheEntry*)realloc(index->entries, new_capacity * sizeof(CacheEntry));
+
+		if (new_entries == NULL)
+			return NULL;
+
+		index->entries = new_entries;
+		index->capacity = new_capacity;
+	}
+
+	entry = &index->entries[low];
+	memmove(entry + 1, entry, (index->total_entries - low) * sizeof(CacheEntry));
+	++index->total_entries;
+
+	strcpy(entry->name, name);
+	entry->size = entry->last_used = 0;
+
+	return entry;
+}
+
+static void SetCacheEntrySize(CacheIndex* const index, CacheEntry* const entry, const unsigned long size)
+{
+	index->total_size = index->total_size - entry->size + size;
+	entry->size = size;
+}
+
+static void RemoveCacheEntry(CacheIndex* const index, CacheEntry* const entry)
+{
+	index->total_size -= entry->size;
+	--index->total_entries;
+	memmove(entry, entry + 1, (size_t)(&index->entries[index->total_entries] - entry) * sizeof(CacheEntry));
+}
+
+static void ReadCacheIndex(const Cache* const cache, CacheIndex* const index)
+{
+	/* An index which is missing or cannot be read is treated as being empty, and entries which are not valid are skipped. */
+	char* const path = MakeCachePath(cache, "index");
+
+	index->entries = NULL;
+	index->total_entries = index->capacity = 0;
+	index->total_size = index->hits = index->misses = 0;
+
+	if (path != NULL)
+	{
+		FILE* const file = fopen(path, "r");
+
+		if (file != NULL)
+		{
+			char line[sizeof(CACHE_INDEX_HEADER)];
+
+			if (fgets(line, sizeof(line), file) != NULL && strcmp(line, CACHE_INDEX_HEADER) == 0 && fscanf(file, "%lu %lu", &index->hits, &index->misses) == 2)
+			{
+				char name[CACHE_NAME_LENGTH + 1];
+				unsigned long size, last_used;
+
+				while (fscanf(file, "%16s %lu %lu", name, &size, &last_used) == 3)
+				{
+					/* Only names that the tool makes are accepted, so that the index cannot refer to files outside of the directory. */
+					if (strlen(name) == CACHE_NAME_LENGTH && strspn(name, "0123456789abcdef") == CACHE_NAME_LENGTH)
+					{
+						CacheEntry* const entry = FindCacheEntry(index, name, cc_true);
+
+						if (entry != NULL)
+						{
+							SetCacheEntrySize(index, entry, size);
+							entry->last_used = last_used;
+						}
+					}
+				}
+			}
+
+			fclose(file);
+		}
+
+		free(path);
+	}
+}
+
+static cc_bool WriteCacheIndex(const Cache* const cache)
+{
+	cc_bool success;
+	char* const path = MakeCachePath(cache, "index");
+	char *temporary_path;
+
+	success = cc_false;
+	temporary_path = NULL;
+
+	if (path != NULL)
+	{
+		FILE* const file = OpenTemporaryFile(path, cc_false, &temporary_path);
+
+		if (file != NULL)
+		{
+			size_t i;
+
+			fputs(CACHE_INDEX_HEADER, file);
+			fprintf(file, "%lu %lu\n", cache->index.hits, cache->index.misses);
+
+			for (i = 0; i < cache->index.total_entries; ++i)
+				fprintf(file, "%s %lu %lu\n", cache->index.entries[i].name, cache->index.entries[i].size, cache->index.entries[i].last_used);
+
+			success = !ferror(file);
+
+			if (fclose(file) != 0)
+				success = cc_false;
+
+			if (!success)
+				remove(temporary_path);
+			else
+				success = ReplaceFile(temporary_path, path);
+		}
+	}
+
+	free(path);
+	free(temporary_path);
+
+	return success;
+}
+
+static void EvictCacheEntries(Cache* const cache)
+{
+	/* Removes the least recently used files until the cache is no larger than its maximum size. */
+	while (cache->index.total_size > cache->maximum_size && cache->index.total_entries != 0)
+	{
+		CacheEntry *oldest;
+		char *path;
+		size_t i;
+
+		oldest = &cache->index.entries[0];
+
+		for (i = 1; i < cache->index.total_entries; ++i)
+			if (cache->index.entries[i].last_used < oldest->last_used)
+				oldest = &cache->index.entries[i];
+
+		path = MakeCachePath(cache, oldest->name);
+
+		if (path != NULL)
+		{
+			remove(path);
+			free(path);
+		}
+
+		RemoveCacheEntry(&cache->index, oldest);
+	}
+}
+
+static cc_bool OpenCache(Cache* const cache)
+{
+	/* Returns cc_false if the cache is not being used. */
+	const char* const maximum_size = getenv("CLOWNNEMESIS_CACHE_SIZE");
+
+	cache->directory = getenv("CLOWNNEMESIS_CACHE");
+
+	if (cache->directory == NULL || cache->directory[0] == '\0')
+		return cc_false;
+
+	if (!InitialiseMutex(&cache->mutex))
+	{
+		fputs("Warning: Could not create mutex, so the cache will not be used.\n", stderr);
+		return cc_false;
+	}
+
+	cache->maximum_size = maximum_size != NULL && maximum_size[0] != '\0' ? strtoul(maximum_size, NULL, 0) : CACHE_DEFAULT_MAXIMUM_SIZE;
+	cache->hits = cache->misses = 0;
+	ReadCacheIndex(cache, &cache->index);
+
+	return cc_true;
+}
+
+static void CloseCache(Cache* const cache)
+{
+	/* Other runs of the tool may have used the cache since it was opened, so their index is merged with this run's before it is saved. */
+	CacheIndex saved_index;
+	size_t i;
+
+	ReadCacheIndex(cache, &saved_index);
+
+	for (i = 0; i < saved_index.total_entries; ++i)
+	{
+		const CacheEntry* const saved_entry = &saved_index.entries[i];
+		CacheEntry *entry;
+
+		entry = FindCacheEntry(&cache->index, saved_entry->name, cc_false);
+
+		if (entry == NULL)
+		{
+			/* This run may have removed the entry's file to make space, in which case it is not added back. */
+			char* const path = MakeCachePath(cache, saved_entry->name);
+			FILE* const file = path == NULL ? NULL : fopen(path, "rb");
+
+			free(path);
+
+			if (file != NULL)
+			{
+				fclose(file);
+				entry = FindCacheEntry(&cache->index, saved_entry->name, cc_true);
+
+				if (entry != NULL)
+					SetCacheEntrySize(&cache->index, entry, saved_entry->size);
+			}
+		}
+
+		if (entry != NULL)
+			entry->last_used = CC_MAX(entry->last_used, saved_entry->last_used);
+	}
+
+	cache->index.hits = saved_index.hits + cache->hits;
+	cache->index.misses = saved_index.misses + cache->misses;
+	free(saved_index.entries);
+
+	EvictCacheEntries(cache);
+
+	if (!WriteCacheIndex(cache))
+		fputs("Warning: Could not write the cache's index.\n", stderr);
+
+	free(cache->index.entries);
+	DeinitialiseMutex(&cache->mutex);
+}
+
+static cc_bool LookUpCache(Cache* const cache, const char* const name, const MemoryBuffer* const input, MemoryBuffer* const output)
+{
+	CacheEntry *entry;
+	char* const path = MakeCachePath(cache, name);
+	unsigned char *bytes;
+	size_t size;
+	cc_bool hit;
+
+	bytes = path == NULL ? NULL : (unsigned char*)ReadWholeFile(path, &size);
+	hit = cc_false;
+	free(path);
+
+	if (bytes != NULL)
+	{
+		/* The sizes catch files which were cut short, such as by another run of the tool which was still writing them. */
+		if (size >= CACHE_HEADER_SIZE
+		 && ((unsigned long)bytes[0] << 24 | (unsigned long)bytes[1] << 16 | (unsigned long)bytes[2] << 8 | bytes[3]) == input->size
+		 && ((unsigned long)bytes[4] << 24 | (unsigned long)bytes[5] << 16 | (unsigned long)bytes[6] << 8 | bytes[7]) == size - CACHE_HEADER_SIZE)
+		{
+			memmove(bytes, bytes + CACHE_HEADER_SIZE, size - CACHE_HEADER_SIZE);
+			output->bytes = bytes;
+			output->size = output->capacity = size - CACHE_HEADER_SIZE;
+			hit = cc_true;
+		}
+		else
+		{
+			free(bytes);
+		}
+	}
+
+	LockMutex(&cache->mutex);
+
+	/* A file which is missing from the index, such as one which was written by a run that did not finish, is added to it. */
+	entry = FindCacheEntry(&cache->index, name, hit);
+
+	if (hit)
+	{
+		++cache->hits;
+
+		if (entry != NULL)
+		{
+			SetCacheEntrySize(&cache->index, entry, (unsigned long)size);
+			entry->last_used = (unsigned long)time(NULL);
+		}
+	}
+	else
+	{
+		++cache->misses;
+
+		/* Another run of the tool may have removed the file. */
+		if (entry != NULL)
+			RemoveCacheEntry(&cache->index, entry);
+	}
+
+	UnlockMutex(&cache->mutex);
+
+	return hit;
+}
+
+static void StoreInCache(Cache* const cache, const char* const name, const MemoryBuffer* const input, const MemoryBuffer* const output)
+{
+	/* Failing to store an output is not an error, as it only means that it will have to be compressed again next time. */
+	char* const path = MakeCachePath(cache, name);
+	unsigned char header[CACHE_HEADER_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < 4; ++i)
+	{
+		header[i] = (unsigned char)(((unsigned long)input->size >> (24 - i * 8)) & 0xFF);
+		header[4 + i] = (unsigned char)(((unsigned long)output->size >> (24 - i * 8)) & 0xFF);
+	}
+
+	if (path != NULL && WriteWholeFile(path, header, sizeof(header), output->bytes, output->size))
+	{
+		CacheEntry *entry;
+
+		LockMutex(&cache->mutex);
+
+		entry = FindCacheEntry(&cache->index, name, cc_true);
+
+		if (entry != NULL)
+		{
+			SetCacheEntrySize(&cache->index, entry, (unsigned long)(sizeof(header) + output->size));
+			entry->last_used = (unsigned long)time(NULL);
+		}
+
+		EvictCacheEntries(cache);
+
+		UnlockMutex(&cache->mutex);
+	}
+
+	free(path);
+}
+
+/* Inputs smaller than this are counted and emitted by one thread, as starting the others would take longer than that. */
+#define THREADED_HISTOGRAM_MINIMUM_SIZE 0x10000
+#define MAXIMUM_HISTOGRAM_PARTS 16
+#define MAXIMUM_CHUNKS 16
+
+#ifdef CLOWNNEMESIS_THREADS
+typedef struct SeedJob
+{
+	const ClownNemesis_CompressOptions *options;
+	MemoryBuffer input;
+	unsigned int seed;
+	ClownNemesis_RefinedSeed refined_seed;
+	Thread thread;
+	cc_bool started, success;
+} SeedJob;
+
+typedef struct HistogramJob
+{
+	MemoryBuffer input;
+	const unsigned char *previous_row;
+	ClownNemesis_PartialHistogram partial;
+	Thread thread;
+	cc_bool started, success;
+} HistogramJob;
+
+typedef struct ChunkJob
+{
+	const ClownNemesis_ChunkCodes *codes;
+	const unsigned char *tiles;
+	unsigned long first_tile, end_tile;
+	ClownNemesis_Chunk chunk;
+	Thread thread;
+	cc_bool started, success;
+} ChunkJob;
+
+static void RefineSeedJob(void* const user_data)
+{
+	SeedJob* const job = (SeedJob*)user_data;
+	ClownNemesis_Compressor* const compressor = ClownNemesis_CompressorCreate();
+
+	job->success = compressor != NULL && ClownNemesis_CompressorRefineSeed(compressor, job->options, job->seed, MemoryInputCallback, &job->input, &job->refined_seed);
+
+	if (compressor != NULL)
+		ClownNemesis_CompressorDestroy(compressor);
+}
+
+static void CountHistogramJob(void* const user_data)
+{
+	HistogramJob* const job = (HistogramJob*)user_data;
+
+	job->success = ClownNemesis_PartialHistogramCount(&job->partial, job->previous_row, MemoryInputCallback, &job->input);
+}
+
+static void EmitChunkJob(void* const user_data)
+{
+	/* 'ClownNemesis_CompressorEmitChunk' uses the compressor's state, so each chunk needs a compressor of its own. */
+	ChunkJob* const job = (ChunkJob*)user_data;
+	ClownNemesis_Compressor* const compressor = ClownNemesis_CompressorCreate();
+
+	job->success = compressor != NULL && ClownNemesis_CompressorEmitChunk(compressor, job->codes, job->tiles, job->first_tile, job->end_tile, &job->chunk);
+
+	if (compressor != NULL)
+		ClownNemesis_CompressorDestroy(compressor);
+}
+
+static int RefineSeedsOnThreads(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const unsigned int total_seeds, MemoryBuffer* const input, MemoryBuffer* const output)
+{
+	/* The seeds of the slowest effort levels are refined on their own threads, each with its own compressor and */
+	/* view of the input. They are reduced in the order that they are numbered, so the output is the same for any */
+	/* number of threads. */
+	SeedJob jobs[8];
+	unsigned int i;
+	cc_bool success;
+
+	if (total_seeds > CC_COUNT_OF(jobs))
+		return ClownNemesis_CompressorCompress(compressor, options, MemoryInputCallback, input, MemoryOutputCallback, output);
+
+	for (i = 0; i < total_seeds; ++i)
+	{
+		SeedJob* const job = &jobs[i];
+
+		job->options = options;
+		job->input = *input;
+		job->input.position = 0;
+		job->seed = i;
+		job->started = StartThread(&job->thread, RefineSeedJob, job);
+
+		/* Without a thread, the seed is refined by this one instead. */
+		if (!job->started)
+			RefineSeedJob(job);
+	}
+
+	success = cc_true;
+
+	for (i = 0; i < total_seeds; ++i)
+	{
+		if (jobs[i].started)
+			JoinThread(&jobs[i].thread);
+
+		success &= jobs[i].success;
+
+		if (i != 0)
+			ClownNemesis_ReduceRefinedSeeds(&jobs[0].refined_seed, &jobs[i].refined_seed);
+	}
+
+	if (!success)
+		return 0;
+
+	return ClownNemesis_CompressorCompressWithRefinedSeed(compressor, options, &jobs[0].refined_seed, MemoryInputCallback, input, MemoryOutputCallback, output);
+}
+
+static cc_bool CountHistogramOnThreads(const unsigned int total_threads, const MemoryBuffer* const input, ClownNemesis_TrainingHistogram* const histogram)
+{
+	/* The input is split into a part for each thread, which are counted at once, and then merged in order into */
+	/* exactly the histogram that counting the whole input would make. */
+	HistogramJob jobs[MAXIMUM_HISTOGRAM_PARTS];
+	unsigned int i;
+	cc_bool success;
+
+	const unsigned int total_parts = CC_MIN(total_threads, CC_COUNT_OF(jobs));
+	const size_t total_rows = input->size / 4;
+
+	for (i = 0; i < total_parts; ++i)
+	{
+		HistogramJob* const job = &jobs[i];
+		const size_t start = total_rows * i / total_parts * 4;
+		const size_t end = total_rows * (i + 1) / total_parts * 4;
+
+		job->input.bytes = &input->bytes[start];
+		job->input.size = job->input.capacity = end - start;
+		job->input.position = 0;
+		job->previous_row = i == 0 ? NULL : &input->bytes[start - 4];
+		job->started = StartThread(&job->thread, CountHistogramJob, job);
+
+		if (!job->started)
+			CountHistogramJob(job);
+	}
+
+	success = cc_true;
+
+	for (i = 0; i < total_parts; ++i)
+	{
+		if (jobs[i].started)
+			JoinThread(&jobs[i].thread);
+
+		success &= jobs[i].success;
+
+		if (i != 0)
+			ClownNemesis_PartialHistogramMerge(&jobs[0].partial, &jobs[i].partial);
+	}
+
+	if (!success)
+		return cc_false;
+
+	ClownNemesis_TrainingHistogramInitialise(histogram);
+	ClownNemesis_TrainingHistogramAddPartial(histogram, &jobs[0].partial);
+
+	return cc_true;
+}
+
+static int EmitChunksOnThreads(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const ClownNemesis_TrainingHistogram* const histogram, const unsigned int total_threads, MemoryBuffer* const input, MemoryBuffer* const output)
+{
+	/* The codes are made once, and then the tiles are split into a chunk for each thread, which are emitted at once, */
+	/* and then joined into exactly the data that emitting all of the tiles at once would make. */
+	ChunkJob jobs[MAXIMUM_CHUNKS];
+	ClownNemesis_ChunkCodes codes;
+	const unsigned char* const tiles = input->bytes;
+	unsigned int i;
+	int success;
+
+	const unsigned int total_chunks = CC_MIN(total_threads, CC_COUNT_OF(jobs));
+	const unsigned long total_tiles = (unsigned long)(input->size / 0x20);
+
+	if (histogram != NULL)
+		success = ClownNemesis_CompressorComputeChunkCodesWithHistogram(compressor, options, histogram, tiles, total_tiles, &codes);
+	else
+		success = ClownNemesis_CompressorComputeChunkCodes(compressor, options, tiles, total_tiles, &codes);
+
+	if (!success)
+		return 0;
+
+	for (i = 0; i < total_chunks; ++i)
+	{
+		ChunkJob* const job = &jobs[i];
+
+		job->codes = &codes;
+		job->tiles = tiles;
+		job->first_tile = total_tiles * i / total_chunks;
+		job->end_tile = total_tiles * (i + 1) / total_chunks;
+		job->chunk.bytes = NULL;
+		job->started = StartThread(&job->thread, EmitChunkJob, job);
+
+		if (!job->started)
+			EmitChunkJob(job);
+	}
+
+	success = 1;
+
+	for (i = 0; i < total_chunks; ++i)
+	{
+		if (jobs[i].started)
+			JoinThread(&jobs[i].thread);
+
+		success &= jobs[i].success;
+	}
+
+	if (success)
+	{
+		ClownNemesis_Chunk chunks[MAXIMUM_CHUNKS];
+
+		for (i = 0; i < total_chunks; ++i)
+			chunks[i] = jobs[i].chunk;
+
+		success = ClownNemesis_CompressorWriteChunks(compressor, &codes, chunks, total_chunks, MemoryOutputCallback, output);
+	}
+
+	for (i = 0; i < total_chunks; ++i)
+		if (jobs[i].success)
+			ClownNemesis_FreeChunk(&jobs[i].chunk);
+
+	return success;
+}
+
+#endif
+
+static int CompressOnThreads(ClownNemesis_Compressor* const compressor, const ClownNemesis_CompressOptions* const options, const unsigned int total_threads, MemoryBuffer* const input, MemoryBuffer* const output)
+{
+#ifdef CLOWNNEMESIS_THREADS
+	const unsigned int total_seeds = ClownNemesis_TotalSeeds(options);
+
+	if (total_threads > 1)
+	{
+		if (total_seeds > 1)
+			return RefineSeedsOnThreads(compressor, options, total_seeds, input, output);
+
+		if (input->size >= THREADED_HISTOGRAM_MINIMUM_SIZE && input->size % 4 == 0)
+		{
+			ClownNemesis_TrainingHistogram histogram;
+
+			/* The fastest effort level only counts a sample of the input, so it has no histogram to share. */
+			const cc_bool counted = options->accurate || options->effort > CLOWNNEMESIS_EFFORT_FASTEST;
+
+			if (counted && !CountHistogramOnThreads(total_threads, input, &histogram))
+				return 0;
+
+			/* Chunks can only be made of whole tiles, and of as many as fit in one header. */
+			if (input->size % 0x20 == 0 && input->size / 0x20 <= 0x7FFF)
+				return EmitChunksOnThreads(compressor, options, counted ? &histogram : NULL, total_threads, input, output);
+
+			if (counted)
+				return ClownNemesis_CompressorCompressWithHistogram(compressor, options, &histogram, MemoryInputCallback, input, MemoryOutputCallback, output);
+		}
+	}
+#else
+	(void)total_threads;
+#endif
+
+	return ClownNemesis_CompressorCompress(compressor, options, MemoryInputCallback, input, MemoryOutputCallback, output);
+}
+
+#undef MAXIMUM_CHUNKS
+#undef THREADED_HISTOGRAM_MINIMUM_SIZE
+#undef MAXIMUM_HISTOGRAM_PARTS
+
+static int RunMode(ClownNemesis_Compressor* const compressor, Cache* const cache, const Mode* const mode, const unsigned int total_threads, MemoryBuffer* const input, MemoryBuffer* const output, cc_bool* const cached)
+{
+	/* Returns the same as the library's functions. The cache is not used if it is NULL. */
+	/* Compression may use up to 'total_threads' threads of its own. */
+	/* Decompression is not cached, as it is about as quick as reading the cache. */
+	char name[CACHE_NAME_LENGTH + 1];
+	int success;
+
+	*cached = cc_false;
+
+	if (cache != NULL && mode->compress)
+	{
+		MakeCacheName(mode, input, name);
+
+		if (LookUpCache(cache, name, input, output))
+		{
+			*cached = cc_true;
+			return 1;
+		}
+	}
+
+	if (mode->recompress)
+		success = ClownNemesis_CompressorRecompress(compressor, &mode->options, MemoryInputCallback, input, MemoryOutputCallback, output);
+	else if (mode->compress)
+		success = CompressOnThreads(compressor, &mode->options, total_threads, input, output);
+	else
+		success = ClownNemesis_Decompress(MemoryInputCallback, input, MemoryOutputCallback, output);
+
+	if (success == 1 && cache != NULL && mode->compress)
+		StoreInCache(cache, name, input, output);
+
+	return success;
+}
+
+static const char* RunModeOnFile(ClownNemesis_Compressor* const compressor, Cache* const cache, const Mode* const mode, const char* const input_path, const char* const output_path, unsigned long* const output_size, cc_bool* const cached)
+{
+	/* Returns NULL on success, or an error message. */
+	/* The output is written all at once, as it is usually much smaller than the input. */
+	const char *error;
+	InputFile input;
+	MemoryBuffer output;
+
+	output.bytes = NULL;
+	output.size = output.capacity = output.position = 0;
+	*cached = cc_false;
+
+	if (!OpenInputFile(input_path, &input))
+		return "Could not read input file.";
+
+	if (compressor == NULL && mode->compress)
+		error = "Could not create compressor.";
+	else if (RunMode(compressor, cache, mode, CountProcessors(), &input.buffer, &output, cached) != 1)
+		error = ModeErrorMessage(mode);
+	else if (IsStandardStream(output_path) ? (output.size != 0 && fwrite(output.bytes, 1, output.size, stdout) != output.size) || fflush(stdout) == EOF : !WriteWholeFile(output_path, NULL, 0, output.bytes, output.size))
+		error = "Could not write output file.";
+	else
+		error = NULL;
+
+	if (error == NULL)
+		*output_size = (unsigned long)output.size;
+
+	CloseInputFile(&input);
+	free(output.bytes);
+
+	return error;
+}
+
+static int PrintCacheStatistics(void)
+{
+	Cache cache;
+
+	if (!OpenCache(&cache))
+	{
+		fputs("Error: The cache is not being used, as 'CLOWNNEMESIS_CACHE' is not set.\n", stderr);
+		return EXIT_FAILURE;
+	}
+
+	fprintf(stdout, "Directory: %s\n", cache.directory);
+	fprintf(stdout, "Files: %lu\n", (unsigned long)cache.index.total_entries);
+	fprintf(stdout, "Size: %lu of %lu bytes\n", cache.index.total_size, cache.maximum_size);
+	fprintf(stdout, "Hits: %lu\n", cache.index.hits);
+	fprintf(stdout, "Misses: %lu\n", cache.index.misses);
+
+	if (cache.index.hits + cache.index.misses != 0)
+		fprintf(stdout, "Hit rate: %.1f%%\n", cache.index.hits * 100.0 / (cache.index.hits + cache.index.misses));
+
+	free(cache.index.entries);
+	DeinitialiseMutex(&cache.mutex);
+
+	return EXIT_SUCCESS;
+}
+
+#undef CACHE_HEADER_SIZE
+#undef CACHE_NAME_LENGTH
+#undef CACHE_INDEX_HEADER
+#undef CACHE_DEFAULT_MAXIMUM_SIZE
+
+/****************/
+/* End of Cache */
+/****************/
+
+/*********/
+/* Batch */
+/*********/
+
+/* The most threads that a batch can compress with, and how many jobs can wait for each of them between the stages. */
+#define MAXIMUM_BATCH_WORKERS 64
+#define BATCH_JOBS_PER_WORKER 2
+
+typedef struct BatchJob
+{
+	Mode mode;
+	const char *input_path, *output_path;
+	unsigned long line, input_size, output_size;
+	/* How long the job took to compress, not counting reading and writing it. */
+	double seconds;
+	cc_bool cached;
+	/* NULL if the job succeeded. */
+	const char *error;
+	/* Passed from each stage to the next. */
+	InputFile input;
+	MemoryBuffer output;
+} BatchJob;
+
+#ifdef CLOWNNEMESIS_THREADS
+typedef struct BatchQueue
+{
+	/* A ring of jobs. Adding a job waits while it is full, and taking one waits while it is empty, until it is ended. */
+	BatchJob **jobs;
+	size_t first, total, capacity;
+	cc_bool ended;
+	Mutex mutex;
+	Condition changed;
+} BatchQueue;
+#endif
+
+typedef struct Batch
+{
+	BatchJob *jobs;
+	/* The jobs, largest first, so that a large job is not left until the end while the other workers sit idle. */
+	BatchJob **order;
+	size_t total_jobs;
+	/* NULL if the cache is not being used. */
+	Cache *cache;
+#ifdef CLOWNNEMESIS_THREADS
+	/* Jobs which have been read but not compressed, and jobs which have been compressed but not written. */
+	BatchQueue read_queue, write_queue;
+#endif
+} Batch;
+
+static char* ReadManifestField(char** const cursor)
+{
+	/* A field is either a run of characters without spaces, or is in double quotes so that it can contain spaces. */
+	char *field, *end;
+
+	field = *cursor;
+
+	while (*field == ' ' || *field == '\t')
+		++field;
+
+	if (*field == '\0')
+		return NULL;
+
+	if (*field == '"')
+	{
+		end = strchr(++field, '"');
+
+		if (end == NULL)
+			return NULL;
+	}
+	else
+	{
+		for (end = field; *end != '\0' && *end != ' ' && *end != '\t'; ++end);
+	}
+
+	*cursor = *end == '\0' ? end : end + 1;
+	*end = '\0';
+
+	return field;
+}
+
+static int CompareBatchJobSizes(const void* const a, const void* const b)
+{
+	const BatchJob* const job_a = *(const BatchJob* const*)a;
+	const BatchJob* const job_b = *(const BatchJob* const*)b;
+
+	if (job_a->input_size != job_b->input_size)
+		return job_a->input_size > job_b->input_size ? -1 : 1;
+
+	/* Keep the order of the manifest for jobs of the same size. */
+	return job_a->line < job_b->line ? -1 : job_a->line > job_b->line;
+}
+
+static cc_bool ParseManifest(Batch* const batch, char* const manifest)
+{
+	/* Each line is an option like '-c' or '-d', an input path, and an output path. */
+	/* Blank lines and lines which start with '#' are ignored. */
+	char *line, *next_line;
+	unsigned long line_number;
+	size_t total_lines;
+
+	total_lines = 1;
+
+	for (line = manifest; *line != '\0'; ++line)
+		if (*line == '\n')
+			++total_lines;
+
+	batch->jobs = (BatchJob*)malloc(total_lines * sizeof(BatchJob));
+	batch->order = (BatchJob**)malloc(total_lines * sizeof(BatchJob*));
+	batch->total_jobs = 0;
+
+	if (batch->jobs == NULL || batch->order == NULL)
+	{
+		fputs("Error: Could not allocate memory.\n", stderr);
+		return cc_false;
+	}
+
+	for (line = manifest, line_number = 1; line != NULL; line = next_line, ++line_number)
+	{
+		char *cursor, *mode_field;
+		BatchJob *job;
+		size_t length;
+
+		next_line = strchr(line, '\n');
+
+		if (next_line != NULL)
+			*next_line++ = '\0';
+
+		/* Allow Windows line endings. */
+		length = strlen(line);
+
+		if (length != 0 && line[length - 1] == '\r')
+			line[length - 1] = '\0';
+
+		cursor = line;
+		mode_field = ReadManifestField(&cursor);
+
+		if (mode_field == NULL || mode_field[0] == '#')
+			continue;
+
+		job = &batch->jobs[batch->total_jobs];
+		job->line = line_number;
+		job->input_path = ReadManifestField(&cursor);
+		job->output_path = ReadManifestField(&cursor);
+		job->output_size = 0;
+		job->seconds = 0.0;
+		job->cached = cc_false;
+		job->error = NULL;
+
+		if (!ParseMode(mode_field, &job->mode))
+		{
+			fprintf(stderr, "Error: Unrecognised option '%s' on line %lu of the manifest.\n", mode_field, line_number);
+			return cc_false;
+		}
+		else if (job->output_path == NULL || ReadManifestField(&cursor) != NULL)
+		{
+			fprintf(stderr, "Error: Line %lu of the manifest is not an option, an input, and an output.\n", line_number);
+			return cc_false;
+		}
+		else
+		{
+			/* Inputs which cannot be opened are left for the job itself to report. */
+			FILE* const input_file = fopen(job->input_path, "rb");
+			long input_size;
+
+			job->input_size = 0;
+
+			if (input_file != NULL)
+			{
+				if (fseek(input_file, 0, SEEK_END) == 0 && (input_size = ftell(input_file)) > 0)
+					job->input_size = (unsigned long)input_size;
+
+				fclose(input_file);
+			}
+		}
+
+		batch->order[batch->total_jobs] = job;
+		++batch->total_jobs;
+	}
+
+	qsort(batch->order, batch->total_jobs, sizeof(BatchJob*), CompareBatchJobSizes);
+
+	return cc_true;
+}
+
+static void ReadBatchJob(BatchJob* const job)
+{
+	if (!OpenInputFile(job->input_path, &job->input))
+	{
+		job->error = "Could not read input file.";
+	}
+	else if (job->input.mapped)
+	{
+		/* A mapped file is only read from the disk as each page is first used, so they are all used here, */
+		/* so that compressing it does not wait for the disk. */
+		volatile unsigned char byte;
+		size_t i;
+
+		for (i = 0; i < job->input.buffer.size; i += 0x1000)
+			byte = job->input.buffer.bytes[i];
+
+		(void)byte;
+	}
+}
+
+static void CompressBatchJob(ClownNemesis_Compressor* const compressor, Cache* const cache, BatchJob* const job)
+{
+	const double start_time = CurrentSeconds();
+
+	job->output.bytes = NULL;
+	job->output.size = job->output.capacity = job->output.position = 0;
+
+	if (job->error != NULL)
+		return;
+
+	if (compressor == NULL && job->mode.compress)
+		job->error = "Could not create compressor.";
+	else if (RunMode(compressor, cache, &job->mode, 1, &job->input.buffer, &job->output, &job->cached) != 1)
+		job->error = ModeErrorMessage(&job->mode);
+
+	CloseInputFile(&job->input);
+	job->seconds = CurrentSeconds() - start_time;
+}
+
+static void WriteBatchJob(BatchJob* const job)
+{
+	if (job->error == NULL)
+	{
+		if (!WriteWholeFile(job->output_path, NULL, 0, job->output.bytes, job->output.size))
+			job->error = "Could not write output file.";
+		else
+			job->output_size = (unsigned long)job->output.size;
+	}
+
+	free(job->output.bytes);
+	job->output.bytes = NULL;
+}
+
+static void RunBatchSerially(Batch* const batch)
+{
+	ClownNemesis_Compressor* const compressor = ClownNemesis_CompressorCreate();
+	size_t i;
+
+	for (i = 0; i < batch->total_jobs; ++i)
+	{
+		ReadBatchJob(batch->order[i]);
+		CompressBatchJob(compressor, batch->cache, batch->order[i]);
+		WriteBatchJob(batch->order[i]);
+	}
+
+	ClownNemesis_CompressorDestroy(compressor);
+}
+
+#ifdef CLOWNNEMESIS_THREADS
+static cc_bool InitialiseBatchQueue(BatchQueue* const queue, const size_t capacity)
+{
+	queue->jobs = (BatchJob**)malloc(capacity * sizeof(BatchJob*));
+	queue->first = queue->total = 0;
+	queue->capacity = capacity;
+	queue->ended = cc_false;
+
+	if (queue->jobs != NULL)
+	{
+		if (InitialiseMutex(&queue->mutex))
+		{
+			if (InitialiseCondition(&queue->changed))
+				return cc_true;
+
+			DeinitialiseMutex(&queue->mutex);
+		}
+
+		free(queue->jobs);
+	}
+
+	return cc_false;
+}
+
+static void DeinitialiseBatchQueue(BatchQueue* const queue)
+{
+	DeinitialiseCondition(&queue->changed);
+	DeinitialiseMutex(&queue->mutex);
+	free(queue->jobs);
+}
+
+static void PushBatchQueue(BatchQueue* const queue, BatchJob* const job)
+{
+	LockMutex(&queue->mutex);
+
+	while (queue->total == queue->capacity)
+		WaitForCondition(&queue->changed, &queue->mutex);
+
+	queue->jobs[(queue->first + queue->total) % queue->capacity] = job;
+	++queue->total;
+	SignalCondition(&queue->changed);
+
+	UnlockMutex(&queue->mutex);
+}
+
+static BatchJob* PopBatchQueue(BatchQueue* const queue)
+{
+	/* Returns NULL once the queue is empty and has been ended. */
+	BatchJob *job;
+
+	LockMutex(&queue->mutex);
+
+	while (queue->total == 0 && !queue->ended)
+		WaitForCondition(&queue->changed, &queue->mutex);
+
+	job = NULL;
+
+	if (queue->total != 0)
+	{
+		job = queue->jobs[queue->first];
+		queue->first = (queue->first + 1) % queue->capacity;
+		--queue->total;
+		SignalCondition(&queue->changed);
+	}
+
+	UnlockMutex(&queue->mutex);
+
+	return job;
+}
+
+static void EndBatchQueue(BatchQueue* const queue)
+{
+	LockMutex(&queue->mutex);
+	queue->ended = cc_true;
+	SignalCondition(&queue->changed);
+	UnlockMutex(&queue->mutex);
+}
+
+static void RunBatchCompressThread(void* const user_data)
+{
+	Batch* const batch = (Batch*)user_data;
+	ClownNemesis_Compressor* const compressor = ClownNemesis_CompressorCreate();
+	BatchJob *job;
+
+	while ((job = PopBatchQueue(&batch->read_queue)) != NULL)
+	{
+		CompressBatchJob(compressor, batch->cache, job);
+		PushBatchQueue(&batch->write_queue, job);
+	}
+
+	ClownNemesis_CompressorDestroy(compressor);
+}
+
+static void RunBatchWriteThread(void* const user_data)
+{
+	Batch* const batch = (Batch*)user_data;
+	BatchJob *job;
+
+	while ((job = PopBatchQueue(&batch->write_queue)) != NULL)
+		WriteBatchJob(job);
+}
+
+static unsigned int RunBatchPipeline(Batch* const batch, const unsigned int total_workers)
+{
+	/* The main thread reads the inputs, the workers compress them, and another thread writes the outputs, so that */
+	/* the disk and the processors are busy at the same time. The queues between the stages are bounded, so that only */
+	/* a few files are in memory at once. Returns how many workers were used, or 0 if the pipeline could not be started. */
+	Thread threads[MAXIMUM_BATCH_WORKERS], write_thread;
+	unsigned int total_threads;
+	size_t i;
+
+	total_threads = 0;
+
+	if (InitialiseBatchQueue(&batch->read_queue, total_workers * BATCH_JOBS_PER_WORKER))
+	{
+		if (InitialiseBatchQueue(&batch->write_queue, total_workers * BATCH_JOBS_PER_WORKER))
+		{
+			if (StartThread(&write_thread, RunBatchWriteThread, batch))
+			{
+				for (total_threads = 0; total_threads < total_workers; ++total_threads)
+					if (!StartThread(&threads[total_threads], RunBatchCompressThread, batch))
+						break;
+
+				if (total_threads != 0)
+				{
+					for (i = 0; i < batch->total_jobs; ++i)
+					{
+						ReadBatchJob(batch->order[i]);
+						PushBatchQueue(&batch->read_queue, batch->order[i]);
+					}
+				}
+
+				EndBatchQueue(&batch->read_queue);
+
+				for (i = 0; i < total_threads; ++i)
+					JoinThread(&threads[i]);
+
+				EndBatchQueue(&batch->write_queue);
+				JoinThread(&write_thread);
+			}
+
+			DeinitialiseBatchQueue(&batch->write_queue);
+		}
+
+		DeinitialiseBatchQueue(&batch->read_queue);
+	}
+
+	return total_threads;
+}
+#endif
+
+static int RunBatch(const char* const manifest_path, const char* const total_workers_string)
+{
+	int exit_code;
+	char *manifest;
+	Batch batch;
+	Cache cache;
+
+	exit_code = EXIT_FAILURE;
+	batch.jobs = NULL;
+	batch.order = NULL;
+	manifest = ReadWholeFile(manifest_path, NULL);
+
+	if (manifest == NULL)
+	{
+		fputs("Error: Could not read manifest file.\n", stderr);
+	}
+	else if (ParseManifest(&batch, manifest))
+	{
+		unsigned int total_workers, total_failures;
+		double start_time;
+		size_t i;
+
+		total_workers = total_workers_string != NULL ? (unsigned int)strtoul(total_workers_string, NULL, 0) : CountProcessors();
+		total_workers = CC_CLAMP(1, MAXIMUM_BATCH_WORKERS, total_workers);
+		total_workers = (unsigned int)CC_MIN(total_workers, CC_MAX(1, batch.total_jobs));
+
+		batch.cache = OpenCache(&cache) ? &cache : NULL;
+		start_time = CurrentSeconds();
+
+	#ifdef CLOWNNEMESIS_THREADS
+		total_workers = RunBatchPipeline(&batch, total_workers);
+	#else
+		total_workers = 0;
+	#endif
+
+		/* Otherwise, the main thread does every stage of each job by itself. */
+		if (total_workers == 0)
+		{
+			RunBatchSerially(&batch);
+			total_workers = 1;
+		}
+
+		/* Report the jobs in the order of the manifest, regardless of the order that they were done in. */
+		total_failures = 0;
+
+		for (i = 0; i < batch.total_jobs; ++i)
+		{
+			const BatchJob* const job = &batch.jobs[i];
+
+			if (job->error != NULL)
+			{
+				fprintf(stderr, "Error: %s (line %lu): %s\n", job->input_path, job->line, job->error);
+				++total_failures;
+			}
+			else
+			{
+				fprintf(stdout, "%s -> %s: %lu bytes to %lu bytes in %.3fs%s\n", job->input_path, job->output_path, job->input_size, job->output_size, job->seconds, job->cached ? " (cached)" : "");
+			}
+		}
+
+		fprintf(stdout, "%lu files, %u failed, in %.3fs with %u workers.\n", (unsigned long)batch.total_jobs, total_failures, CurrentSeconds() - start_time, total_workers);
+
+		if (batch.cache != NULL)
+			fprintf(stdout, "Cache: %lu hits, %lu misses.\n", cache.hits, cache.misses);
+
+		if (total_failures == 0)
+			exit_code = EXIT_SUCCESS;
+
+		if (batch.cache != NULL)
+			CloseCache(batch.cache);
+	}
+
+	free(batch.jobs);
+	free(batch.order);
+	free(manifest);
+
+	return exit_code;
+}
+
+#undef BATCH_JOBS_PER_WORKER
+#undef MAXIMUM_BATCH_WORKERS
+
+/****************/
+/* End of Batch */
+/****************/
+
+/**********/
+/* Worker */
+/**********/
+
+/* A worker stays running to handle many requests, so that a build system does not start a process for each file. */
+/* Every number is big-endian. A request is: */
+/* - A 4-byte ID, which the response repeats, as responses may be sent in a different order with several workers. */
+/* - A 1-byte length, followed by an option like those on the command line, such as '-c' or '-d'. */
+/* - A 4-byte length, followed by the data. */
+/* A response is: */
+/* - The request's 4-byte ID. */
+/* - A 1-byte status, which is 0 on success or 1 on failure. */
+/* - A 4-byte length, followed by the resulting data on success or an error message on failure. */
+/* The worker exits once its input ends. */
+
+/* The most threads that a worker can use, and how many requests can wait for each of them. */
+#define MAXIMUM_WORKER_THREADS 64
+#define WORKER_REQUESTS_PER_THREAD 2
+
+typedef struct WorkerRequest
+{
+	struct WorkerRequest *next;
+	unsigned long id;
+	Mode mode;
+	cc_bool mode_recognised;
+	/* The bytes are NULL if there was not enough memory for the data. */
+	MemoryBuffer data;
+} WorkerRequest;
+
+typedef struct Worker
+{
+	cc_bool output_failed;
+	Mutex output_mutex;
+	/* NULL if the cache is not being used. */
+	Cache *cache;
+#ifdef CLOWNNEMESIS_THREADS
+	/* Requests which have been read but not yet handled, oldest first. */
+	WorkerRequest *first_request, *last_request;
+	size_t total_requests, maximum_requests;
+	cc_bool input_ended;
+	Mutex requests_mutex;
+	Condition requests_changed;
+#endif
+} Worker;
+
+static cc_bool ReadWorkerNumber(const unsigned int total_bytes, unsigned long* const value)
+{
+	unsigned int i;
+
+	*value = 0;
+
+	for (i = 0; i < total_bytes; ++i)
+	{
+		const int byte = fgetc(stdin);
+
+		if (byte == EOF)
+			return cc_false;
 
-#include "clowncommon/clowncommon.h"
+		*value = *value << 8 | byte;
+	}
 
-#include "compress.h"
-#include "decompress.h"
+	return cc_true;
+}
 
-static int InputCallback(void* const user_data)
+static cc_bool WriteWorkerNumber(const unsigned int total_bytes, const unsigned long value)
 {
-	FILE* const file = (FILE*)user_data;
-	const int character = fgetc(file);
+	unsigned int i;
 
-	if (character == EOF)
+	for (i = total_bytes; i-- != 0; )
+		if (fputc((value >> (i * 8)) & 0xFF, stdout) == EOF)
+			return cc_false;
+
+	return cc_true;
+}
+
+static WorkerRequest* ReadWorkerRequest(cc_bool* const failed)
+{
+	/* Returns NULL once the input ends, or if it is not a request, in which case 'failed' is set. */
+	WorkerRequest *request;
+	char option[0x100];
+	unsigned long option_length, data_size, i;
+
+	if (!ReadWorkerNumber(4, &i))
+		return NULL;
+
+	request = (WorkerRequest*)malloc(sizeof(WorkerRequest));
+
+	if (request == NULL)
 	{
-		if (ferror(file))
-			return CLOWNNEMESIS_ERROR;
+		fputs("Error: Could not allocate memory.\n", stderr);
+		*failed = cc_true;
+		return NULL;
+	}
 
-		rewind(file);
-		return CLOWNNEMESIS_EOF;
+	request->next = NULL;
+	request->id = i;
+
+	if (!ReadWorkerNumber(1, &option_length) || fread(option, 1, option_length, stdin) != option_length || !ReadWorkerNumber(4, &data_size))
+	{
+		fputs("Error: Request was cut off.\n", stderr);
+		free(request);
+		*failed = cc_true;
+		return NULL;
 	}
 
-	return character;
+	option[option_length] = '\0';
+	request->mode_recognised = ParseMode(option, &request->mode);
+
+	request->data.size = request->data.capacity = (size_t)data_size;
+	request->data.position = 0;
+	request->data.bytes = (unsigned char*)malloc(data_size == 0 ? 1 : (size_t)data_size);
+
+	if (request->data.bytes != NULL)
+	{
+		i = (unsigned long)fread(request->data.bytes, 1, (size_t)data_size, stdin);
+	}
+	else
+	{
+		/* The data cannot be stored, so it is skipped, so that the next request can still be read. */
+		for (i = 0; i < data_size; ++i)
+			if (fgetc(stdin) == EOF)
+				break;
+	}
+
+	if (i != data_size)
+	{
+		fputs("Error: Request was cut off.\n", stderr);
+		free(request->data.bytes);
+		free(request);
+		*failed = cc_true;
+		return NULL;
+	}
+
+	return request;
 }
 
-static int OutputCallback(void* const user_data, const unsigned char byte)
+static void HandleWorkerRequest(Worker* const worker, ClownNemesis_Compressor* const compressor, WorkerRequest* const request)
 {
-	const int return_value = fputc(byte, (FILE*)user_data);
+	const char *error;
+	MemoryBuffer output;
+	cc_bool cached;
 
-	return return_value == EOF ? CLOWNNEMESIS_ERROR : return_value;
+	output.bytes = NULL;
+	output.size = output.capacity = output.position = 0;
+	error = NULL;
+
+	if (!request->mode_recognised)
+		error = "Unrecognised option.";
+	else if (request->data.bytes == NULL)
+		error = "Could not allocate memory.";
+	else if (compressor == NULL && request->mode.compress)
+		error = "Could not create compressor.";
+
+	if (error == NULL && RunMode(compressor, worker->cache, &request->mode, 1, &request->data, &output, &cached) != 1)
+		error = ModeErrorMessage(&request->mode);
+
+	/* The whole response is written at once, so that responses from different threads do not get mixed together. */
+	LockMutex(&worker->output_mutex);
+
+	if (!WriteWorkerNumber(4, request->id)
+	 || !WriteWorkerNumber(1, error != NULL)
+	 || !WriteWorkerNumber(4, error != NULL ? strlen(error) : output.size)
+	 || (error != NULL ? fputs(error, stdout) == EOF : fwrite(output.bytes, 1, output.size, stdout) != output.size)
+	 || fflush(stdout) == EOF)
+		worker->output_failed = cc_true;
+
+	UnlockMutex(&worker->output_mutex);
+
+	free(output.bytes);
+	free(request->data.bytes);
+	free(request);
+}
+
+#ifdef CLOWNNEMESIS_THREADS
+static void RunWorkerThread(void* const user_data)
+{
+	Worker* const worker = (Worker*)user_data;
+	ClownNemesis_Compressor* const compressor = ClownNemesis_CompressorCreate();
+
+	for (;;)
+	{
+		WorkerRequest *request;
+
+		LockMutex(&worker->requests_mutex);
+
+		while (worker->first_request == NULL && !worker->input_ended)
+			WaitForCondition(&worker->requests_changed, &worker->requests_mutex);
+
+		request = worker->first_request;
+
+		if (request != NULL)
+		{
+			worker->first_request = request->next;
+			--worker->total_requests;
+			SignalCondition(&worker->requests_changed);
+		}
+
+		UnlockMutex(&worker->requests_mutex);
+
+		if (request == NULL)
+			break;
+
+		HandleWorkerRequest(worker, compressor, request);
+	}
+
+	ClownNemesis_CompressorDestroy(compressor);
+}
+#endif
+
+static int RunWorker(const char* const total_threads_string)
+{
+	Worker worker;
+	Cache cache;
+	unsigned int total_threads;
+	cc_bool requests_handled, input_failed;
+
+	UseBinaryStandardStreams();
+
+	total_threads = total_threads_string != NULL ? (unsigned int)strtoul(total_threads_string, NULL, 0) : 1;
+	total_threads = CC_CLAMP(1, MAXIMUM_WORKER_THREADS, total_threads);
+
+	worker.output_failed = cc_false;
+	requests_handled = input_failed = cc_false;
+
+	if (!InitialiseMutex(&worker.output_mutex))
+	{
+		fputs("Error: Could not create mutex.\n", stderr);
+		return EXIT_FAILURE;
+	}
+
+	worker.cache = OpenCache(&cache) ? &cache : NULL;
+
+#ifdef CLOWNNEMESIS_THREADS
+	worker.first_request = worker.last_request = NULL;
+	worker.total_requests = 0;
+	worker.maximum_requests = total_threads * WORKER_REQUESTS_PER_THREAD;
+	worker.input_ended = cc_false;
+
+	if (total_threads > 1 && InitialiseMutex(&worker.requests_mutex))
+	{
+		if (InitialiseCondition(&worker.requests_changed))
+		{
+			/* The main thread reads the requests, and the other threads handle them. */
+			Thread threads[MAXIMUM_WORKER_THREADS];
+			unsigned int i;
+
+			for (i = 0; i < total_threads; ++i)
+				if (!StartThread(&threads[i], RunWorkerThread, &worker))
+					break;
+
+			total_threads = i;
+
+			while (total_threads != 0)
+			{
+				WorkerRequest* const request = ReadWorkerRequest(&input_failed);
+
+				LockMutex(&worker.requests_mutex);
+
+				if (request == NULL)
+				{
+					requests_handled = worker.input_ended = cc_true;
+					SignalCondition(&worker.requests_changed);
+					UnlockMutex(&worker.requests_mutex);
+					break;
+				}
+
+				/* Don't read too far ahead of the threads, as each request holds all of its data. */
+				while (worker.total_requests == worker.maximum_requests)
+					WaitForCondition(&worker.requests_changed, &worker.requests_mutex);
+
+				if (worker.first_request == NULL)
+					worker.first_request = request;
+				else
+					worker.last_request->next = request;
+
+				worker.last_request = request;
+				++worker.total_requests;
+				SignalCondition(&worker.requests_changed);
+				UnlockMutex(&worker.requests_mutex);
+			}
+
+			for (i = 0; i < total_threads; ++i)
+				JoinThread(&threads[i]);
+
+			DeinitialiseCondition(&worker.requests_changed);
+		}
+
+		DeinitialiseMutex(&worker.requests_mutex);
+	}
+#endif
+
+	/* Otherwise, the main thread handles each request itself, as soon as it is read. */
+	if (!requests_handled)
+	{
+		ClownNemesis_Compressor* const compressor = ClownNemesis_CompressorCreate();
+		WorkerRequest *request;
+
+		while ((request = ReadWorkerRequest(&input_failed)) != NULL)
+			HandleWorkerRequest(&worker, compressor, request);
+
+		ClownNemesis_CompressorDestroy(compressor);
+	}
+
+	if (worker.cache != NULL)
+		CloseCache(worker.cache);
+
+	DeinitialiseMutex(&worker.output_mutex);
+
+	if (worker.output_failed)
+		fputs("Error: Could not write response.\n", stderr);
+
+	return input_failed || worker.output_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#undef WORKER_REQUESTS_PER_THREAD
+#undef MAXIMUM_WORKER_THREADS
+
+/*****************/
+/* End of Worker */
+/*****************/
+
+/**************/
+/* Containers */
+/**************/
+
+static cc_bool OpenContainerFile(const char* const file_path, InputFile* const file, ClownNemesis_Container* const container)
+{
+	/* The container is mapped rather than read, so that only the pages of the archives which are used are loaded. */
+	if (!OpenInputFile(file_path, file))
+	{
+		fputs("Error: Could not read container.\n", stderr);
+		return cc_false;
+	}
+
+	if (!ClownNemesis_ContainerOpen(container, file->buffer.bytes, file->buffer.size))
+	{
+		fputs("Error: The input is not a container.\n", stderr);
+		CloseInputFile(file);
+		return cc_false;
+	}
+
+	return cc_true;
+}
+
+static int PackContainer(const char* const container_path, char** const archive_paths, const int total_archives)
+{
+	int exit_code;
+	InputFile *inputs;
+	ClownNemesis_ContainerArchive *archives;
+	int total_opened;
+
+	exit_code = EXIT_FAILURE;
+	total_opened = 0;
+
+	inputs = (InputFile*)malloc((size_t)total_archives * sizeof(InputFile));
+	archives = (ClownNemesis_ContainerArchive*)malloc((size_t)total_archives * sizeof(ClownNemesis_ContainerArchive));
+
+	if (inputs == NULL || archives == NULL)
+	{
+		fputs("Error: Could not allocate memory.\n", stderr);
+	}
+	else
+	{
+		for (; total_opened < total_archives; ++total_opened)
+		{
+			if (!OpenInputFile(archive_paths[total_opened], &inputs[total_opened]))
+			{
+				fprintf(stderr, "Error: Could not read archive '%s'.\n", archive_paths[total_opened]);
+				break;
+			}
+
+			archives[total_opened].bytes = inputs[total_opened].buffer.bytes;
+			archives[total_opened].size = (unsigned long)inputs[total_opened].buffer.size;
+
+			if (archives[total_opened].size != inputs[total_opened].buffer.size)
+			{
+				fprintf(stderr, "Error: Archive '%s' is too large.\n", archive_paths[total_opened]);
+				CloseInputFile(&inputs[total_opened]);
+				break;
+			}
+		}
+
+		if (total_opened == total_archives)
+		{
+			MemoryBuffer output;
+
+			output.bytes = NULL;
+			output.size = output.capacity = output.position = 0;
+
+			if (!ClownNemesis_ContainerWrite(archives, (unsigned long)total_archives, MemoryOutputCallback, &output))
+				fputs("Error: Could not make container.\nEither an archive is not valid Nemesis data, or the container would be larger than 4GiB.\n", stderr);
+			else if (!WriteWholeFile(container_path, NULL, 0, output.bytes, output.size))
+				fputs("Error: Could not write container.\n", stderr);
+			else
+				exit_code = EXIT_SUCCESS;
+
+			free(output.bytes);
+		}
+
+		while (total_opened != 0)
+			CloseInputFile(&inputs[--total_opened]);
+	}
+
+	free(inputs);
+	free(archives);
+
+	return exit_code;
+}
+
+static int UnpackContainer(const char* const container_path, const char* const output_path)
+{
+	int exit_code;
+	InputFile file;
+	ClownNemesis_Container container;
+
+	exit_code = EXIT_FAILURE;
+
+	if (OpenContainerFile(container_path, &file, &container))
+	{
+		char* const archive_output_path = (char*)malloc(strlen(output_path) + 1 + 20 + 1);
+
+		if (archive_output_path == NULL)
+		{
+			fputs("Error: Could not allocate memory.\n", stderr);
+		}
+		else
+		{
+			unsigned long i;
+
+			exit_code = EXIT_SUCCESS;
+
+			/* Like '-cs', each archive goes in its own file, with its index appended to the output path. */
+			for (i = 0; i < container.total_archives && exit_code == EXIT_SUCCESS; ++i)
+			{
+				ClownNemesis_ContainerArchive archive;
+
+				exit_code = EXIT_FAILURE;
+				sprintf(archive_output_path, "%s.%lu", output_path, i);
+
+				if (!ClownNemesis_ContainerGetArchive(&container, i, &archive))
+					fprintf(stderr, "Error: Entry %lu of the container is invalid.\n", i);
+				else if (!ClownNemesis_ContainerVerifyArchive(&archive))
+					fprintf(stderr, "Error: Archive %lu of the container is corrupt.\n", i);
+				else if (!WriteWholeFile(archive_output_path, NULL, 0, archive.bytes, archive.size))
+					fprintf(stderr, "Error: Could not write output file '%s'.\n", archive_output_path);
+				else
+					exit_code = EXIT_SUCCESS;
+			}
+
+			free(archive_output_path);
+		}
+
+		CloseInputFile(&file);
+	}
+
+	return exit_code;
+}
+
+static int ListContainer(const char* const container_path)
+{
+	int exit_code;
+	InputFile file;
+	ClownNemesis_Container container;
+
+	exit_code = EXIT_FAILURE;
+
+	if (OpenContainerFile(container_path, &file, &container))
+	{
+		unsigned long i;
+
+		exit_code = EXIT_SUCCESS;
+
+		for (i = 0; i < container.total_archives; ++i)
+		{
+			ClownNemesis_ContainerArchive archive;
+
+			if (!ClownNemesis_ContainerGetArchive(&container, i, &archive))
+			{
+				fprintf(stderr, "Error: Entry %lu of the container is invalid.\n", i);
+				exit_code = EXIT_FAILURE;
+			}
+			else
+			{
+				const cc_bool corrupt = !ClownNemesis_ContainerVerifyArchive(&archive);
+
+				fprintf(stdout, "%lu: offset 0x%lX, %lu bytes, 0x%X tiles, CRC-32 %08lX%s\n", i, (unsigned long)(archive.bytes - file.buffer.bytes), archive.size, archive.total_tiles, archive.crc, corrupt ? " (corrupt)" : "");
+
+				if (corrupt)
+					exit_code = EXIT_FAILURE;
+			}
+		}
+
+		CloseInputFile(&file);
+	}
+
+	return exit_code;
+}
+
+static int DecompressFromContainer(const char* const container_path, const char* const index_string, const char* const output_path)
+{
+	int exit_code;
+	InputFile file;
+	ClownNemesis_Container container;
+
+	exit_code = EXIT_FAILURE;
+
+	if (OpenContainerFile(container_path, &file, &container))
+	{
+		ClownNemesis_ContainerArchive archive;
+		MemoryBuffer output;
+
+		output.bytes = NULL;
+		output.size = output.capacity = output.position = 0;
+
+		if (!ClownNemesis_ContainerGetArchive(&container, strtoul(index_string, NULL, 0), &archive))
+			fputs("Error: The container has no such archive.\n", stderr);
+		else if (!ClownNemesis_ContainerVerifyArchive(&archive))
+			fputs("Error: The archive is corrupt.\n", stderr);
+		else if (!ClownNemesis_ContainerDecompress(&archive, NULL, MemoryOutputCallback, &output))
+			fputs("Error: Could not decompress data.\n", stderr);
+		else if (IsStandardStream(output_path) ? (output.size != 0 && fwrite(output.bytes, 1, output.size, stdout) != output.size) || fflush(stdout) == EOF : !WriteWholeFile(output_path, NULL, 0, output.bytes, output.size))
+			fputs("Error: Could not write output file.\n", stderr);
+		else
+			exit_code = EXIT_SUCCESS;
+
+		free(output.bytes);
+		CloseInputFile(&file);
+	}
+
+	return exit_code;
 }
 
+/*********************/
+/* End of Containers */
+/*********************/
+
 int main(const int argc, char** const argv)
 {
 	int exit_code;
 
 	exit_code = EXIT_FAILURE;
 
-	if (argc < 4)
+	if (argc >= 4 && argv[1][0] == '-' && argv[1][1] == 't' && argv[1][2] == '\0')
+	{
+		exit_code = TrainCodeTable(argv[2], &argv[3], argc - 3);
+	}
+	else if (argc >= 3 && argv[1][0] == '-' && argv[1][1] == 'e' && argv[1][2] == '\0')
+	{
+		exit_code = EstimateCompressedSizes(argv[2]);
+	}
+	else if (argc >= 3 && argv[1][0] == '-' && argv[1][1] == 'd' && argv[1][2] == 't' && argv[1][3] == '\0')
+	{
+		exit_code = EstimateDecodeTimes(&argv[2], argc - 2);
+	}
+	else if (argc >= 6 && argv[1][0] == '-' && argv[1][1] == 'c' && argv[1][2] == 'b' && argv[1][3] == '\0')
+	{
+		exit_code = CompressBitmap(argv[2], argv[3], argv[4], argv[5]);
+	}
+	else if (argc >= 4 && argv[1][0] == '-' && argv[1][1] == 'c' && argv[1][2] == 's' && argv[1][3] == '\0')
+	{
+		exit_code = CompressSplit(argv[2], argv[3]);
+	}
+	else if (argc >= 2 && strcmp(argv[1], "--worker") == 0)
+	{
+		exit_code = RunWorker(argc >= 3 ? argv[2] : NULL);
+	}
+	else if (argc >= 3 && argv[1][0] == '-' && argv[1][1] == 'b' && argv[1][2] == '\0')
+	{
+		exit_code = RunBatch(argv[2], argc >= 4 ? argv[3] : NULL);
+	}
+	else if (argc >= 2 && strcmp(argv[1], "--cache-stats") == 0)
+	{
+		exit_code = PrintCacheStatistics();
+	}
+	else if (argc >= 4 && argv[1][0] == '-' && argv[1][1] == 'p' && argv[1][2] == '\0')
+	{
+		exit_code = PackContainer(argv[2], &argv[3], argc - 3);
+	}
+	else if (argc >= 4 && argv[1][0] == '-' && argv[1][1] == 'u' && argv[1][2] == '\0')
+	{
+		exit_code = UnpackContainer(argv[2], argv[3]);
+	}
+	else if (argc >= 3 && argv[1][0] == '-' && argv[1][1] == 'l' && argv[1][2] == '\0')
+	{
+		exit_code = ListContainer(argv[2]);
+	}
+	else if (argc >= 5 && argv[1][0] == '-' && argv[1][1] == 'd' && argv[1][2] == 'c' && argv[1][3] == '\0')
+	{
+		exit_code = DecompressFromContainer(argv[2], argv[3], argv[4]);
+	}
+	else if (argc < 4)
 	{
 		const char* const usage =
-			"clownnemesis v1.1.1, by Clownacy.\n"
+			"clownnemesis " VERSION ", by Clownacy.\n"
 			"This is a Nemesis compressor and decompressor, which can compress data\n"
 			"identically to Sega's original Nemesis compressor.\n"
 			"\n"
 			"Usage: %s options input output\n"
+			"The input or output can be - for standard input or output.\n";
+		const char* const option_usage =
 			"\n"
 			"Options:\n"
 			"  -c  - Compress (better, but not accurate to Sega's compressor)\n"
 			"  -ca - Compress (worse, but accurate to Sega's compressor)\n"
-			"  -d  - Decompress\n";
+			"  -cu - Compress (best, but slow and not accurate to Sega's compressor)\n"
+			"  -c0 to -c4 - Compress with an effort level from 0 (fastest) to 4 (best)\n"
+			"  -cf - Compress (like -c, but faster for Sega's decoder to decode)\n"
+			"  -d  - Decompress\n"
+			"  -r  - Recompress Nemesis data (like -c, but the input is already compressed)\n";
+		const char* const table_usage =
+			"\n"
+			"Shared code tables:\n"
+			"  %s -t table input...\n"
+			"    Make a code table for all of the inputs, and compare it to their own tables\n"
+			"  %s -ct table input output\n"
+			"    Compress using a code table (faster, but usually worse)\n";
+		const char* const other_usage =
+			"\n"
+			"Other:\n"
+			"  %s -e input\n"
+			"    Print the compressed size of the input with each option, without compressing\n"
+			"  %s -cs input output\n"
+			"    Compress into as many archives as is best, named output.0, output.1, etc.\n"
+			"  %s -dt input...\n"
+			"    Print roughly how long Sega's decoder would take to decode each input\n"
+			"  %s -cb width bits-per-pixel input output\n"
+			"    Compress a headerless bitmap of 4 or 8 bits per pixel, as 8x8 tiles\n";
+		const char* const batch_usage =
+			"\n"
+			"Batches:\n"
+			"  %s -b manifest [workers]\n"
+			"    Do every line of the manifest, which is an option (like -c or -d),\n"
+			"    an input, and an output, using a worker per processor by default\n"
+			"  %s --worker [threads]\n"
+			"    Handle requests from standard input until it ends (see the README)\n"
+			"  %s --cache-stats\n"
+			"    Print how much the cache in CLOWNNEMESIS_CACHE is used (see the README)\n";
+		const char* const container_usage =
+			"\n"
+			"Containers:\n"
+			"  %s -p container archive...\n"
+			"    Pack Nemesis archives into one container, with an index to find them\n"
+			"  %s -u container output\n"
+			"    Unpack every archive in the container, named output.0, output.1, etc.\n"
+			"  %s -l container\n"
+			"    List the archives in the container, and check them for corruption\n"
+			"  %s -dc container index output\n"
+			"    Decompress one archive from the container\n";
 
 		fprintf(stderr, usage, argv[0]);
+		fputs(option_usage, stderr);
+		fprintf(stderr, table_usage, argv[0], argv[0]);
+		fprintf(stderr, other_usage, argv[0], argv[0], argv[0], argv[0]);
+		fprintf(stderr, batch_usage, argv[0], argv[0], argv[0]);
+		fprintf(stderr, container_usage, argv[0], argv[0], argv[0], argv[0]);
 	}
 	else
 	{
-		cc_bool compress, accurate, unrecognised;
+		cc_bool use_table, unrecognised;
+		Mode mode;
+		ClownNemesis_CodeTable table;
+		Cache cache;
+		const char *input_path, *output_path;
 
-		unrecognised = cc_false;
+		use_table = unrecognised = cc_false;
+		input_path = argv[2];
+		output_path = argv[3];
 
-		if (argv[1][0] == '-' && argv[1][1] == 'c' && argv[1][2] == '\0')
-		{
-			compress = cc_true;
-			accurate = cc_false;
-		}
-		else if (argv[1][0] == '-' && argv[1][1] == 'c' && argv[1][2] == 'a' && argv[1][3] == '\0')
-		{
-			compress = cc_true;
-			accurate = cc_true;
-		}
-		else if (argv[1][0] == '-' && argv[1][1] == 'd' && argv[1][2] == '\0')
+		if (argv[1][0] == '-' && argv[1][1] == 'c' && argv[1][2] == 't' && argv[1][3] == '\0' && argc >= 5)
 		{
-			compress = cc_false;
-			accurate = cc_false;
+			use_table = cc_true;
+			input_path = argv[3];
+			output_path = argv[4];
 		}
-		else
+		else if (!ParseMode(argv[1], &mode))
 		{
 			unrecognised = cc_true;
 		}
 
+		if (IsStandardStream(input_path) || IsStandardStream(output_path))
+			UseBinaryStandardStreams();
+
 		if (unrecognised)
 		{
 			fprintf(stderr, "Error: Unrecognised option '%s'.\n", argv[1]);
-		}			
+		}
+		else if (use_table && !ReadCodeTable(argv[2], &table))
+		{
+			fputs("Error: Could not read code table file.\n", stderr);
+		}
+		else if (!use_table && (!IsStandardStream(input_path) || (mode.compress && !mode.recompress)))
+		{
+			/* The whole input is mapped or read into memory, as compression reads it more than once, and the cache hashes it. */
+			ClownNemesis_Compressor* const compressor = mode.compress ? ClownNemesis_CompressorCreate() : NULL;
+			const cc_bool use_cache = mode.compress && OpenCache(&cache);
+			unsigned long output_size;
+			cc_bool cached;
+			const char* const error = RunModeOnFile(compressor, use_cache ? &cache : NULL, &mode, input_path, output_path, &output_size, &cached);
+
+			if (error != NULL)
+				fprintf(stderr, "Error: %s\n", error);
+			else
+				exit_code = EXIT_SUCCESS;
+
+			ClownNemesis_CompressorDestroy(compressor);
+
+			if (use_cache)
+				CloseCache(&cache);
+		}
 		else
 		{
-			FILE *const input_file = fopen(argv[2], "rb");
+			/* Decompression and recompression only read the input once, so standard input is streamed with a fixed amount of memory. */
+			/* Compression with a code table reads the input twice, so it is still read into memory, but its output is streamed. */
+			const cc_bool stream_input = !use_table;
+			InputFile input;
 
-			if (input_file == NULL)
+			if (!stream_input && !OpenInputFile(input_path, &input))
 			{
-				fputs("Error: Could not open input file for reading.\n", stderr);
+				fputs("Error: Could not read input file.\n", stderr);
 			}
 			else
 			{
-				FILE *const output_file = fopen(argv[3], "wb");
+				FILE *const output_file = IsStandardStream(output_path) ? stdout : fopen(output_path, "wb");
 
 				if (output_file == NULL)
 				{
@@ -100,29 +3135,37 @@ int main(const int argc, char** const argv)
 				}
 				else
 				{
+					const ClownNemesis_InputCallback read_byte = stream_input ? InputCallback : MemoryInputCallback;
+					const void* const read_byte_user_data = stream_input ? (const void*)stdin : (const void*)&input.buffer;
 					int success;
 
-					if (compress)
-						success = ClownNemesis_Compress(accurate, InputCallback, input_file, OutputCallback, output_file);
+					if (use_table)
+						success = ClownNemesis_CompressWithTable(&table, read_byte, read_byte_user_data, OutputCallback, output_file);
+					else if (mode.recompress)
+						success = ClownNemesis_Recompress(&mode.options, read_byte, read_byte_user_data, OutputCallback, output_file);
 					else
-						success = ClownNemesis_Decompress(InputCallback, input_file, OutputCallback, output_file);
+						success = ClownNemesis_Decompress(read_byte, read_byte_user_data, OutputCallback, output_file);
 
 					if (!success)
 					{
-						if (compress)
-							fputs("Error: Could not compress data.\nThe input data is either too large or its size is not a multiple of 0x20 bytes.\n", stderr);
+						if (use_table)
+							fputs("Error: Could not compress data.\nThe input data is either too large or its size is not a multiple of 0x20 bytes, or the code table is invalid.\n", stderr);
 						else
-							fputs("Error: Could not decompress data. The input data is not valid Nemesis data.\n", stderr);
+							fprintf(stderr, "Error: %s\n", ModeErrorMessage(&mode));
 					}
 					else
 					{
 						exit_code = EXIT_SUCCESS;
 					}
 
-					fclose(output_file);
+					if (output_file != stdout)
+						fclose(output_file);
+					else if (fflush(stdout) == EOF)
+						exit_code = EXIT_FAILURE;
 				}
 
-				fclose(input_file);
+				if (!stream_input)
+					CloseInputFile(&input);
 			}
 		}
 	}